@@ -9,45 +9,75 @@
 \********************************************************************************************************/
 
 #include "Asteroid.h"
+#include "AsteroidKinematics.h"
+#include "ContactCache.h"
+#include "ConvexCollision.h"
+#include "NarrowphaseScratch.h"
 #include "Player.h"
 #include "CollidableTypes.h"
-#include "Shot.h"
+#include "CollisionDispatch.h"
 #include "Config.h"
 
 #include "Locus/Geometry/Geometry.h"
 #include "Locus/Geometry/Plane.h"
 #include "Locus/Geometry/Triangle.h"
 
-#include "Locus/Common/Random.h"
-
 #include "Locus/Rendering/RenderingState.h"
 
 namespace MPM
 {
 
+bool Asteroid::triangleAccurateCollisions = false;
+
 Asteroid::Asteroid()
    : Asteroid(0)
 {
 }
 
 Asteroid::Asteroid(int h)
-   : visible(false), lastCollision(nullptr), texture(nullptr), hitsLeft(h), hit(false)
+   : visible(false), texture(nullptr), hitsLeft(h), hit(false), fractureNode(nullptr), fractureScale(1.0f), kinematics(nullptr), kinematicsIndex(0),
+     reducedDetail(false), broadMargin(0.0f), syncDeferrable(false), numDeferredSyncs(0), numStepsSinceBroadUpdate(0), deferredTime(0.0), contactCache(nullptr)
 {
    collidableType = CollidableType_Asteroid;
 }
 
 Asteroid::Asteroid(const Asteroid& other)
    :
+   CollisionBody(),
    visible(other.visible),
-   lastCollision(other.lastCollision),
    texture(other.texture),
    hitsLeft(other.hitsLeft),
    hit(other.hit),
    hitLocation(other.hitLocation),
-   boundingVolumeHierarchy( std::make_unique<Locus::SphereTree_t>(*other.boundingVolumeHierarchy) )
+   boundingVolumeHierarchy(other.boundingVolumeHierarchy),
+   convexHull(other.convexHull),
+   modelFrame(other.modelFrame),
+   framePosition(other.framePosition),
+   meshSource(other.meshSource),
+   fractureNode(other.fractureNode),
+   fractureScale(other.fractureScale),
+   kinematics(nullptr),
+   kinematicsIndex(0),
+   reducedDetail(false),
+   broadMargin(0.0f),
+   syncDeferrable(false),
+   numDeferredSyncs(0),
+   numStepsSinceBroadUpdate(0),
+   deferredTime(0.0),
+   contactCache(nullptr)
 {
 }
 
+Asteroid::~Asteroid()
+{
+   DetachKinematics();
+
+   if (contactCache != nullptr)
+   {
+      contactCache->Remove(this);
+   }
+}
+
 Asteroid& Asteroid::operator=(const Asteroid& other)
 {
    if (this != &other)
@@ -58,11 +88,17 @@ Asteroid& Asteroid::operator=(const Asteroid& other)
       hit = other.hit;
       hitLocation = other.hitLocation;
 
-      boundingVolumeHierarchy = std::make_unique<Locus::SphereTree_t>(*other.boundingVolumeHierarchy);
+      boundingVolumeHierarchy = other.boundingVolumeHierarchy;
+      convexHull = other.convexHull;
+      modelFrame = other.modelFrame;
+      framePosition = other.framePosition;
+
+      meshSource = other.meshSource;
+
+      fractureNode = other.fractureNode;
+      fractureScale = other.fractureScale;
 
       visible = other.visible;
-      lastCollision = other.lastCollision;
-      lastCollisionTime = other.lastCollisionTime;
    }
 
    return *this;
@@ -78,11 +114,16 @@ int Asteroid::getHitsLeft()
    return hitsLeft;
 }
 
-const Locus::SphereTree_t& Asteroid::GetBoundingVolumeHierarchy() const
+const TriangleTree& Asteroid::GetBoundingVolumeHierarchy() const
 {
    return *boundingVolumeHierarchy;
 }
 
+const ModelFrame& Asteroid::GetModelFrame() const
+{
+   return modelFrame;
+}
+
 void Asteroid::SetTexture(Locus::Texture* texture)
 {
    this->texture = texture;
@@ -93,12 +134,50 @@ void Asteroid::GrabMesh(const Mesh& mesh)
    Mesh::CopyFrom(mesh);
 }
 
-void Asteroid::GrabMeshAndCollidable(const Asteroid& other)
+void Asteroid::ShareMeshAndCollidable(const std::shared_ptr<Asteroid>& other)
+{
+   meshSource = other;
+   CollisionBody::operator=(*other);
+
+   centroid = other->centroid;
+   maxDistanceToCenter = other->maxDistanceToCenter;
+
+   boundingVolumeHierarchy = other->boundingVolumeHierarchy;
+   convexHull = other->convexHull;
+   modelFrame = other->modelFrame;
+}
+
+Asteroid& Asteroid::GetMeshSource()
+{
+   return (meshSource != nullptr) ? *meshSource : *this;
+}
+
+const Asteroid& Asteroid::GetMeshSource() const
+{
+   return (meshSource != nullptr) ? *meshSource : *this;
+}
+
+bool Asteroid::SharesMesh() const
+{
+   return (meshSource != nullptr);
+}
+
+bool Asteroid::HasGPUVertexData() const
 {
-   GrabMesh(other);
-   Collidable::operator=(other);
+   return (gpuVertexData != nullptr);
+}
 
-   boundingVolumeHierarchy = std::make_unique<Locus::SphereTree_t>(*other.boundingVolumeHierarchy);
+void Asteroid::UpdateMaxDistanceToCenter()
+{
+   if (meshSource != nullptr)
+   {
+      //the mesh source is never scaled
+      maxDistanceToCenter = meshSource->maxDistanceToCenter * fractureScale;
+   }
+   else
+   {
+      Mesh::UpdateMaxDistanceToCenter();
+   }
 }
 
 //////////////////////////////////////Asteroid logic//////////////////////////////////////////
@@ -134,110 +213,312 @@ void Asteroid::negateZDirection()
 
 void Asteroid::UpdateBroadCollisionExtent()
 {
-   Collidable::UpdateBroadCollisionExtent(centroid, maxDistanceToCenter);
+   CollisionBody::UpdateBroadCollisionExtent(centroid, maxDistanceToCenter + broadMargin);
+
+   //every caller hands the new extent to the broadphase straight after
+   numStepsSinceBroadUpdate = 0;
+
+   UpdateModelFrame();
+}
+
+void Asteroid::UpdateModelFrame()
+{
+   modelFrame = ModelFrame(CurrentModelTransformation());
+   framePosition = Position();
 }
 
 void Asteroid::CreateBoundingVolumeHierarchy()
 {
-   boundingVolumeHierarchy = std::make_unique<Locus::SphereTree_t>(*this, 6);
+   boundingVolumeHierarchy = std::make_shared<TriangleTree>(*this, Bounding_Volume_Hierarchy_Depth);
+}
+
+void Asteroid::CreateBoundingVolumeHierarchy(const Asteroid& parent, const ModelFrame& parentFrame, const Locus::FVector3& cutPoint, const Locus::FVector3& cutNormal)
+{
+   if (NumFaces() < Min_Faces_For_Split_Tree)
+   {
+      CreateBoundingVolumeHierarchy();
+      return;
+   }
+
+   ModelFrame frame(CurrentModelTransformation());
+
+   Locus::FVector3 modelCutNormal = frame.SupportDirectionToModel(cutNormal);
+   Normalize(modelCutNormal);
+
+   float modelCutDistance = Dot(modelCutNormal, frame.ToModel(cutPoint));
+
+   boundingVolumeHierarchy = std::make_shared<TriangleTree>(*parent.boundingVolumeHierarchy, ModelFrame::Relative(parentFrame, frame),
+                                                            modelCutNormal, modelCutDistance, *this, Bounding_Volume_Hierarchy_Depth);
+}
+
+void Asteroid::CreateConvexHull()
+{
+   convexHull = std::make_shared<ConvexHull>(*this);
+}
+
+void Asteroid::SetTriangleAccurateCollisions(bool triangleAccurateCollisions)
+{
+   Asteroid::triangleAccurateCollisions = triangleAccurateCollisions;
+}
+
+void Asteroid::SetFractureNode(const FractureNode* fractureNode, float fractureScale)
+{
+   this->fractureNode = fractureNode;
+   this->fractureScale = fractureScale;
+}
+
+const FractureNode* Asteroid::GetFractureNode() const
+{
+   return fractureNode;
+}
+
+float Asteroid::GetFractureScale() const
+{
+   return fractureScale;
 }
 
 bool Asteroid::GetAsteroidIntersection(Asteroid& other,  Locus::Triangle3D_t& intersectingTriangle1, Locus::Triangle3D_t& intersectingTriangle2)
 {
-   std::unordered_set<std::size_t> thisIntersectionSet;
-   std::unordered_set<std::size_t> otherIntersectionSet;
+   return boundingVolumeHierarchy->GetIntersection(modelFrame, *other.boundingVolumeHierarchy, other.modelFrame,
+                                                   NarrowphaseScratch::ForThisThread(), intersectingTriangle1, intersectingTriangle2);
+}
 
-   boundingVolumeHierarchy->GetIntersection(*this, *other.boundingVolumeHierarchy, other, thisIntersectionSet, otherIntersectionSet);
+bool Asteroid::GetAsteroidContact(Asteroid& other, Locus::FVector3& collisionPoint, Locus::FVector3& collisionNormal)
+{
+   if (!triangleAccurateCollisions && convexHull->IsValid() && other.convexHull->IsValid())
+   {
+      ConvexContact contact;
 
-   if ((thisIntersectionSet.size() > 0) && (otherIntersectionSet.size() > 0))
+      if (GetConvexContact(*convexHull, modelFrame, *other.convexHull, other.modelFrame, NarrowphaseScratch::ForThisThread(), contact))
+      {
+         collisionPoint = contact.point;
+         collisionNormal = contact.normal;
+
+         return true;
+      }
+
+      return false;
+   }
+
+   Locus::Triangle3D_t intersectingTriangle1, intersectingTriangle2;
+
+   if ( GetAsteroidIntersection(other, intersectingTriangle1, intersectingTriangle2) )
    {
-      return GetResolvedCollision(other, CurrentModelTransformation(), other.CurrentModelTransformation(), thisIntersectionSet, otherIntersectionSet, intersectingTriangle1, intersectingTriangle2);
+      collisionPoint = Locus::Triangle3D_t::ComputeCentroid(intersectingTriangle1, intersectingTriangle2);
+      collisionNormal = NormVector(intersectingTriangle1.Normal());
+
+      return true;
    }
-   else
+
+   return false;
+}
+
+bool Asteroid::GetSphereContact(const Asteroid& other, Locus::FVector3& collisionPoint, Locus::FVector3& collisionNormal) const
+{
+   Locus::FVector3 between = other.centroid - centroid;
+
+   float distance = Norm(between);
+   float overlap = maxDistanceToCenter + other.maxDistanceToCenter - distance;
+
+   if ((overlap <= 0.0f) || (distance <= 0.0f))
    {
       return false;
    }
+
+   collisionNormal = between / distance;
+
+   //halfway through the overlap
+   collisionPoint = centroid + (maxDistanceToCenter - overlap / 2) * collisionNormal;
+
+   return true;
 }
 
 void Asteroid::ResolveCollision(Collidable& collidable)
 {
-   if (collidable.GetCollidableType() == CollidableType_Asteroid)
+   CollisionDispatch::Resolve(*this, static_cast<CollisionBody&>(collidable));
+}
+
+void Asteroid::ResolveCollision(Asteroid& otherAsteroid)
+{
+   if ((contactCache != nullptr) && contactCache->IsDebounced(this, &otherAsteroid))
    {
-      dynamic_cast<Asteroid&>(collidable).ResolveCollision(*this);
+      return;
    }
-   else if (collidable.GetCollidableType() == CollidableType_Shot)
+
+   Locus::FVector3 collisionPoint, impulseDirection;
+
+   bool inContact = false;
+
+   if (reducedDetail || otherAsteroid.reducedDetail)
    {
-      dynamic_cast<Shot&>(collidable).ResolveCollision(*this);
+      CatchUpWithKinematics();
+      otherAsteroid.CatchUpWithKinematics();
+
+      inContact = GetSphereContact(otherAsteroid, collisionPoint, impulseDirection);
    }
-   else if (collidable.GetCollidableType() == CollidableType_Player)
+   else
+   {
+      inContact = GetAsteroidContact(otherAsteroid, collisionPoint, impulseDirection);
+   }
+
+   if (inContact)
    {
-      dynamic_cast<Player&>(collidable).ResolveCollision(*this);
+      Locus::ResolveCollision(1.0f, BoundingSphere(), otherAsteroid.BoundingSphere(), collisionPoint, impulseDirection,
+                              motionProperties, otherAsteroid.motionProperties);
+
+      CommitMotionProperties();
+      otherAsteroid.CommitMotionProperties();
+
+      if (contactCache != nullptr)
+      {
+         contactCache->MarkResolved(this, &otherAsteroid);
+      }
    }
 }
 
-void Asteroid::ResolveCollision(Asteroid& otherAsteroid)
+bool Asteroid::WasHit() const
+{
+   return hit;
+}
+
+void Asteroid::RegisterHit(const Locus::FVector3& hitLocation)
+{
+   this->hitLocation = hitLocation;
+   hit = true;
+}
+
+void Asteroid::ClearHit()
+{
+   hit = false;
+}
+
+const Locus::FVector3& Asteroid::GetHitLocation() const
 {
-   std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+   return hitLocation;
+}
+
+void Asteroid::AttachKinematics(AsteroidKinematics& kinematics)
+{
+   DetachKinematics();
+
+   this->kinematics = &kinematics;
+   kinematicsIndex = kinematics.Add(this, Position(), motionProperties, GetMaxDistanceToCenter());
+}
 
-   if (lastCollision == &otherAsteroid)
+void Asteroid::DetachKinematics()
+{
+   if (kinematics != nullptr)
    {
-      std::chrono::high_resolution_clock::duration diff = now - lastCollisionTime;
-      if (std::chrono::duration_cast<std::chrono::milliseconds>(diff).count() < 500)
-      {
-         return;
-      }
+      kinematics->Remove(kinematicsIndex);
+      kinematics = nullptr;
    }
+}
 
-   if (otherAsteroid.lastCollision == this)
+void Asteroid::SetKinematicsIndex(std::size_t kinematicsIndex)
+{
+   this->kinematicsIndex = kinematicsIndex;
+}
+
+void Asteroid::SyncWithKinematics(double DT)
+{
+   if (kinematics != nullptr)
    {
-      std::chrono::high_resolution_clock::duration diff = now - otherAsteroid.lastCollisionTime;
-      if (std::chrono::duration_cast<std::chrono::milliseconds>(diff).count() < 500)
+      //the rotation axis and speed only change when the kinematics are committed to, which
+      //catches up first, so the steps put off add up to a single rotation
+      double rotationTime = deferredTime + DT;
+
+      Translate(kinematics->GetPosition(kinematicsIndex) - Position());
+
+      if (rotationTime > 0.0)
       {
-         return;
+         Rotate(kinematics->GetAngularDisplacement(kinematicsIndex, static_cast<float>(rotationTime)));
       }
+
+      motionProperties.direction = kinematics->GetDirection(kinematicsIndex);
    }
 
-   Locus::Triangle3D_t intersectingTriangle1, intersectingTriangle2;
+   numDeferredSyncs = 0;
+   deferredTime = 0.0;
+}
 
-   if ( GetAsteroidIntersection(otherAsteroid, intersectingTriangle1, intersectingTriangle2) )
-   {
-      Locus::FVector3 collisionPoint = Locus::Triangle3D_t::ComputeCentroid(intersectingTriangle1, intersectingTriangle2);
+void Asteroid::SetDetail(bool reducedDetail, float broadMargin)
+{
+   this->reducedDetail = reducedDetail;
+   this->broadMargin = (reducedDetail ? broadMargin : 0.0f);
+
+   syncDeferrable = reducedDetail;
+}
 
-      Locus::FVector3 impulseDirection = NormVector(intersectingTriangle1.Normal());
+bool Asteroid::IsReducedDetail() const
+{
+   return reducedDetail;
+}
 
-      Locus::ResolveCollision(1.0f, BoundingSphere(), otherAsteroid.BoundingSphere(), collisionPoint, impulseDirection,
-                              motionProperties, otherAsteroid.motionProperties);
+bool Asteroid::CanDeferSync() const
+{
+   return syncDeferrable;
+}
 
-      lastCollision = &otherAsteroid;
-      otherAsteroid.lastCollision = this;
+unsigned int Asteroid::GetNumStepsSinceBroadUpdate() const
+{
+   return numStepsSinceBroadUpdate;
+}
 
-      now = std::chrono::high_resolution_clock::now();
+void Asteroid::DeferSync(double DT)
+{
+   ++numDeferredSyncs;
+   ++numStepsSinceBroadUpdate;
+   deferredTime += DT;
+}
 
-      lastCollisionTime = now;
-      otherAsteroid.lastCollisionTime = now;
+void Asteroid::CatchUpWithKinematics()
+{
+   if (numDeferredSyncs > 0)
+   {
+      SyncWithKinematics(0.0);
+      UpdateModelFrame();
    }
 }
 
-bool Asteroid::WasHit() const
+Locus::FVector3 Asteroid::GetFrameLag() const
 {
-   return hit;
+   if (kinematics != nullptr)
+   {
+      return kinematics->GetPosition(kinematicsIndex) - framePosition;
+   }
+
+   return Locus::Vec3D::ZeroVector();
 }
 
-void Asteroid::RegisterHit(const Locus::FVector3& hitLocation)
+Locus::FVector3 Asteroid::GetInterpolationOffset(float alpha) const
 {
-   this->hitLocation = hitLocation;
-   hit = true;
+   if (kinematics != nullptr)
+   {
+      return kinematics->GetInterpolatedPosition(kinematicsIndex, alpha) - kinematics->GetPosition(kinematicsIndex);
+   }
+
+   return Locus::Vec3D::ZeroVector();
 }
 
-const Locus::FVector3& Asteroid::GetHitLocation() const
+void Asteroid::SetContactCache(ContactCache* contactCache)
 {
-   return hitLocation;
+   this->contactCache = contactCache;
+}
+
+ContactCache* Asteroid::GetContactCache() const
+{
+   return contactCache;
 }
 
-void Asteroid::tick(double DT)
+void Asteroid::CommitMotionProperties()
 {
-   Translate((motionProperties.speed * motionProperties.direction) * static_cast<float>(DT));
-   Rotate(motionProperties.angularSpeed * static_cast<float>(DT) * motionProperties.rotation);
+   if (kinematics != nullptr)
+   {
+      kinematics->SetMotionProperties(kinematicsIndex, motionProperties);
+   }
+
+   //the broad extent was only grown for the old motion
+   syncDeferrable = false;
 }
 
 }
\ No newline at end of file
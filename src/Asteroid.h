@@ -13,14 +13,18 @@
 #include "Locus/Math/Vectors.h"
 
 #include "Locus/Geometry/Moveable.h"
-#include "Locus/Geometry/Collidable.h"
 #include "Locus/Geometry/MotionProperties.h"
 #include "Locus/Geometry/TriangleFwd.h"
-#include "Locus/Geometry/BoundingVolumeHierarchy.h"
 
-#include "Locus/Rendering/Mesh.h"
+#include "CollisionBody.h"
+#include "ConvexHull.h"
+#include "InstancedMesh.h"
+#include "ModelFrame.h"
+#include "TriangleTree.h"
 
-#include <chrono>
+#include <memory>
+
+#include <cstddef>
 
 namespace Locus
 {
@@ -33,35 +37,92 @@ class Texture;
 namespace MPM
 {
 
-class Asteroid : public Locus::Mesh, public Locus::Collidable
+class AsteroidKinematics;
+class ContactCache;
+struct FractureNode;
+
+class Asteroid : public InstancedMesh, public CollisionBody
 {
 public:
+   static const unsigned int Bounding_Volume_Hierarchy_Depth = 6;
+
+   //a fragment with fewer faces than this has its tree built from scratch even when split
+   //off a parent with a tree, since sorting all of its triangles is quicker than sorting out
+   //which of the parent's subtrees to keep (see MPM_Headless --benchmark-split-trees)
+   static const std::size_t Min_Faces_For_Split_Tree = 128;
+
    Asteroid();
    Asteroid(int h);
    Asteroid(const Asteroid& other);
    Asteroid& operator=(const Asteroid& other);
+   ~Asteroid();
 
    Locus::Texture* GetTexture();
    int getHitsLeft();
 
-   const Locus::SphereTree_t& GetBoundingVolumeHierarchy() const;
+   const TriangleTree& GetBoundingVolumeHierarchy() const;
+
+   //the asteroid's model transformation as of its last UpdateBroadCollisionExtent, which
+   //is called after every time the asteroid moves. Collision queries share it
+   const ModelFrame& GetModelFrame() const;
 
    void SetTexture(Locus::Texture* texture);
 
    void GrabMesh(const Mesh& mesh);
-   void GrabMeshAndCollidable(const Asteroid& other);
+
+   //makes the asteroid a copy of other that draws and cuts with other's mesh and collides
+   //with other's sphere tree and convex hull rather than copies of them. other has to have
+   //a mesh of its own
+   void ShareMeshAndCollidable(const std::shared_ptr<Asteroid>& other);
+
+   //the asteroid whose mesh and GPU vertex data this one is drawn and cut with. Asteroids
+   //made from the fracture library share the library's piece, so only the fragments of
+   //asteroids cut at runtime have a mesh of their own. Those are their own mesh source
+   Asteroid& GetMeshSource();
+   const Asteroid& GetMeshSource() const;
+   bool SharesMesh() const;
+
+   bool HasGPUVertexData() const;
+
+   //hides Model::UpdateMaxDistanceToCenter so that an asteroid sharing its mesh takes the
+   //distance from the mesh source, scaled by its fracture scale
+   void UpdateMaxDistanceToCenter();
 
    virtual void UpdateBroadCollisionExtent();
 
    void CreateBoundingVolumeHierarchy();
 
+   //builds the tree of a fragment split off parent, whose model transformation was
+   //parentFrame, by the plane through cutPoint whose normal cutNormal points into this
+   //fragment (both in world space). The parts of parent's tree the cut doesn't cross are
+   //reused if the fragment has at least Min_Faces_For_Split_Tree faces
+   void CreateBoundingVolumeHierarchy(const Asteroid& parent, const ModelFrame& parentFrame, const Locus::FVector3& cutPoint, const Locus::FVector3& cutNormal);
+   void CreateConvexHull();
+
    bool GetAsteroidIntersection(Asteroid& other, Locus::Triangle3D_t& intersectingTriangle1, Locus::Triangle3D_t& intersectingTriangle2);
 
+   //finds where the asteroids collide and the direction from this one into other, by
+   //GJK and EPA on their convex hulls. With triangle accurate collisions, or if either
+   //asteroid is too flat for a hull, it is found from their intersecting triangles instead
+   bool GetAsteroidContact(Asteroid& other, Locus::FVector3& collisionPoint, Locus::FVector3& collisionNormal);
+
+   //finds where the asteroids' bounding spheres overlap and the direction from this one into other
+   bool GetSphereContact(const Asteroid& other, Locus::FVector3& collisionPoint, Locus::FVector3& collisionNormal) const;
+
+   static void SetTriangleAccurateCollisions(bool triangleAccurateCollisions);
+
+   //the piece of the fracture library the asteroid's mesh was copied from, if any, and
+   //the uniform scale it is drawn at. Its halves are copied from the library when it splits
+   void SetFractureNode(const FractureNode* fractureNode, float fractureScale);
+   const FractureNode* GetFractureNode() const;
+   float GetFractureScale() const;
+
    virtual void ResolveCollision(Collidable& collidable) override;
    void ResolveCollision(Asteroid& otherAsteroid);
 
    bool WasHit() const;
    void RegisterHit(const Locus::FVector3& hitLocation);
+   void ClearHit();
    const Locus::FVector3& GetHitLocation() const;
 
    void decreaseHitsLeft();
@@ -70,16 +131,55 @@ public:
    void negateYDirection();
    void negateZDirection();
 
-   void tick(double DT);
+   //while attached, the asteroid's motion is worked out by the AsteroidKinematics
+   //and the asteroid pulls its transformation from it with SyncWithKinematics.
+   //motionProperties changed by a collision response have to be committed back
+   void AttachKinematics(AsteroidKinematics& kinematics);
+   void DetachKinematics();
+   void SetKinematicsIndex(std::size_t kinematicsIndex);
+   void SyncWithKinematics(double DT);
+   void CommitMotionProperties();
+
+   //simulation level of detail. At reduced detail the asteroid may put off syncing with its
+   //kinematics for a few steps, its broad extent is grown by broadMargin to cover where it can
+   //get to in the meantime, and it collides with other asteroids as a sphere
+   void SetDetail(bool reducedDetail, float broadMargin);
+   bool IsReducedDetail() const;
+
+   //whether the asteroid can put off syncing this step: it is at reduced detail and no
+   //collision has changed its motion since it was last synced
+   bool CanDeferSync() const;
+
+   //the syncs put off since the broad extent was last updated. CatchUpWithKinematics
+   //doesn't reset it, since the extent in the broadphase stays the same
+   unsigned int GetNumStepsSinceBroadUpdate() const;
+
+   //puts off syncing with the kinematics for this step. The next sync catches up on the
+   //rotation that was skipped
+   void DeferSync(double DT);
+
+   //syncs the transformation and model frame with the kinematics if any syncs were put off.
+   //The broad extent is left as it is. Anything that reads the asteroid's transformation
+   //outside of TickAsteroids calls this first
+   void CatchUpWithKinematics();
+
+   //how far the kinematics have moved the asteroid since its model frame was last updated.
+   //Only more than rounding error while it puts off syncs
+   Locus::FVector3 GetFrameLag() const;
+
+   //how far the asteroid is drawn from its current position when drawn alpha of the way
+   //between the previous simulation step and the current one
+   Locus::FVector3 GetInterpolationOffset(float alpha) const;
+
+   //collisions with other asteroids are debounced through the contact cache. The
+   //asteroid removes its contacts from the cache when it is destroyed
+   void SetContactCache(ContactCache* contactCache);
+   ContactCache* GetContactCache() const;
 
    bool visible;
 
    Locus::MotionProperties motionProperties;
 
-   //HACK: avoiding interpenetration
-   Locus::Collidable* lastCollision;
-   std::chrono::high_resolution_clock::time_point lastCollisionTime;
-
 private:
    Locus::Texture* texture;
    int hitsLeft;
@@ -87,7 +187,34 @@ private:
    bool hit;
    Locus::FVector3 hitLocation;
 
-   std::unique_ptr< Locus::SphereTree_t > boundingVolumeHierarchy;
+   //both are in model space and never change once made, so copies of the asteroid share
+   //them. A fragment cut off an asteroid gets new ones
+   std::shared_ptr< const TriangleTree > boundingVolumeHierarchy;
+   std::shared_ptr< const ConvexHull > convexHull;
+
+   ModelFrame modelFrame;
+   Locus::FVector3 framePosition;
+
+   static bool triangleAccurateCollisions;
+
+   std::shared_ptr<Asteroid> meshSource;
+
+   const FractureNode* fractureNode;
+   float fractureScale;
+
+   AsteroidKinematics* kinematics;
+   std::size_t kinematicsIndex;
+
+   bool reducedDetail;
+   float broadMargin;
+   bool syncDeferrable;
+   unsigned int numDeferredSyncs;
+   unsigned int numStepsSinceBroadUpdate;
+   double deferredTime;
+
+   ContactCache* contactCache;
+
+   void UpdateModelFrame();
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,421 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "AsteroidKinematics.h"
+#include "Asteroid.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <cassert>
+
+namespace MPM
+{
+
+static const double Never = std::numeric_limits<double>::infinity();
+
+//axes that reach the boundary within this long of each other bounce together
+static const double Simultaneous_Bounce_Time = 1e-6;
+
+//the queue is rebuilt once it holds this many times more events than there are asteroids
+static const std::size_t Max_Bounces_Per_Asteroid = 4;
+
+//how long after leaving origin with velocity it reaches the boundary on one axis
+static double TimeToBoundary(float origin, float velocity, float boundary)
+{
+   if (velocity > 0.0f)
+   {
+      return std::max(static_cast<double>(boundary - origin) / velocity, 0.0);
+   }
+
+   if (velocity < 0.0f)
+   {
+      return std::max(static_cast<double>(-boundary - origin) / velocity, 0.0);
+   }
+
+   return Never;
+}
+
+//a coordinate that went past the boundary, mirrored back inside. Asteroids bounce off
+//the boundary like that, so this gives where one was before its last bounce
+static float Reflect(float coordinate, float boundary)
+{
+   if (coordinate > boundary)
+   {
+      return 2 * boundary - coordinate;
+   }
+
+   if (coordinate < -boundary)
+   {
+      return -2 * boundary - coordinate;
+   }
+
+   return coordinate;
+}
+
+bool AsteroidKinematics::BounceEvent::operator>(const BounceEvent& other) const
+{
+   //ties are broken by index so bounces happen in the same order every run
+   return (time > other.time) || ((time == other.time) && (index > other.index));
+}
+
+AsteroidKinematics::AsteroidKinematics()
+   : time(0.0), lastDT(0.0), boundary(0.0f), numChangedLines(0)
+{
+}
+
+std::size_t AsteroidKinematics::Add(Asteroid* asteroid, const Locus::FVector3& position, const Locus::MotionProperties& motionProperties, float radius)
+{
+   ScheduleChangedLines();
+
+   asteroids.push_back(asteroid);
+
+   originX.push_back(position.x);
+   originY.push_back(position.y);
+   originZ.push_back(position.z);
+   originTime.push_back(time);
+
+   directionX.push_back(motionProperties.direction.x);
+   directionY.push_back(motionProperties.direction.y);
+   directionZ.push_back(motionProperties.direction.z);
+   speed.push_back(motionProperties.speed);
+
+   rotationX.push_back(motionProperties.rotation.x);
+   rotationY.push_back(motionProperties.rotation.y);
+   rotationZ.push_back(motionProperties.rotation.z);
+   angularSpeed.push_back(motionProperties.angularSpeed);
+
+   this->radius.push_back(radius);
+
+   nextBounceTime.push_back(Never);
+
+   lineChanged.push_back(0);
+   changedLines.resize(asteroids.size());
+
+   std::size_t index = asteroids.size() - 1;
+
+   ScheduleBounce(index);
+
+   return index;
+}
+
+void AsteroidKinematics::Remove(std::size_t index)
+{
+   //swap and pop. The asteroid moved into the vacated slot is told its new index, and
+   //its bounce is queued again under it
+
+   assert(index < asteroids.size());
+
+   //the changed lines are listed by index, which is about to change
+   ScheduleChangedLines();
+
+   std::size_t lastIndex = asteroids.size() - 1;
+
+   if (index != lastIndex)
+   {
+      asteroids[index] = asteroids[lastIndex];
+
+      originX[index] = originX[lastIndex];
+      originY[index] = originY[lastIndex];
+      originZ[index] = originZ[lastIndex];
+      originTime[index] = originTime[lastIndex];
+
+      directionX[index] = directionX[lastIndex];
+      directionY[index] = directionY[lastIndex];
+      directionZ[index] = directionZ[lastIndex];
+      speed[index] = speed[lastIndex];
+
+      rotationX[index] = rotationX[lastIndex];
+      rotationY[index] = rotationY[lastIndex];
+      rotationZ[index] = rotationZ[lastIndex];
+      angularSpeed[index] = angularSpeed[lastIndex];
+
+      radius[index] = radius[lastIndex];
+
+      ScheduleBounce(index);
+
+      asteroids[index]->SetKinematicsIndex(index);
+   }
+
+   asteroids.pop_back();
+
+   originX.pop_back();
+   originY.pop_back();
+   originZ.pop_back();
+   originTime.pop_back();
+
+   directionX.pop_back();
+   directionY.pop_back();
+   directionZ.pop_back();
+   speed.pop_back();
+
+   rotationX.pop_back();
+   rotationY.pop_back();
+   rotationZ.pop_back();
+   angularSpeed.pop_back();
+
+   radius.pop_back();
+
+   nextBounceTime.pop_back();
+
+   lineChanged.pop_back();
+   changedLines.pop_back();
+}
+
+void AsteroidKinematics::Clear()
+{
+   while (!asteroids.empty())
+   {
+      asteroids.back()->DetachKinematics();
+   }
+
+   bounces = decltype(bounces)();
+   numChangedLines = 0;
+}
+
+void AsteroidKinematics::Reserve(std::size_t capacity)
+{
+   asteroids.reserve(capacity);
+
+   originX.reserve(capacity);
+   originY.reserve(capacity);
+   originZ.reserve(capacity);
+   originTime.reserve(capacity);
+
+   directionX.reserve(capacity);
+   directionY.reserve(capacity);
+   directionZ.reserve(capacity);
+   speed.reserve(capacity);
+
+   rotationX.reserve(capacity);
+   rotationY.reserve(capacity);
+   rotationZ.reserve(capacity);
+   angularSpeed.reserve(capacity);
+
+   radius.reserve(capacity);
+
+   nextBounceTime.reserve(capacity);
+
+   lineChanged.reserve(capacity);
+   changedLines.reserve(capacity);
+}
+
+std::size_t AsteroidKinematics::Size() const
+{
+   return asteroids.size();
+}
+
+void AsteroidKinematics::SetBoundary(float boundary)
+{
+   assert(asteroids.empty());
+
+   this->boundary = boundary;
+}
+
+Asteroid* AsteroidKinematics::GetAsteroid(std::size_t index) const
+{
+   return asteroids[index];
+}
+
+Locus::FVector3 AsteroidKinematics::PositionAt(std::size_t index, double atTime) const
+{
+   float elapsed = static_cast<float>(atTime - originTime[index]);
+
+   return Locus::FVector3(originX[index] + (directionX[index] * speed[index]) * elapsed,
+                          originY[index] + (directionY[index] * speed[index]) * elapsed,
+                          originZ[index] + (directionZ[index] * speed[index]) * elapsed);
+}
+
+Locus::FVector3 AsteroidKinematics::GetPosition(std::size_t index) const
+{
+   return PositionAt(index, time);
+}
+
+Locus::FVector3 AsteroidKinematics::GetInterpolatedPosition(std::size_t index, float alpha) const
+{
+   //an asteroid that bounced since the time asked for was on the line reflected in the
+   //boundary then. Going back less than a step, it can only have bounced once on each axis
+   Locus::FVector3 position = PositionAt(index, time - (1.0f - alpha) * lastDT);
+
+   return Locus::FVector3(Reflect(position.x, boundary), Reflect(position.y, boundary), Reflect(position.z, boundary));
+}
+
+Locus::FVector3 AsteroidKinematics::GetDirection(std::size_t index) const
+{
+   return Locus::FVector3(directionX[index], directionY[index], directionZ[index]);
+}
+
+Locus::FVector3 AsteroidKinematics::GetAngularDisplacement(std::size_t index, float DT) const
+{
+   return (angularSpeed[index] * DT) * Locus::FVector3(rotationX[index], rotationY[index], rotationZ[index]);
+}
+
+float AsteroidKinematics::GetRadius(std::size_t index) const
+{
+   return radius[index];
+}
+
+void AsteroidKinematics::SetMotionProperties(std::size_t index, const Locus::MotionProperties& motionProperties)
+{
+   Locus::FVector3 position = GetPosition(index);
+
+   directionX[index] = motionProperties.direction.x;
+   directionY[index] = motionProperties.direction.y;
+   directionZ[index] = motionProperties.direction.z;
+   speed[index] = motionProperties.speed;
+
+   rotationX[index] = motionProperties.rotation.x;
+   rotationY[index] = motionProperties.rotation.y;
+   rotationZ[index] = motionProperties.rotation.z;
+   angularSpeed[index] = motionProperties.angularSpeed;
+
+   originX[index] = position.x;
+   originY[index] = position.y;
+   originZ[index] = position.z;
+   originTime[index] = time;
+
+   //a bounce queued for the old line no longer matches nextBounceTime, so it is dropped
+   UpdateNextBounceTime(index);
+
+   if (lineChanged[index] == 0)
+   {
+      lineChanged[index] = 1;
+      changedLines[numChangedLines.fetch_add(1, std::memory_order_relaxed)] = index;
+   }
+}
+
+void AsteroidKinematics::SetRadius(std::size_t index, float radius)
+{
+   this->radius[index] = radius;
+}
+
+void AsteroidKinematics::Advance(double DT)
+{
+   ScheduleChangedLines();
+
+   time += DT;
+   lastDT = DT;
+
+   while (!bounces.empty() && (bounces.top().time <= time))
+   {
+      BounceEvent bounce = bounces.top();
+      bounces.pop();
+
+      if ((bounce.index < asteroids.size()) && (nextBounceTime[bounce.index] == bounce.time))
+      {
+         Bounce(bounce.index, bounce.time);
+      }
+   }
+
+   if (bounces.size() > Max_Bounces_Per_Asteroid * asteroids.size() + Max_Bounces_Per_Asteroid)
+   {
+      CompactBounces();
+   }
+}
+
+void AsteroidKinematics::StartLine(std::size_t index, const Locus::FVector3& position, double startTime)
+{
+   originX[index] = position.x;
+   originY[index] = position.y;
+   originZ[index] = position.z;
+   originTime[index] = startTime;
+
+   ScheduleBounce(index);
+}
+
+void AsteroidKinematics::Bounce(std::size_t index, double bounceTime)
+{
+   //negates the direction on each axis on which the asteroid reaches the boundary, and
+   //starts it on the reflected line from the point where it does
+
+   double elapsed = bounceTime - originTime[index];
+
+   Locus::FVector3 position = PositionAt(index, bounceTime);
+
+   float* origin[3] = { &originX[index], &originY[index], &originZ[index] };
+   float* direction[3] = { &directionX[index], &directionY[index], &directionZ[index] };
+   float* coordinate[3] = { &position.x, &position.y, &position.z };
+
+   for (int axis = 0; axis < 3; ++axis)
+   {
+      float velocity = *direction[axis] * speed[index];
+
+      if (TimeToBoundary(*origin[axis], velocity, boundary) <= elapsed + Simultaneous_Bounce_Time)
+      {
+         *coordinate[axis] = (velocity > 0.0f) ? boundary : -boundary;
+         *direction[axis] = -*direction[axis];
+      }
+   }
+
+   StartLine(index, position, bounceTime);
+}
+
+void AsteroidKinematics::UpdateNextBounceTime(std::size_t index)
+{
+   float velocityX = directionX[index] * speed[index];
+   float velocityY = directionY[index] * speed[index];
+   float velocityZ = directionZ[index] * speed[index];
+
+   double timeToBounce = std::min(std::min(TimeToBoundary(originX[index], velocityX, boundary),
+                                           TimeToBoundary(originY[index], velocityY, boundary)),
+                                  TimeToBoundary(originZ[index], velocityZ, boundary));
+
+   nextBounceTime[index] = originTime[index] + timeToBounce;
+}
+
+void AsteroidKinematics::ScheduleBounce(std::size_t index)
+{
+   UpdateNextBounceTime(index);
+
+   if (nextBounceTime[index] != Never)
+   {
+      bounces.push({ nextBounceTime[index], index });
+   }
+}
+
+void AsteroidKinematics::ScheduleChangedLines()
+{
+   //the worker threads that listed them were joined before this runs, so the list is
+   //complete. The order it was filled in doesn't matter, since the queue orders by time
+   //and then by index
+   std::size_t numChanged = numChangedLines.load(std::memory_order_relaxed);
+
+   for (std::size_t changedIndex = 0; changedIndex < numChanged; ++changedIndex)
+   {
+      std::size_t index = changedLines[changedIndex];
+
+      lineChanged[index] = 0;
+
+      if (nextBounceTime[index] != Never)
+      {
+         bounces.push({ nextBounceTime[index], index });
+      }
+   }
+
+   numChangedLines.store(0, std::memory_order_relaxed);
+}
+
+void AsteroidKinematics::CompactBounces()
+{
+   std::vector<BounceEvent> currentBounces;
+   currentBounces.reserve(asteroids.size());
+
+   for (std::size_t index = 0; index < asteroids.size(); ++index)
+   {
+      if (nextBounceTime[index] != Never)
+      {
+         currentBounces.push_back({ nextBounceTime[index], index });
+      }
+   }
+
+   bounces = decltype(bounces)(std::greater<BounceEvent>(), std::move(currentBounces));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include "Locus/Geometry/MotionProperties.h"
+
+#include <atomic>
+#include <vector>
+#include <queue>
+#include <functional>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+class Asteroid;
+
+//The motion state of all asteroids in play, kept as contiguous arrays (struct of arrays).
+//Asteroids move in straight lines between bounces off the game boundary, so each one is
+//kept as the line it is on (origin, direction and speed, and the time it left the origin)
+//and its position is only worked out when it is asked for. The next time each asteroid
+//reaches the boundary is kept in a queue, so advancing the clock only does work for the
+//asteroids that bounce
+class AsteroidKinematics
+{
+public:
+   AsteroidKinematics();
+
+   std::size_t Add(Asteroid* asteroid, const Locus::FVector3& position, const Locus::MotionProperties& motionProperties, float radius);
+   void Remove(std::size_t index);
+   void Clear();
+   void Reserve(std::size_t capacity);
+
+   std::size_t Size() const;
+
+   //asteroids bounce off the boundary of the cube [-boundary, boundary]^3. Set before
+   //asteroids are added
+   void SetBoundary(float boundary);
+
+   Asteroid* GetAsteroid(std::size_t index) const;
+
+   Locus::FVector3 GetPosition(std::size_t index) const;
+
+   //the position alpha of the way through the last step. An asteroid whose motion was
+   //changed since is taken to have been on its new line all along
+   Locus::FVector3 GetInterpolatedPosition(std::size_t index, float alpha) const;
+   Locus::FVector3 GetDirection(std::size_t index) const;
+   Locus::FVector3 GetAngularDisplacement(std::size_t index, float DT) const;
+   float GetRadius(std::size_t index) const;
+
+   //starts the asteroid on a new line from where it is now. Collision responses call this
+   //from worker threads, for different asteroids at a time, so it only writes the
+   //asteroid's own slot. Its next bounce is queued by whichever of Advance, Add or Remove
+   //comes next
+   void SetMotionProperties(std::size_t index, const Locus::MotionProperties& motionProperties);
+   void SetRadius(std::size_t index, float radius);
+
+   //moves the clock on by DT seconds, bouncing the asteroids that reach the boundary in
+   //the meantime. The time before is kept for GetInterpolatedPosition
+   void Advance(double DT);
+
+private:
+   struct BounceEvent
+   {
+      double time;
+      std::size_t index;
+
+      bool operator>(const BounceEvent& other) const;
+   };
+
+   double time;
+   double lastDT;
+
+   float boundary;
+
+   std::vector<Asteroid*> asteroids;
+
+   std::vector<float> originX;
+   std::vector<float> originY;
+   std::vector<float> originZ;
+   std::vector<double> originTime;
+
+   std::vector<float> directionX;
+   std::vector<float> directionY;
+   std::vector<float> directionZ;
+   std::vector<float> speed;
+
+   std::vector<float> rotationX;
+   std::vector<float> rotationY;
+   std::vector<float> rotationZ;
+   std::vector<float> angularSpeed;
+
+   std::vector<float> radius;
+
+   //an event is only current if the time is still the asteroid's next bounce time. Ones
+   //that aren't (the asteroid was removed, moved to another index or set on a new line)
+   //are dropped when they come up
+   std::vector<double> nextBounceTime;
+   std::priority_queue<BounceEvent, std::vector<BounceEvent>, std::greater<BounceEvent>> bounces;
+
+   //the asteroids set on a new line whose bounce isn't queued yet. The first
+   //numChangedLines entries of changedLines are used, and lineChanged marks each
+   //asteroid in them so that it is listed once however many times it changes
+   std::vector<unsigned char> lineChanged;
+   std::vector<std::size_t> changedLines;
+   std::atomic<std::size_t> numChangedLines;
+
+   Locus::FVector3 PositionAt(std::size_t index, double atTime) const;
+   void StartLine(std::size_t index, const Locus::FVector3& position, double startTime);
+   void Bounce(std::size_t index, double bounceTime);
+   void UpdateNextBounceTime(std::size_t index);
+   void ScheduleBounce(std::size_t index);
+   void ScheduleChangedLines();
+   void CompactBounces();
+};
+
+}
\ No newline at end of file
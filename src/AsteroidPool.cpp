@@ -0,0 +1,182 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "AsteroidPool.h"
+
+#include <new>
+
+namespace MPM
+{
+
+//////////////////////////////////////AsteroidHandle//////////////////////////////////////////
+
+AsteroidHandle::AsteroidHandle()
+   : slot(Invalid_Slot), generation(0)
+{
+}
+
+AsteroidHandle::AsteroidHandle(std::uint32_t slot, std::uint32_t generation)
+   : slot(slot), generation(generation)
+{
+}
+
+bool AsteroidHandle::operator==(const AsteroidHandle& other) const
+{
+   return (slot == other.slot) && (generation == other.generation);
+}
+
+bool AsteroidHandle::operator!=(const AsteroidHandle& other) const
+{
+   return !(*this == other);
+}
+
+//////////////////////////////////////AsteroidPool//////////////////////////////////////////
+
+Asteroid* AsteroidPool::Slot::GetAsteroid()
+{
+   return reinterpret_cast<Asteroid*>(&storage);
+}
+
+AsteroidPool::AsteroidPool()
+{
+}
+
+AsteroidPool::~AsteroidPool()
+{
+   Clear();
+}
+
+AsteroidHandle AsteroidPool::Allocate(int hitsLeft)
+{
+   std::uint32_t slotIndex;
+
+   if (freeSlots.empty())
+   {
+      slotIndex = static_cast<std::uint32_t>(slots.size());
+
+      slots.emplace_back();
+      slots.back().generation = 0;
+   }
+   else
+   {
+      slotIndex = freeSlots.back();
+      freeSlots.pop_back();
+   }
+
+   Slot& slot = slots[slotIndex];
+
+   new (&slot.storage) Asteroid(hitsLeft);
+
+   slot.activeIndex = Not_Active;
+   slot.occupied = true;
+
+   return AsteroidHandle(slotIndex, slot.generation);
+}
+
+void AsteroidPool::Activate(AsteroidHandle handle)
+{
+   Asteroid* asteroid = Get(handle);
+
+   if ((asteroid != nullptr) && (slots[handle.slot].activeIndex == Not_Active))
+   {
+      slots[handle.slot].activeIndex = static_cast<std::uint32_t>(activeAsteroids.size());
+
+      activeAsteroids.push_back(asteroid);
+      activeSlots.push_back(handle.slot);
+   }
+}
+
+void AsteroidPool::Release(AsteroidHandle handle)
+{
+   Asteroid* asteroid = Get(handle);
+
+   if (asteroid == nullptr)
+   {
+      return;
+   }
+
+   Slot& slot = slots[handle.slot];
+
+   if (slot.activeIndex != Not_Active)
+   {
+      //swap and pop
+      std::uint32_t lastSlot = activeSlots.back();
+
+      activeAsteroids[slot.activeIndex] = activeAsteroids.back();
+      activeSlots[slot.activeIndex] = lastSlot;
+      slots[lastSlot].activeIndex = slot.activeIndex;
+
+      activeAsteroids.pop_back();
+      activeSlots.pop_back();
+   }
+
+   asteroid->~Asteroid();
+
+   slot.occupied = false;
+   slot.activeIndex = Not_Active;
+   ++slot.generation;
+
+   freeSlots.push_back(handle.slot);
+}
+
+void AsteroidPool::Clear()
+{
+   activeAsteroids.clear();
+   activeSlots.clear();
+   freeSlots.clear();
+
+   //reuse the lowest slots first
+   for (std::size_t slotIndex = slots.size(); slotIndex > 0; --slotIndex)
+   {
+      Slot& slot = slots[slotIndex - 1];
+
+      if (slot.occupied)
+      {
+         slot.GetAsteroid()->~Asteroid();
+
+         slot.occupied = false;
+         slot.activeIndex = Not_Active;
+         ++slot.generation;
+      }
+
+      freeSlots.push_back(static_cast<std::uint32_t>(slotIndex - 1));
+   }
+}
+
+Asteroid* AsteroidPool::Get(AsteroidHandle handle) const
+{
+   if (handle.slot >= slots.size())
+   {
+      return nullptr;
+   }
+
+   Slot& slot = slots[handle.slot];
+
+   return (slot.occupied && (slot.generation == handle.generation)) ? slot.GetAsteroid() : nullptr;
+}
+
+const std::vector<Asteroid*>& AsteroidPool::GetActive() const
+{
+   return activeAsteroids;
+}
+
+AsteroidHandle AsteroidPool::GetActiveHandle(std::size_t activeIndex) const
+{
+   std::uint32_t slotIndex = activeSlots[activeIndex];
+
+   return AsteroidHandle(slotIndex, slots[slotIndex].generation);
+}
+
+std::size_t AsteroidPool::NumSlots() const
+{
+   return slots.size();
+}
+
+}
\ No newline at end of file
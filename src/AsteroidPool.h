@@ -0,0 +1,95 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Asteroid.h"
+
+#include <deque>
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MPM
+{
+
+//Refers to an asteroid in an AsteroidPool. Once the asteroid is released the handle
+//goes stale instead of referring to whatever asteroid takes its slot next
+struct AsteroidHandle
+{
+   static const std::uint32_t Invalid_Slot = 0xFFFFFFFF;
+
+   AsteroidHandle();
+   AsteroidHandle(std::uint32_t slot, std::uint32_t generation);
+
+   bool operator==(const AsteroidHandle& other) const;
+   bool operator!=(const AsteroidHandle& other) const;
+
+   std::uint32_t slot;
+   std::uint32_t generation;
+};
+
+//Asteroids constructed in slots that are reused once the asteroid in them is released,
+//so splitting an asteroid doesn't allocate new ones. A slot never moves, so pointers to
+//an asteroid (held by the broadphase and the kinematics) stay good until it is released.
+//The active asteroids, the ones taking part in the simulation, are also listed densely;
+//releasing one moves the last in the list into its place rather than shifting the rest
+class AsteroidPool
+{
+public:
+   AsteroidPool();
+   ~AsteroidPool();
+
+   AsteroidPool(const AsteroidPool&) = delete;
+   AsteroidPool& operator=(const AsteroidPool&) = delete;
+
+   //constructs an asteroid in a free slot. It isn't listed as active until Activate
+   AsteroidHandle Allocate(int hitsLeft);
+   void Activate(AsteroidHandle handle);
+
+   //destroys the asteroid, which also takes it out of the kinematics and the contact cache
+   void Release(AsteroidHandle handle);
+
+   //releases every asteroid, active or not. All handles go stale
+   void Clear();
+
+   //nullptr if the handle is stale
+   Asteroid* Get(AsteroidHandle handle) const;
+
+   const std::vector<Asteroid*>& GetActive() const;
+   AsteroidHandle GetActiveHandle(std::size_t activeIndex) const;
+
+   std::size_t NumSlots() const;
+
+private:
+   static const std::uint32_t Not_Active = 0xFFFFFFFF;
+
+   struct Slot
+   {
+      std::aligned_storage<sizeof(Asteroid), std::alignment_of<Asteroid>::value>::type storage;
+
+      std::uint32_t generation;
+      std::uint32_t activeIndex;
+      bool occupied;
+
+      Asteroid* GetAsteroid();
+   };
+
+   mutable std::deque<Slot> slots;
+   std::vector<std::uint32_t> freeSlots;
+
+   //the active asteroids and their slots, in the same order
+   std::vector<Asteroid*> activeAsteroids;
+   std::vector<std::uint32_t> activeSlots;
+};
+
+}
\ No newline at end of file
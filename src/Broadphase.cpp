@@ -0,0 +1,110 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "Broadphase.h"
+#include "CollisionBody.h"
+#include "CollisionDispatch.h"
+#include "GridBroadphase.h"
+#include "LocusBroadphase.h"
+#include "SweepAndPruneBroadphase.h"
+
+#include <stdexcept>
+
+namespace MPM
+{
+
+CollisionPair::CollisionPair()
+   : first(nullptr), second(nullptr)
+{
+}
+
+CollisionPair::CollisionPair(CollisionBody* first, CollisionBody* second)
+   : first(first), second(second)
+{
+}
+
+//////////////////////////////////////Broadphase//////////////////////////////////////////
+
+Broadphase::~Broadphase()
+{
+}
+
+void Broadphase::SetArena(float /*halfExtent*/, float /*largestRadius*/)
+{
+}
+
+void Broadphase::StartAddRemoveBatch()
+{
+}
+
+void Broadphase::FinishAddRemoveBatch()
+{
+}
+
+std::unique_ptr<Broadphase> Broadphase::Create(const std::string& name, WorkerPool& workerPool)
+{
+   if (name == "Locus")
+   {
+      return std::make_unique<LocusBroadphase>();
+   }
+   else if (name == "Grid")
+   {
+      return std::make_unique<GridBroadphase>(workerPool);
+   }
+   else if (name == "SAP")
+   {
+      return std::make_unique<SweepAndPruneBroadphase>(workerPool);
+   }
+
+   throw std::invalid_argument("Unknown broadphase " + name);
+}
+
+//////////////////////////////////////PairBroadphase//////////////////////////////////////////
+
+PairBroadphase::PairBroadphase(WorkerPool& workerPool)
+   : workerPool(workerPool)
+{
+}
+
+void PairBroadphase::TransmitCollisions()
+{
+   batches.Build(pairs);
+   batches.Resolve(workerPool);
+}
+
+const std::vector<CollisionPair>& PairBroadphase::GetPairs() const
+{
+   return pairs;
+}
+
+std::size_t PairBroadphase::GetNumBatches() const
+{
+   return batches.NumBatches();
+}
+
+bool PairBroadphase::IsCandidatePair(CollisionBody& first, CollisionBody& second)
+{
+   if (!CollisionDispatch::ShouldCollide(first.GetCollidableType(), second.GetCollidableType()))
+   {
+      return false;
+   }
+
+   Locus::FVector3 centerDifference = first.GetBroadCenter() - second.GetBroadCenter();
+   float radiusSum = first.GetBroadRadius() + second.GetBroadRadius();
+
+   if (SquaredNorm(centerDifference) > radiusSum * radiusSum)
+   {
+      return false;
+   }
+
+   return true;
+}
+
+}
\ No newline at end of file
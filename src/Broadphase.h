@@ -0,0 +1,92 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "CollisionBatches.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+class CollisionBody;
+class WorkerPool;
+
+struct CollisionPair
+{
+   CollisionPair();
+   CollisionPair(CollisionBody* first, CollisionBody* second);
+
+   CollisionBody* first;
+   CollisionBody* second;
+};
+
+//Finds the pairs of bodies that might collide and has them resolve their collisions.
+//It is used the same way as Locus::CollisionManager: bodies are added, updated after
+//they moved and removed, then UpdateCollisions finds the candidate pairs and
+//TransmitCollisions has each pair resolve its collision
+class Broadphase
+{
+public:
+   virtual ~Broadphase();
+
+   //tells the broadphase the cube the bodies move in, [-halfExtent, halfExtent]^3,
+   //and the largest radius a body's broad extent will have. Bodies may still leave the
+   //cube or be larger; the broadphase only uses these to size itself
+   virtual void SetArena(float halfExtent, float largestRadius);
+
+   virtual void Add(CollisionBody* body) = 0;
+   virtual void Remove(CollisionBody* body) = 0;
+   virtual void Update(CollisionBody* body) = 0;
+   virtual void Clear() = 0;
+
+   virtual void StartAddRemoveBatch();
+   virtual void FinishAddRemoveBatch();
+
+   virtual void UpdateCollisions() = 0;
+   virtual void TransmitCollisions() = 0;
+
+   //makes the broadphase registered under name ("Locus", "Grid" or "SAP"). Throws
+   //std::invalid_argument for any other name
+   static std::unique_ptr<Broadphase> Create(const std::string& name, WorkerPool& workerPool);
+};
+
+//Base for the broadphases that produce an explicit list of candidate pairs. Their
+//collisions are resolved on the worker threads in batches of pairs that share no body
+class PairBroadphase : public Broadphase
+{
+public:
+   PairBroadphase(WorkerPool& workerPool);
+
+   virtual void TransmitCollisions() override;
+
+   const std::vector<CollisionPair>& GetPairs() const;
+
+   //the number of batches the pairs were resolved in by the last TransmitCollisions
+   std::size_t GetNumBatches() const;
+
+protected:
+   WorkerPool& workerPool;
+
+   std::vector<CollisionPair> pairs;
+
+   //true if the bodies' types collide and their broad extents overlap
+   static bool IsCandidatePair(CollisionBody& first, CollisionBody& second);
+
+private:
+   CollisionBatches batches;
+};
+
+}
\ No newline at end of file
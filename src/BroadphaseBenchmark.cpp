@@ -0,0 +1,203 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "BroadphaseBenchmark.h"
+#include "Broadphase.h"
+#include "CollisionBody.h"
+#include "CollidableTypes.h"
+#include "Config.h"
+#include "Random.h"
+#include "SweepAndPruneBroadphase.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <cmath>
+
+namespace MPM
+{
+
+//the demo's asteroid models are about 0.5 units in radius and are scaled by 10 to 30
+static const float Min_Body_Radius = 5.0f;
+static const float Max_Body_Radius = 15.0f;
+
+//the arena holds this many bodies at the size set in options.config.xml
+static const double Reference_Num_Bodies = 200.0;
+
+namespace
+{
+
+class BenchmarkBody : public CollisionBody
+{
+public:
+   BenchmarkBody()
+      : radius(0.0f)
+   {
+      collidableType = CollidableType_Asteroid;
+   }
+
+   void Place(const Locus::FVector3& position, const Locus::FVector3& velocity, float radius)
+   {
+      this->position = position;
+      this->velocity = velocity;
+      this->radius = radius;
+
+      UpdateBroadCollisionExtent();
+   }
+
+   void Move(float DT, float halfExtent)
+   {
+      MoveAxis(position.x, velocity.x, DT, halfExtent);
+      MoveAxis(position.y, velocity.y, DT, halfExtent);
+      MoveAxis(position.z, velocity.z, DT, halfExtent);
+
+      UpdateBroadCollisionExtent();
+   }
+
+   virtual void UpdateBroadCollisionExtent() override
+   {
+      CollisionBody::UpdateBroadCollisionExtent(position, radius);
+   }
+
+   virtual bool CollidesWith(Locus::Collidable& /*collidable*/) const override
+   {
+      return true;
+   }
+
+   virtual void ResolveCollision(Locus::Collidable& /*collidable*/) override
+   {
+   }
+
+private:
+   Locus::FVector3 position;
+   Locus::FVector3 velocity;
+   float radius;
+
+   static void MoveAxis(float& position, float& velocity, float DT, float halfExtent)
+   {
+      if (std::abs(position + velocity * DT) >= halfExtent)
+      {
+         velocity = -velocity;
+      }
+
+      position += velocity * DT;
+   }
+};
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double ToMilliseconds(Clock::duration duration)
+{
+   return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}
+
+BroadphaseBenchmarkResult RunBroadphaseBenchmark(const std::string& broadphaseName, std::size_t numBodies, int numFrames, double DT,
+                                                 unsigned int seed, WorkerPool& workerPool)
+{
+   BroadphaseBenchmarkResult result;
+
+   result.broadphaseName = broadphaseName;
+   result.numBodies = numBodies;
+   result.arenaHalfExtent = static_cast<float>(Config::GetAsteroidsBoundary() * std::cbrt(numBodies / Reference_Num_Bodies));
+   result.numPairs = 0;
+   result.numReinsertions = 0;
+
+   MPM::Random random(seed, RandomStream_Broadphase_Benchmark);
+
+   std::vector<BenchmarkBody> bodies(numBodies);
+
+   for (BenchmarkBody& body : bodies)
+   {
+      float placementExtent = result.arenaHalfExtent - Max_Body_Radius;
+
+      Locus::FVector3 position(static_cast<float>(random.RandomDouble(-placementExtent, placementExtent)),
+                               static_cast<float>(random.RandomDouble(-placementExtent, placementExtent)),
+                               static_cast<float>(random.RandomDouble(-placementExtent, placementExtent)));
+
+      Locus::FVector3 direction(static_cast<float>(random.RandomDouble(-1, 1)),
+                                static_cast<float>(random.RandomDouble(-1, 1)),
+                                static_cast<float>(random.RandomDouble(-1, 1)));
+
+      Normalize(direction);
+
+      float speed = static_cast<float>(random.RandomDouble(Config::GetMinAsteroidSpeed(), Config::GetMaxAsteroidSpeed()));
+      float radius = static_cast<float>(random.RandomDouble(Min_Body_Radius, Max_Body_Radius));
+
+      body.Place(position, speed * direction, radius);
+   }
+
+   std::unique_ptr<Broadphase> broadphase = Broadphase::Create(broadphaseName, workerPool);
+
+   broadphase->SetArena(result.arenaHalfExtent, Max_Body_Radius);
+
+   broadphase->StartAddRemoveBatch();
+
+   for (BenchmarkBody& body : bodies)
+   {
+      broadphase->Add(&body);
+   }
+
+   broadphase->FinishAddRemoveBatch();
+
+   Clock::duration updateTime = Clock::duration::zero();
+   Clock::duration pairsTime = Clock::duration::zero();
+
+   float dt = static_cast<float>(DT);
+
+   for (int frame = 0; frame < numFrames; ++frame)
+   {
+      for (BenchmarkBody& body : bodies)
+      {
+         body.Move(dt, result.arenaHalfExtent);
+      }
+
+      Clock::time_point updateStart = Clock::now();
+
+      for (BenchmarkBody& body : bodies)
+      {
+         broadphase->Update(&body);
+      }
+
+      Clock::time_point pairsStart = Clock::now();
+
+      broadphase->UpdateCollisions();
+
+      Clock::time_point pairsEnd = Clock::now();
+
+      updateTime += (pairsStart - updateStart);
+      pairsTime += (pairsEnd - pairsStart);
+   }
+
+   result.updateMillisecondsPerFrame = ToMilliseconds(updateTime) / numFrames;
+   result.pairsMillisecondsPerFrame = ToMilliseconds(pairsTime) / numFrames;
+
+   const PairBroadphase* pairBroadphase = dynamic_cast<const PairBroadphase*>(broadphase.get());
+
+   if (pairBroadphase != nullptr)
+   {
+      result.numPairs = pairBroadphase->GetPairs().size();
+   }
+
+   const SweepAndPruneBroadphase* sweepAndPruneBroadphase = dynamic_cast<const SweepAndPruneBroadphase*>(broadphase.get());
+
+   if (sweepAndPruneBroadphase != nullptr)
+   {
+      result.numReinsertions = sweepAndPruneBroadphase->GetNumReinsertions();
+   }
+
+   broadphase->Clear();
+
+   return result;
+}
+
+}
\ No newline at end of file
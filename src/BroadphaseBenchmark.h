@@ -0,0 +1,46 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include <string>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+class WorkerPool;
+
+struct BroadphaseBenchmarkResult
+{
+   std::string broadphaseName;
+   std::size_t numBodies;
+   float arenaHalfExtent;
+
+   double updateMillisecondsPerFrame;
+   double pairsMillisecondsPerFrame;
+
+   //pairs found in the last frame, for the broadphases that report them
+   std::size_t numPairs;
+
+   //bodies that left their fat bounds in the last frame, for sweep and prune
+   std::size_t numReinsertions;
+};
+
+//Measures the broadphase alone: spheres of asteroid sizes and speeds bounce around the
+//arena while the broadphase is kept up to date (update) and asked for the candidate
+//pairs (pairs). No asteroid meshes are built, so tens of thousands of bodies are cheap
+//to set up. The arena grows with the number of bodies so that the bodies are as
+//crowded as the default asteroid field
+BroadphaseBenchmarkResult RunBroadphaseBenchmark(const std::string& broadphaseName, std::size_t numBodies, int numFrames, double DT,
+                                                 unsigned int seed, WorkerPool& workerPool);
+
+}
\ No newline at end of file
@@ -16,8 +16,8 @@ namespace MPM
 enum CollidableTypes
 {
    CollidableType_Asteroid = 0,
-   CollidableType_Shot,
-   CollidableType_Player
+   CollidableType_Player,
+   Num_CollidableTypes
 };
 
 }
\ No newline at end of file
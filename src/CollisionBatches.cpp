@@ -0,0 +1,146 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "CollisionBatches.h"
+#include "Broadphase.h"
+#include "CollisionBody.h"
+#include "CollisionDispatch.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+namespace MPM
+{
+
+//resolving a pair runs the whole narrowphase, so hand them out a few at a time
+static const std::size_t Pair_Chunk_Size = 4;
+
+static std::uint32_t LowestClearBit(std::uint64_t bits)
+{
+   std::uint32_t bit = 0;
+
+   while ((bits & 1) != 0)
+   {
+      bits >>= 1;
+      ++bit;
+   }
+
+   return bit;
+}
+
+void CollisionBatches::Build(const std::vector<CollisionPair>& pairs)
+{
+   std::size_t numPairs = pairs.size();
+
+   std::size_t numBodyIDs = 0;
+
+   for (const CollisionPair& pair : pairs)
+   {
+      numBodyIDs = std::max(numBodyIDs, std::max(pair.first->GetBroadphaseIndex(), pair.second->GetBroadphaseIndex()) + 1);
+   }
+
+   bodyBatches.assign(numBodyIDs, 0);
+   pairBatches.resize(numPairs);
+
+   //pairs that fit no batch go to batch Max_Batches. Each batch's pairs are counted two
+   //places ahead so that the prefix sum leaves the batch's start one place ahead, where
+   //it can be advanced while placing the pairs and end up at the start of the next batch
+   batchStarts.assign(Max_Batches + 3, 0);
+
+   for (std::size_t pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+   {
+      std::uint64_t& firstBatches = bodyBatches[pairs[pairIndex].first->GetBroadphaseIndex()];
+      std::uint64_t& secondBatches = bodyBatches[pairs[pairIndex].second->GetBroadphaseIndex()];
+
+      std::uint32_t batch = LowestClearBit(firstBatches | secondBatches);
+
+      if (batch < Max_Batches)
+      {
+         firstBatches |= (std::uint64_t(1) << batch);
+         secondBatches |= (std::uint64_t(1) << batch);
+      }
+
+      pairBatches[pairIndex] = batch;
+      ++batchStarts[batch + 2];
+   }
+
+   for (std::size_t batch = 1; batch < batchStarts.size(); ++batch)
+   {
+      batchStarts[batch] += batchStarts[batch - 1];
+   }
+
+   //counting sort the pairs by batch, keeping them in order within a batch
+
+   batchedPairs.resize(numPairs);
+
+   for (std::size_t pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+   {
+      batchedPairs[ batchStarts[pairBatches[pairIndex] + 1]++ ] = pairs[pairIndex];
+   }
+
+   batchStarts.pop_back();
+}
+
+void CollisionBatches::Resolve(WorkerPool& workerPool) const
+{
+   if (batchStarts.empty())
+   {
+      return;
+   }
+
+   for (std::size_t batch = 0; batch < Max_Batches; ++batch)
+   {
+      std::size_t batchStart = batchStarts[batch];
+      std::size_t batchSize = batchStarts[batch + 1] - batchStart;
+
+      if (batchSize == 0)
+      {
+         //batches are filled lowest first, so the rest are empty too
+         break;
+      }
+
+      workerPool.ParallelFor(batchSize, Pair_Chunk_Size, [&](std::size_t begin, std::size_t end)
+      {
+         for (std::size_t pairIndex = batchStart + begin; pairIndex < batchStart + end; ++pairIndex)
+         {
+            CollisionDispatch::Resolve(*batchedPairs[pairIndex].first, *batchedPairs[pairIndex].second);
+         }
+      });
+   }
+
+   for (std::size_t pairIndex = batchStarts[Max_Batches]; pairIndex < batchStarts[Max_Batches + 1]; ++pairIndex)
+   {
+      CollisionDispatch::Resolve(*batchedPairs[pairIndex].first, *batchedPairs[pairIndex].second);
+   }
+}
+
+std::size_t CollisionBatches::NumBatches() const
+{
+   std::size_t numBatches = 0;
+
+   if (batchStarts.empty())
+   {
+      return numBatches;
+   }
+
+   while ((numBatches < Max_Batches) && (batchStarts[numBatches + 1] > batchStarts[numBatches]))
+   {
+      ++numBatches;
+   }
+
+   if (batchStarts[Max_Batches + 1] > batchStarts[Max_Batches])
+   {
+      ++numBatches;
+   }
+
+   return numBatches;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MPM
+{
+
+struct CollisionPair;
+class WorkerPool;
+
+//Splits collision pairs into batches in which no body is in more than one pair, by
+//greedily coloring the pairs with the broadphase indices of their bodies as body IDs.
+//Resolving a collision only changes the two bodies involved, so the pairs of a batch
+//can be resolved in parallel. Batches are resolved one after another in a fixed order,
+//so the outcome doesn't depend on the number of threads
+class CollisionBatches
+{
+public:
+   //pairs that can't get one of the Max_Batches colors (a body in more pairs than
+   //that) are left to a last batch that is resolved on the calling thread
+   static const std::size_t Max_Batches = 64;
+
+   //every body in pairs must have a broadphase index
+   void Build(const std::vector<CollisionPair>& pairs);
+
+   void Resolve(WorkerPool& workerPool) const;
+
+   //the number of batches, counting the last one if it has any pairs
+   std::size_t NumBatches() const;
+
+private:
+   //for each body ID, the batches its pairs were put in, one bit per batch
+   std::vector<std::uint64_t> bodyBatches;
+
+   std::vector<std::uint32_t> pairBatches;
+
+   //the pairs grouped by batch. Batch i is [batchStarts[i], batchStarts[i + 1])
+   std::vector<CollisionPair> batchedPairs;
+   std::vector<std::size_t> batchStarts;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "CollisionBody.h"
+
+namespace MPM
+{
+
+CollisionBody::CollisionBody()
+   : broadRadius(0.0f), broadphaseIndex(No_Broadphase_Index)
+{
+}
+
+CollisionBody::CollisionBody(const CollisionBody& other)
+   : Locus::Collidable(other), broadCenter(other.broadCenter), broadRadius(other.broadRadius), broadphaseIndex(No_Broadphase_Index)
+{
+}
+
+CollisionBody& CollisionBody::operator=(const CollisionBody& other)
+{
+   //a body keeps its own place in a broadphase when it is assigned to
+   Locus::Collidable::operator=(other);
+
+   broadCenter = other.broadCenter;
+   broadRadius = other.broadRadius;
+
+   return *this;
+}
+
+const Locus::FVector3& CollisionBody::GetBroadCenter() const
+{
+   return broadCenter;
+}
+
+float CollisionBody::GetBroadRadius() const
+{
+   return broadRadius;
+}
+
+std::size_t CollisionBody::GetBroadphaseIndex() const
+{
+   return broadphaseIndex;
+}
+
+void CollisionBody::SetBroadphaseIndex(std::size_t broadphaseIndex)
+{
+   this->broadphaseIndex = broadphaseIndex;
+}
+
+void CollisionBody::UpdateBroadCollisionExtent(const Locus::FVector3& center, float radius)
+{
+   broadCenter = center;
+   broadRadius = radius;
+
+   Locus::Collidable::UpdateBroadCollisionExtent(center, radius);
+}
+
+}
\ No newline at end of file
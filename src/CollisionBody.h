@@ -0,0 +1,52 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include "Locus/Geometry/Collidable.h"
+
+#include <cstddef>
+
+namespace MPM
+{
+
+//A Locus::Collidable that also keeps its broad collision extent (a bounding sphere)
+//where MPM's own broadphases can read it, along with the slot the broadphase it
+//was added to keeps it in
+class CollisionBody : public Locus::Collidable
+{
+public:
+   static const std::size_t No_Broadphase_Index = static_cast<std::size_t>(-1);
+
+   CollisionBody();
+   CollisionBody(const CollisionBody& other);
+   CollisionBody& operator=(const CollisionBody& other);
+
+   using Locus::Collidable::UpdateBroadCollisionExtent;
+
+   const Locus::FVector3& GetBroadCenter() const;
+   float GetBroadRadius() const;
+
+   std::size_t GetBroadphaseIndex() const;
+   void SetBroadphaseIndex(std::size_t broadphaseIndex);
+
+protected:
+   void UpdateBroadCollisionExtent(const Locus::FVector3& center, float radius);
+
+private:
+   Locus::FVector3 broadCenter;
+   float broadRadius;
+
+   std::size_t broadphaseIndex;
+};
+
+}
\ No newline at end of file
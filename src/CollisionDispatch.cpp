@@ -0,0 +1,112 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "CollisionDispatch.h"
+#include "Asteroid.h"
+#include "Player.h"
+
+namespace MPM
+{
+
+//how bodies of two classes collide. Pairs of classes without a specialization don't
+template <class First, class Second>
+struct CollisionHandler
+{
+   static const bool Collides = false;
+
+   static void Resolve(First& /*first*/, Second& /*second*/)
+   {
+   }
+};
+
+template <>
+struct CollisionHandler<Asteroid, Asteroid>
+{
+   static const bool Collides = true;
+
+   static void Resolve(Asteroid& first, Asteroid& second)
+   {
+      second.ResolveCollision(first);
+   }
+};
+
+template <>
+struct CollisionHandler<Asteroid, Player>
+{
+   static const bool Collides = true;
+
+   static void Resolve(Asteroid& asteroid, Player& player)
+   {
+      player.ResolveCollision(asteroid);
+   }
+};
+
+template <>
+struct CollisionHandler<Player, Asteroid>
+{
+   static const bool Collides = true;
+
+   static void Resolve(Player& player, Asteroid& asteroid)
+   {
+      player.ResolveCollision(asteroid);
+   }
+};
+
+typedef void (*ResolveFunction)(CollisionBody& first, CollisionBody& second);
+
+struct DispatchEntry
+{
+   bool collides;
+   ResolveFunction resolve;
+};
+
+//the table is indexed by the bodies' types, so they are of these classes
+template <class First, class Second>
+void ResolvePair(CollisionBody& first, CollisionBody& second)
+{
+   CollisionHandler<First, Second>::Resolve(static_cast<First&>(first), static_cast<Second&>(second));
+}
+
+static_assert(Num_CollidableTypes == 2, "Dispatch_Table needs a row and a column for every collidable type");
+
+//row is the first body's type, column the second's. Broadphases hand a pair over in either
+//order, so a pair of types has to collide in both or in neither (MPM_Headless --check
+//makes sure of it)
+static const DispatchEntry Dispatch_Table[Num_CollidableTypes][Num_CollidableTypes] =
+{
+   //CollidableType_Asteroid
+   {
+      { CollisionHandler<Asteroid, Asteroid>::Collides, &ResolvePair<Asteroid, Asteroid> },
+      { CollisionHandler<Asteroid, Player>::Collides,   &ResolvePair<Asteroid, Player> }
+   },
+
+   //CollidableType_Player
+   {
+      { CollisionHandler<Player, Asteroid>::Collides,   &ResolvePair<Player, Asteroid> },
+      { CollisionHandler<Player, Player>::Collides,     &ResolvePair<Player, Player> }
+   }
+};
+
+bool CollisionDispatch::ShouldCollide(int firstType, int secondType)
+{
+   return Dispatch_Table[firstType][secondType].collides;
+}
+
+void CollisionDispatch::Resolve(CollisionBody& first, CollisionBody& second)
+{
+   const DispatchEntry& entry = Dispatch_Table[first.GetCollidableType()][second.GetCollidableType()];
+
+   if (entry.collides)
+   {
+      entry.resolve(first, second);
+   }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "CollidableTypes.h"
+
+namespace MPM
+{
+
+class CollisionBody;
+
+//Resolves collisions through a table indexed by the collidable types of the two bodies,
+//filled in from the CollisionHandler specializations in CollisionDispatch.cpp.
+//A pair costs one lookup and one call through a function pointer rather than virtual
+//calls and dynamic_casts
+class CollisionDispatch
+{
+public:
+   //true if bodies of these types collide at all. Pair broadphases check this before
+   //anything else, so other pairs never become candidates
+   static bool ShouldCollide(int firstType, int secondType);
+
+   //does nothing for a pair of types that don't collide
+   static void Resolve(CollisionBody& first, CollisionBody& second);
+};
+
+}
\ No newline at end of file
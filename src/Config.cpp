@@ -40,6 +40,16 @@ static const int Default_Min_Planets = 10;
 static const int Default_Max_Planets = 15;
 static const float Default_Min_Planet_Radius = 30.0f;
 static const float Default_Max_Planet_Radius = 50.0f;
+static const unsigned int Default_Num_Worker_Threads = 0;
+static const float Default_Simulation_Rate = 60.0f;
+static const unsigned int Default_Max_Simulation_Steps = 5;
+static const std::string Default_Broadphase = "Grid";
+static const std::string Default_Asteroid_Narrowphase = "Hull";
+static const unsigned int Default_Fracture_Depth = 3;
+static const unsigned int Default_World_Seed = 0;
+static const float Default_LOD_Distance = 60.0f;
+static const unsigned int Default_LOD_Update_Interval = 4;
+static const float Default_Draw_Statistics_Interval = 0.0f;
 
 std::string Config::modelFile = Default_Model_File;
 int Config::numAsteroids = Default_Num_Asteroids;
@@ -57,6 +67,16 @@ int Config::minPlanets = Default_Min_Planets;
 int Config::maxPlanets = Default_Max_Planets;
 float Config::minPlanetRadius = Default_Min_Planet_Radius;
 float Config::maxPlanetRadius = Default_Max_Planet_Radius;
+unsigned int Config::numWorkerThreads = Default_Num_Worker_Threads;
+float Config::simulationRate = Default_Simulation_Rate;
+unsigned int Config::maxSimulationSteps = Default_Max_Simulation_Steps;
+std::string Config::broadphase = Default_Broadphase;
+std::string Config::asteroidNarrowphase = Default_Asteroid_Narrowphase;
+unsigned int Config::fractureDepth = Default_Fracture_Depth;
+unsigned int Config::worldSeed = Default_World_Seed;
+float Config::lodDistance = Default_LOD_Distance;
+unsigned int Config::lodUpdateInterval = Default_LOD_Update_Interval;
+float Config::drawStatisticsInterval = Default_Draw_Statistics_Interval;
 
 namespace OptionsXML
 {
@@ -74,6 +94,16 @@ static const std::string Asteroid_Speed = "Asteroid_Speed";
 static const std::string Asteroid_Rotation_Speed = "Rotation_Speed";
 static const std::string Num_Planets = "Num_Planets";
 static const std::string Planet_Radius = "Planet_Radius";
+static const std::string Num_Worker_Threads = "Worker_Threads";
+static const std::string Simulation_Rate = "Simulation_Rate";
+static const std::string Max_Simulation_Steps = "Max_Simulation_Steps";
+static const std::string Broadphase = "Broadphase";
+static const std::string Asteroid_Narrowphase = "Asteroid_Narrowphase";
+static const std::string Fracture_Depth = "Fracture_Depth";
+static const std::string World_Seed = "World_Seed";
+static const std::string LOD_Distance = "LOD_Distance";
+static const std::string LOD_Update_Interval = "LOD_Update_Interval";
+static const std::string Draw_Statistics_Interval = "Draw_Statistics_Interval";
 
 static const std::string Minimum = "Min";
 static const std::string Maximum = "Max";
@@ -183,6 +213,16 @@ void Config::Set()
    maxPlanets = Default_Max_Planets;
    minPlanetRadius = Default_Min_Planet_Radius;
    maxPlanetRadius = Default_Max_Planet_Radius;
+   numWorkerThreads = Default_Num_Worker_Threads;
+   simulationRate = Default_Simulation_Rate;
+   maxSimulationSteps = Default_Max_Simulation_Steps;
+   broadphase = Default_Broadphase;
+   asteroidNarrowphase = Default_Asteroid_Narrowphase;
+   fractureDepth = Default_Fracture_Depth;
+   worldSeed = Default_World_Seed;
+   lodDistance = Default_LOD_Distance;
+   lodUpdateInterval = Default_LOD_Update_Interval;
+   drawStatisticsInterval = Default_Draw_Statistics_Interval;
 
    Locus::XMLTag rootTag;
 
@@ -202,6 +242,20 @@ void Config::Set()
       Locus::TrimString(modelFile);
    }
 
+   Locus::XMLTag* broadphaseTag = rootTag.FindSubTag(OptionsXML::Broadphase, 0);
+   if (broadphaseTag != nullptr)
+   {
+      broadphase = broadphaseTag->value;
+      Locus::TrimString(broadphase);
+   }
+
+   Locus::XMLTag* asteroidNarrowphaseTag = rootTag.FindSubTag(OptionsXML::Asteroid_Narrowphase, 0);
+   if (asteroidNarrowphaseTag != nullptr)
+   {
+      asteroidNarrowphase = asteroidNarrowphaseTag->value;
+      Locus::TrimString(asteroidNarrowphase);
+   }
+
    LoadNumeric<int>(numAsteroids, rootTag, OptionsXML::Num_Asteroids, 1.0f);
    LoadNumeric<unsigned int>(numStars, rootTag, OptionsXML::Num_Stars, 0.0f);
    LoadNumeric<unsigned int>(numShots, rootTag, OptionsXML::Num_Shots, 1.0f);
@@ -209,6 +263,14 @@ void Config::Set()
    LoadNumeric<float>(shotSpeed, rootTag, OptionsXML::Shot_Speed, 1.0f);
    LoadNumeric<float>(asteroidsBoundary, rootTag, OptionsXML::Asteroids_Boundary, 1.0f);
    LoadNumeric<float>(playerCollisionRadius, rootTag, OptionsXML::Player_Collision_Radius, 0.01f);
+   LoadNumeric<unsigned int>(numWorkerThreads, rootTag, OptionsXML::Num_Worker_Threads, 0.0f);
+   LoadNumeric<float>(simulationRate, rootTag, OptionsXML::Simulation_Rate, 1.0f);
+   LoadNumeric<unsigned int>(maxSimulationSteps, rootTag, OptionsXML::Max_Simulation_Steps, 1.0f);
+   LoadNumeric<unsigned int>(fractureDepth, rootTag, OptionsXML::Fracture_Depth, 0.0f);
+   LoadNumeric<unsigned int>(worldSeed, rootTag, OptionsXML::World_Seed, 0.0f);
+   LoadNumeric<float>(lodDistance, rootTag, OptionsXML::LOD_Distance, 0.0f);
+   LoadNumeric<unsigned int>(lodUpdateInterval, rootTag, OptionsXML::LOD_Update_Interval, 1.0f);
+   LoadNumeric<float>(drawStatisticsInterval, rootTag, OptionsXML::Draw_Statistics_Interval, 0.0f);
 
    LoadMinMaxPair<float>(minAsteroidSpeed, maxAsteroidSpeed, rootTag, OptionsXML::Asteroid_Speed, 0.0f);
    LoadMinMaxPair<float>(minAsteroidRotationSpeed, maxAsteroidRotationSpeed, rootTag, OptionsXML::Asteroid_Rotation_Speed, 0.0f);
@@ -216,6 +278,46 @@ void Config::Set()
    LoadMinMaxPair<float>(minPlanetRadius, maxPlanetRadius, rootTag, OptionsXML::Planet_Radius, 0.01f);
 }
 
+void Config::SetModelFile(const std::string& modelFile)
+{
+   Config::modelFile = modelFile;
+}
+
+void Config::SetNumAsteroids(int numAsteroids)
+{
+   Config::numAsteroids = numAsteroids;
+}
+
+void Config::SetNumWorkerThreads(unsigned int numWorkerThreads)
+{
+   Config::numWorkerThreads = numWorkerThreads;
+}
+
+void Config::SetBroadphase(const std::string& broadphase)
+{
+   Config::broadphase = broadphase;
+}
+
+void Config::SetAsteroidNarrowphase(const std::string& asteroidNarrowphase)
+{
+   Config::asteroidNarrowphase = asteroidNarrowphase;
+}
+
+void Config::SetFractureDepth(unsigned int fractureDepth)
+{
+   Config::fractureDepth = fractureDepth;
+}
+
+void Config::SetWorldSeed(unsigned int worldSeed)
+{
+   Config::worldSeed = worldSeed;
+}
+
+void Config::SetLODUpdateInterval(unsigned int lodUpdateInterval)
+{
+   Config::lodUpdateInterval = lodUpdateInterval;
+}
+
 static bool ReadInt(const std::string& str, int& value)
 {
    if (!Locus::IsType<int>(str))
@@ -468,4 +570,54 @@ float Config::GetMaxPlanetRadius()
    return maxPlanetRadius;
 }
 
+unsigned int Config::GetNumWorkerThreads()
+{
+   return numWorkerThreads;
+}
+
+float Config::GetSimulationRate()
+{
+   return simulationRate;
+}
+
+unsigned int Config::GetMaxSimulationSteps()
+{
+   return maxSimulationSteps;
+}
+
+std::string Config::GetBroadphase()
+{
+   return broadphase;
+}
+
+std::string Config::GetAsteroidNarrowphase()
+{
+   return asteroidNarrowphase;
+}
+
+unsigned int Config::GetFractureDepth()
+{
+   return fractureDepth;
+}
+
+unsigned int Config::GetWorldSeed()
+{
+   return worldSeed;
+}
+
+float Config::GetLODDistance()
+{
+   return lodDistance;
+}
+
+unsigned int Config::GetLODUpdateInterval()
+{
+   return lodUpdateInterval;
+}
+
+float Config::GetDrawStatisticsInterval()
+{
+   return drawStatisticsInterval;
+}
+
 }
\ No newline at end of file
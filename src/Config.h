@@ -23,6 +23,15 @@ class Config
 public:
    static void Set();
 
+   static void SetModelFile(const std::string& modelFile);
+   static void SetNumAsteroids(int numAsteroids);
+   static void SetNumWorkerThreads(unsigned int numWorkerThreads);
+   static void SetBroadphase(const std::string& broadphase);
+   static void SetAsteroidNarrowphase(const std::string& asteroidNarrowphase);
+   static void SetFractureDepth(unsigned int fractureDepth);
+   static void SetWorldSeed(unsigned int worldSeed);
+   static void SetLODUpdateInterval(unsigned int lodUpdateInterval);
+
    static std::string GetModelFile();
    static int GetNumAsteroids();
    static unsigned int GetNumStars();
@@ -39,6 +48,16 @@ public:
    static int GetMaxPlanets();
    static float GetMinPlanetRadius();
    static float GetMaxPlanetRadius();
+   static unsigned int GetNumWorkerThreads();
+   static float GetSimulationRate();
+   static unsigned int GetMaxSimulationSteps();
+   static std::string GetBroadphase();
+   static std::string GetAsteroidNarrowphase();
+   static unsigned int GetFractureDepth();
+   static unsigned int GetWorldSeed();
+   static float GetLODDistance();
+   static unsigned int GetLODUpdateInterval();
+   static float GetDrawStatisticsInterval();
 
    struct LightingOptions
    {
@@ -67,6 +86,16 @@ private:
    static int maxPlanets;
    static float minPlanetRadius;
    static float maxPlanetRadius;
+   static unsigned int numWorkerThreads;
+   static float simulationRate;
+   static unsigned int maxSimulationSteps;
+   static std::string broadphase;
+   static std::string asteroidNarrowphase;
+   static unsigned int fractureDepth;
+   static unsigned int worldSeed;
+   static float lodDistance;
+   static unsigned int lodUpdateInterval;
+   static float drawStatisticsInterval;
 };
 
 }
\ No newline at end of file
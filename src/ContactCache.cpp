@@ -0,0 +1,185 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "ContactCache.h"
+
+#include <algorithm>
+
+namespace MPM
+{
+
+ContactCache::ContactKey::ContactKey(const Locus::Collidable* first, const Locus::Collidable* second)
+   : first(std::less<const Locus::Collidable*>()(first, second) ? first : second),
+     second(std::less<const Locus::Collidable*>()(first, second) ? second : first)
+{
+}
+
+bool ContactCache::ContactKey::operator==(const ContactKey& other) const
+{
+   return (first == other.first) && (second == other.second);
+}
+
+std::size_t ContactCache::ContactKeyHash::operator()(const ContactKey& key) const
+{
+   std::hash<const Locus::Collidable*> hasher;
+
+   std::size_t hash = hasher(key.first);
+
+   return hash ^ (hasher(key.second) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+ContactCache::ContactCache()
+   : frame(0), debounceFrames(0), expiryStart(0), numAllocations(0)
+{
+}
+
+void ContactCache::SetDebounceFrames(unsigned int debounceFrames)
+{
+   this->debounceFrames = debounceFrames;
+}
+
+unsigned int ContactCache::GetFrame() const
+{
+   return frame;
+}
+
+void ContactCache::NextFrame()
+{
+   std::lock_guard<std::mutex> lock(mutex);
+
+   for (const ContactKey& key : frameResolves)
+   {
+      std::size_t bucketCount = contacts.bucket_count();
+
+      auto insertResult = contacts.emplace(key, frame);
+
+      if (insertResult.second)
+      {
+         ++numAllocations;
+
+         if (contacts.bucket_count() != bucketCount)
+         {
+            ++numAllocations;
+         }
+      }
+      else
+      {
+         insertResult.first->second = frame;
+      }
+
+      if (expiryQueue.size() == expiryQueue.capacity())
+      {
+         ++numAllocations;
+      }
+
+      expiryQueue.push_back({key, frame});
+   }
+
+   frameResolves.clear();
+
+   ++frame;
+
+   while ((expiryStart < expiryQueue.size()) && !IsDebounced(expiryQueue[expiryStart].resolvedFrame))
+   {
+      const ResolvedContact& resolvedContact = expiryQueue[expiryStart];
+
+      auto contactIter = contacts.find(resolvedContact.key);
+
+      if ((contactIter != contacts.end()) && (contactIter->second == resolvedContact.resolvedFrame))
+      {
+         contacts.erase(contactIter);
+      }
+
+      ++expiryStart;
+   }
+
+   //the expired entries are dropped once they make up half of the queue, so shifting the
+   //rest down costs no more than the resolves that filled it
+   if (expiryStart == expiryQueue.size())
+   {
+      expiryQueue.clear();
+      expiryStart = 0;
+   }
+   else if (2 * expiryStart >= expiryQueue.size())
+   {
+      expiryQueue.erase(expiryQueue.begin(), expiryQueue.begin() + expiryStart);
+      expiryStart = 0;
+   }
+}
+
+bool ContactCache::IsDebounced(const Locus::Collidable* first, const Locus::Collidable* second) const
+{
+   auto contactIter = contacts.find(ContactKey(first, second));
+
+   return (contactIter != contacts.end()) && IsDebounced(contactIter->second);
+}
+
+bool ContactCache::IsDebounced(unsigned int resolvedFrame) const
+{
+   return (frame - resolvedFrame < debounceFrames);
+}
+
+void ContactCache::MarkResolved(const Locus::Collidable* first, const Locus::Collidable* second)
+{
+   std::lock_guard<std::mutex> lock(mutex);
+
+   if (frameResolves.size() == frameResolves.capacity())
+   {
+      ++numAllocations;
+   }
+
+   frameResolves.push_back(ContactKey(first, second));
+}
+
+void ContactCache::Remove(const Locus::Collidable* collidable)
+{
+   std::lock_guard<std::mutex> lock(mutex);
+
+   for (auto contactIter = contacts.begin(); contactIter != contacts.end(); )
+   {
+      if ((contactIter->first.first == collidable) || (contactIter->first.second == collidable))
+      {
+         contactIter = contacts.erase(contactIter);
+      }
+      else
+      {
+         ++contactIter;
+      }
+   }
+
+   frameResolves.erase(std::remove_if(frameResolves.begin(), frameResolves.end(), [collidable](const ContactKey& key)
+   {
+      return (key.first == collidable) || (key.second == collidable);
+   }), frameResolves.end());
+}
+
+void ContactCache::Clear()
+{
+   std::lock_guard<std::mutex> lock(mutex);
+
+   contacts.clear();
+   expiryQueue.clear();
+   expiryStart = 0;
+   frameResolves.clear();
+
+   numAllocations = 0;
+}
+
+std::size_t ContactCache::NumContacts() const
+{
+   return contacts.size();
+}
+
+std::size_t ContactCache::GetNumAllocations() const
+{
+   return numAllocations;
+}
+
+}
\ No newline at end of file
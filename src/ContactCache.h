@@ -0,0 +1,115 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <mutex>
+
+#include <cstddef>
+
+namespace Locus
+{
+
+class Collidable;
+
+}
+
+namespace MPM
+{
+
+//Remembers which pairs of collidables were found in contact and resolved in recent
+//simulation frames, keyed by the unordered pair and timed by frame number rather than
+//by the wall clock. A pair that was just resolved is left alone for a number of frames
+//so that it has time to separate instead of being resolved again while it still
+//interpenetrates.
+//
+//Pairs are resolved from the worker threads. Looking a pair up doesn't lock: the cached
+//contacts only change in NextFrame, Remove and Clear, which are never called while pairs
+//are being resolved. Resolves are queued under a lock and added to the cache by NextFrame
+class ContactCache
+{
+public:
+   ContactCache();
+
+   //changing it while contacts are cached applies to them too
+   void SetDebounceFrames(unsigned int debounceFrames);
+
+   unsigned int GetFrame() const;
+
+   //adds the pairs resolved in the frame that just ended and advances the frame counter.
+   //Contacts that are no longer debounced are forgotten. Only the contacts that expire are visited
+   void NextFrame();
+
+   //true if the pair was resolved within the last debounce frames, in which case
+   //the narrowphase can be skipped. A pair resolved in the current frame is only
+   //found from the next one on; no pair is resolved twice in a frame
+   bool IsDebounced(const Locus::Collidable* first, const Locus::Collidable* second) const;
+
+   //records that the pair was found in contact and resolved in the current frame
+   void MarkResolved(const Locus::Collidable* first, const Locus::Collidable* second);
+
+   //forgets every contact of a collidable that is going away
+   void Remove(const Locus::Collidable* collidable);
+   void Clear();
+
+   std::size_t NumContacts() const;
+
+   //how many times the cache allocated since it was last cleared: a contact added to the
+   //map, the map's buckets growing or one of the queues growing. Only resolves allocate
+   std::size_t GetNumAllocations() const;
+
+private:
+   struct ContactKey
+   {
+      ContactKey(const Locus::Collidable* first, const Locus::Collidable* second);
+
+      bool operator==(const ContactKey& other) const;
+
+      const Locus::Collidable* first;
+      const Locus::Collidable* second;
+   };
+
+   struct ContactKeyHash
+   {
+      std::size_t operator()(const ContactKey& key) const;
+   };
+
+   struct ResolvedContact
+   {
+      ContactKey key;
+      unsigned int resolvedFrame;
+   };
+
+   unsigned int frame;
+   unsigned int debounceFrames;
+
+   //the frame each pair was last resolved in
+   std::unordered_map<ContactKey, unsigned int, ContactKeyHash> contacts;
+
+   //every resolve in the order they were made, which is also the order they expire in,
+   //from expiryStart on. An entry whose pair was resolved again or removed since is stale
+   //and just dropped. Kept in a vector so that it stops allocating once it is large enough
+   std::vector<ResolvedContact> expiryQueue;
+   std::size_t expiryStart;
+
+   //the pairs resolved in the current frame, guarded by mutex
+   std::vector<ContactKey> frameResolves;
+
+   std::size_t numAllocations;
+
+   std::mutex mutex;
+
+   bool IsDebounced(unsigned int resolvedFrame) const;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,446 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "ConvexCollision.h"
+#include "ConvexHull.h"
+#include "NarrowphaseScratch.h"
+
+#include "Locus/Geometry/Vector3Geometry.h"
+
+#include <limits>
+
+#include <cmath>
+#include <cstdint>
+
+namespace MPM
+{
+
+static const int Max_GJK_Iterations = 64;
+static const int Max_EPA_Iterations = 64;
+
+//EPA stops once the polytope can't be grown toward its closest face by more than this
+static const float EPA_Tolerance = 1e-4f;
+
+//a tetrahedron whose volume is no more than this, relative to the lengths of its edges from
+//the newest point, is taken to be flat
+static const float Flat_Tolerance = 1e-5f;
+
+namespace
+{
+
+//a hull in its model's frame. Its support is found in model space
+class PlacedHull
+{
+public:
+   PlacedHull(const ConvexHull& hull, const ModelFrame& frame)
+      : hull(hull), frame(frame)
+   {
+   }
+
+   Locus::FVector3 Support(const Locus::FVector3& direction) const
+   {
+      return frame.ToWorld( hull.Support(frame.SupportDirectionToModel(direction)) );
+   }
+
+   const Locus::FVector3& GetOrigin() const
+   {
+      return frame.GetOrigin();
+   }
+
+private:
+   const ConvexHull& hull;
+   const ModelFrame& frame;
+};
+
+//a point on the Minkowski difference of the hulls (hull1 - hull2) and the point on hull1 it came from
+struct SupportPoint
+{
+   Locus::FVector3 point;
+   Locus::FVector3 source;
+};
+
+SupportPoint Support(const PlacedHull& hull1, const PlacedHull& hull2, const Locus::FVector3& direction)
+{
+   SupportPoint supportPoint;
+
+   supportPoint.source = hull1.Support(direction);
+   supportPoint.point = supportPoint.source - hull2.Support(-direction);
+
+   return supportPoint;
+}
+
+//the simplex's newest point is last. Reduces the simplex to the feature closest to the
+//origin and points direction at the origin from it. Returns true once the simplex is a
+//tetrahedron that contains the origin. A simplex that can't get any closer to the origin
+//leaves direction at zero
+bool UpdateSimplex(SupportPoint simplex[4], int& size, Locus::FVector3& direction)
+{
+   if (size == 4)
+   {
+      const Locus::FVector3& a = simplex[3].point;
+
+      //the newest point was the farthest along the normal of the triangle toward the origin.
+      //If it is in the triangle's plane, nothing lies beyond the plane and the origin is on it,
+      //so the hulls at most touch. A flat tetrahedron would also leave EPA without a volume
+
+      Locus::FVector3 ab = simplex[0].point - a;
+      Locus::FVector3 ac = simplex[1].point - a;
+      Locus::FVector3 ad = simplex[2].point - a;
+
+      if (std::abs(Dot(Cross(ab, ac), ad)) <= Flat_Tolerance * Norm(ab) * Norm(ac) * Norm(ad))
+      {
+         direction = Locus::Vec3D::ZeroVector();
+
+         return false;
+      }
+
+      //keep the face the origin is in front of, if any
+
+      const int faces[3][3] = { {2, 1, 0}, {1, 0, 2}, {0, 2, 1} };
+
+      for (const int* face : faces)
+      {
+         const Locus::FVector3& b = simplex[face[0]].point;
+         const Locus::FVector3& c = simplex[face[1]].point;
+         const Locus::FVector3& opposite = simplex[face[2]].point;
+
+         Locus::FVector3 normal = Cross(b - a, c - a);
+
+         if (Dot(normal, opposite - a) > 0.0f)
+         {
+            normal = -normal;
+         }
+
+         if (Dot(normal, -a) > 0.0f)
+         {
+            SupportPoint triangle[3] = { simplex[face[1]], simplex[face[0]], simplex[3] };
+
+            simplex[0] = triangle[0];
+            simplex[1] = triangle[1];
+            simplex[2] = triangle[2];
+            size = 3;
+
+            return UpdateSimplex(simplex, size, direction);
+         }
+      }
+
+      return true;
+   }
+
+   if (size == 3)
+   {
+      const Locus::FVector3& a = simplex[2].point;
+      Locus::FVector3 ab = simplex[1].point - a;
+      Locus::FVector3 ac = simplex[0].point - a;
+      Locus::FVector3 ao = -a;
+
+      Locus::FVector3 normal = Cross(ab, ac);
+
+      if (Dot(Cross(normal, ac), ao) > 0.0f)
+      {
+         if (Dot(ac, ao) > 0.0f)
+         {
+            simplex[1] = simplex[2];
+            size = 2;
+
+            direction = Cross(Cross(ac, ao), ac);
+
+            return false;
+         }
+
+         simplex[0] = simplex[1];
+         simplex[1] = simplex[2];
+         size = 2;
+
+         return UpdateSimplex(simplex, size, direction);
+      }
+
+      if (Dot(Cross(ab, normal), ao) > 0.0f)
+      {
+         simplex[0] = simplex[1];
+         simplex[1] = simplex[2];
+         size = 2;
+
+         return UpdateSimplex(simplex, size, direction);
+      }
+
+      direction = (Dot(normal, ao) > 0.0f) ? normal : -normal;
+
+      return false;
+   }
+
+   if (size == 2)
+   {
+      const Locus::FVector3& a = simplex[1].point;
+      Locus::FVector3 ab = simplex[0].point - a;
+      Locus::FVector3 ao = -a;
+
+      if (Dot(ab, ao) > 0.0f)
+      {
+         direction = Cross(Cross(ab, ao), ab);
+      }
+      else
+      {
+         simplex[0] = simplex[1];
+         size = 1;
+
+         direction = ao;
+      }
+
+      return false;
+   }
+
+   direction = -simplex[0].point;
+
+   return false;
+}
+
+NarrowphaseScratch::PolytopeFace MakePolytopeFace(const std::vector<Locus::FVector3>& vertices, std::uint32_t a, std::uint32_t b, std::uint32_t c, const Locus::FVector3& interior)
+{
+   NarrowphaseScratch::PolytopeFace face;
+
+   Locus::FVector3 normal = Cross(vertices[b] - vertices[a], vertices[c] - vertices[a]);
+
+   if (Dot(normal, vertices[a] - interior) < 0.0f)
+   {
+      std::swap(b, c);
+      normal = -normal;
+   }
+
+   face.vertices[0] = a;
+   face.vertices[1] = b;
+   face.vertices[2] = c;
+
+   if (SquaredNorm(normal) > 0.0f)
+   {
+      Normalize(normal);
+
+      face.normal = normal;
+      face.distance = Dot(normal, vertices[a]);
+   }
+   else
+   {
+      //a face with no area is never closest and never seen
+      face.normal = Locus::Vec3D::ZeroVector();
+      face.distance = std::numeric_limits<float>::max();
+   }
+
+   return face;
+}
+
+std::size_t ClosestFace(const std::vector<NarrowphaseScratch::PolytopeFace>& faces)
+{
+   std::size_t closestIndex = 0;
+
+   for (std::size_t faceIndex = 1; faceIndex < faces.size(); ++faceIndex)
+   {
+      if (faces[faceIndex].distance < faces[closestIndex].distance)
+      {
+         closestIndex = faceIndex;
+      }
+   }
+
+   return closestIndex;
+}
+
+}
+
+bool GetConvexContact(const ConvexHull& hull1, const ModelFrame& frame1,
+                      const ConvexHull& hull2, const ModelFrame& frame2,
+                      NarrowphaseScratch& scratch, ConvexContact& contact)
+{
+   scratch.CountQuery();
+
+   PlacedHull placedHull1(hull1, frame1);
+   PlacedHull placedHull2(hull2, frame2);
+
+   //GJK: look for a tetrahedron on the Minkowski difference that contains the origin
+
+   Locus::FVector3 direction = placedHull2.GetOrigin() - placedHull1.GetOrigin();
+
+   if (SquaredNorm(direction) == 0.0f)
+   {
+      direction = Locus::Vec3D::XAxis();
+   }
+
+   SupportPoint simplex[4];
+   int size = 1;
+
+   simplex[0] = Support(placedHull1, placedHull2, direction);
+   direction = -simplex[0].point;
+
+   bool containsOrigin = false;
+
+   for (int iteration = 0; (iteration < Max_GJK_Iterations) && !containsOrigin; ++iteration)
+   {
+      if (SquaredNorm(direction) == 0.0f)
+      {
+         //the origin is on the simplex or in the plane of a flat one, so the hulls only touch
+         return false;
+      }
+
+      SupportPoint supportPoint = Support(placedHull1, placedHull2, direction);
+
+      if (Dot(supportPoint.point, direction) <= 0.0f)
+      {
+         return false;
+      }
+
+      simplex[size++] = supportPoint;
+
+      containsOrigin = UpdateSimplex(simplex, size, direction);
+   }
+
+   if (!containsOrigin)
+   {
+      return false;
+   }
+
+   //EPA: grow the tetrahedron toward the face of the Minkowski difference closest to the origin
+
+   std::vector<Locus::FVector3>& vertices = scratch.polytopeVertices;
+   std::vector<Locus::FVector3>& sources = scratch.polytopeSources;
+   std::vector<NarrowphaseScratch::PolytopeFace>& faces = scratch.polytopeFaces;
+   std::vector<NarrowphaseScratch::IndexPair>& edges = scratch.polytopeEdges;
+
+   vertices.clear();
+   sources.clear();
+   faces.clear();
+
+   for (const SupportPoint& supportPoint : simplex)
+   {
+      scratch.Push(vertices, supportPoint.point);
+      scratch.Push(sources, supportPoint.source);
+   }
+
+   Locus::FVector3 interior = (vertices[0] + vertices[1] + vertices[2] + vertices[3]) / 4.0f;
+
+   scratch.Push(faces, MakePolytopeFace(vertices, 0, 1, 2, interior));
+   scratch.Push(faces, MakePolytopeFace(vertices, 0, 1, 3, interior));
+   scratch.Push(faces, MakePolytopeFace(vertices, 0, 2, 3, interior));
+   scratch.Push(faces, MakePolytopeFace(vertices, 1, 2, 3, interior));
+
+   for (int iteration = 0; iteration < Max_EPA_Iterations; ++iteration)
+   {
+      const NarrowphaseScratch::PolytopeFace& closestFace = faces[ClosestFace(faces)];
+
+      SupportPoint supportPoint = Support(placedHull1, placedHull2, closestFace.normal);
+
+      if (Dot(supportPoint.point, closestFace.normal) - closestFace.distance <= EPA_Tolerance)
+      {
+         break;
+      }
+
+      std::uint32_t newVertex = static_cast<std::uint32_t>(vertices.size());
+
+      scratch.Push(vertices, supportPoint.point);
+      scratch.Push(sources, supportPoint.source);
+
+      //remove the faces the new vertex sees, keeping the edges around them
+
+      edges.clear();
+
+      for (std::size_t faceIndex = 0; faceIndex < faces.size(); )
+      {
+         const NarrowphaseScratch::PolytopeFace& face = faces[faceIndex];
+
+         if (Dot(face.normal, supportPoint.point - vertices[face.vertices[0]]) > 0.0f)
+         {
+            for (int edgeIndex = 0; edgeIndex < 3; ++edgeIndex)
+            {
+               NarrowphaseScratch::IndexPair edge(face.vertices[edgeIndex], face.vertices[(edgeIndex + 1) % 3]);
+
+               std::size_t reverseIndex = 0;
+
+               while ((reverseIndex < edges.size()) && ((edges[reverseIndex].first != edge.second) || (edges[reverseIndex].second != edge.first)))
+               {
+                  ++reverseIndex;
+               }
+
+               if (reverseIndex < edges.size())
+               {
+                  edges[reverseIndex] = edges.back();
+                  edges.pop_back();
+               }
+               else
+               {
+                  scratch.Push(edges, edge);
+               }
+            }
+
+            faces[faceIndex] = faces.back();
+            faces.pop_back();
+         }
+         else
+         {
+            ++faceIndex;
+         }
+      }
+
+      if (edges.empty())
+      {
+         break;
+      }
+
+      for (const NarrowphaseScratch::IndexPair& edge : edges)
+      {
+         scratch.Push(faces, MakePolytopeFace(vertices, edge.first, edge.second, newVertex, interior));
+      }
+   }
+
+   const NarrowphaseScratch::PolytopeFace& closestFace = faces[ClosestFace(faces)];
+
+   if (closestFace.distance == std::numeric_limits<float>::max())
+   {
+      return false;
+   }
+
+   if (closestFace.distance <= EPA_Tolerance)
+   {
+      //the origin is on the boundary of the Minkowski difference, or closer to it than EPA
+      //can tell, so the hulls only touch
+      return false;
+   }
+
+   //the deepest point of hull1 is the point on it that the origin's projection onto the closest face came from
+
+   const Locus::FVector3& a = vertices[closestFace.vertices[0]];
+
+   Locus::FVector3 ab = vertices[closestFace.vertices[1]] - a;
+   Locus::FVector3 ac = vertices[closestFace.vertices[2]] - a;
+   Locus::FVector3 aq = closestFace.normal * closestFace.distance - a;
+
+   float abab = Dot(ab, ab);
+   float abac = Dot(ab, ac);
+   float acac = Dot(ac, ac);
+   float aqab = Dot(aq, ab);
+   float aqac = Dot(aq, ac);
+
+   float denominator = abab * acac - abac * abac;
+
+   float v = 1.0f / 3;
+   float w = 1.0f / 3;
+
+   if (denominator > 0.0f)
+   {
+      v = (acac * aqab - abac * aqac) / denominator;
+      w = (abab * aqac - abac * aqab) / denominator;
+   }
+
+   Locus::FVector3 deepestPoint = sources[closestFace.vertices[0]] * (1.0f - v - w) + sources[closestFace.vertices[1]] * v + sources[closestFace.vertices[2]] * w;
+
+   contact.normal = closestFace.normal;
+   contact.depth = closestFace.distance;
+   contact.point = deepestPoint - contact.normal * (contact.depth / 2);
+
+   return true;
+}
+
+}
\ No newline at end of file
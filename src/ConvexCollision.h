@@ -0,0 +1,41 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include "ModelFrame.h"
+
+namespace MPM
+{
+
+class ConvexHull;
+class NarrowphaseScratch;
+
+struct ConvexContact
+{
+   //midway between the deepest points of the two hulls
+   Locus::FVector3 point;
+
+   //unit length, pointing from the first hull into the second
+   Locus::FVector3 normal;
+
+   float depth;
+};
+
+//Tests two convex hulls, each in its model's frame, for penetration with GJK.
+//If they penetrate, EPA finds the contact: the shortest way to push them apart. The
+//polytope EPA expands lives in scratch, so once it has grown a test doesn't allocate
+bool GetConvexContact(const ConvexHull& hull1, const ModelFrame& frame1,
+                      const ConvexHull& hull2, const ModelFrame& frame2,
+                      NarrowphaseScratch& scratch, ConvexContact& contact);
+
+}
\ No newline at end of file
@@ -0,0 +1,242 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "ConvexHull.h"
+
+#include "Locus/Geometry/Vector3Geometry.h"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cstdint>
+
+namespace MPM
+{
+
+//points closer than this (relative to the size of the model) to a face are on it
+static const float Relative_Hull_Tolerance = 1e-5f;
+
+namespace
+{
+
+struct HullFace
+{
+   std::uint32_t points[3];
+   Locus::FVector3 normal;
+   float offset;
+};
+
+//a face through a, b and c with its normal pointing away from interior
+HullFace MakeHullFace(const std::vector<Locus::FVector3>& points, std::uint32_t a, std::uint32_t b, std::uint32_t c, const Locus::FVector3& interior)
+{
+   HullFace face;
+
+   Locus::FVector3 normal = Cross(points[b] - points[a], points[c] - points[a]);
+
+   if (Dot(normal, interior - points[a]) > 0.0f)
+   {
+      std::swap(b, c);
+      normal = -normal;
+   }
+
+   if (SquaredNorm(normal) > 0.0f)
+   {
+      Normalize(normal);
+   }
+
+   face.points[0] = a;
+   face.points[1] = b;
+   face.points[2] = c;
+   face.normal = normal;
+   face.offset = Dot(normal, points[a]);
+
+   return face;
+}
+
+template <class DistanceFunction>
+std::size_t FarthestPoint(const std::vector<Locus::FVector3>& points, float& farthestDistance, DistanceFunction distance)
+{
+   std::size_t farthestIndex = 0;
+   farthestDistance = -1.0f;
+
+   for (std::size_t pointIndex = 0; pointIndex < points.size(); ++pointIndex)
+   {
+      float pointDistance = distance(points[pointIndex]);
+
+      if (pointDistance > farthestDistance)
+      {
+         farthestIndex = pointIndex;
+         farthestDistance = pointDistance;
+      }
+   }
+
+   return farthestIndex;
+}
+
+}
+
+bool ConvexHull::IsValid() const
+{
+   return !vertices.empty();
+}
+
+const std::vector<Locus::FVector3>& ConvexHull::GetVertices() const
+{
+   return vertices;
+}
+
+const Locus::FVector3& ConvexHull::Support(const Locus::FVector3& direction) const
+{
+   std::size_t supportIndex = 0;
+   float supportDistance = Dot(vertices[0], direction);
+
+   for (std::size_t vertexIndex = 1; vertexIndex < vertices.size(); ++vertexIndex)
+   {
+      float distance = Dot(vertices[vertexIndex], direction);
+
+      if (distance > supportDistance)
+      {
+         supportIndex = vertexIndex;
+         supportDistance = distance;
+      }
+   }
+
+   return vertices[supportIndex];
+}
+
+void ConvexHull::Build(const std::vector<Locus::FVector3>& points)
+{
+   //incremental hull: start from a tetrahedron of far apart points, then add the
+   //points one at a time, replacing the faces each one can see with a fan of faces
+   //from the edges around them to the point
+
+   vertices.clear();
+
+   if (points.size() < 4)
+   {
+      return;
+   }
+
+   float distance;
+
+   std::size_t first = FarthestPoint(points, distance, [&](const Locus::FVector3& point){ return DistanceBetween(point, points[0]); });
+   std::size_t second = FarthestPoint(points, distance, [&](const Locus::FVector3& point){ return DistanceBetween(point, points[first]); });
+
+   float tolerance = Relative_Hull_Tolerance * distance;
+
+   Locus::FVector3 line = points[second] - points[first];
+
+   std::size_t third = FarthestPoint(points, distance, [&](const Locus::FVector3& point){ return Norm(Cross(point - points[first], line)) / Norm(line); });
+
+   if (distance <= tolerance)
+   {
+      return;
+   }
+
+   Locus::FVector3 planeNormal = NormVector(Cross(line, points[third] - points[first]));
+
+   std::size_t fourth = FarthestPoint(points, distance, [&](const Locus::FVector3& point){ return std::abs(Dot(point - points[first], planeNormal)); });
+
+   if (distance <= tolerance)
+   {
+      return;
+   }
+
+   Locus::FVector3 interior = (points[first] + points[second] + points[third] + points[fourth]) / 4.0f;
+
+   std::uint32_t a = static_cast<std::uint32_t>(first);
+   std::uint32_t b = static_cast<std::uint32_t>(second);
+   std::uint32_t c = static_cast<std::uint32_t>(third);
+   std::uint32_t d = static_cast<std::uint32_t>(fourth);
+
+   std::vector<HullFace> faces;
+
+   faces.push_back(MakeHullFace(points, a, b, c, interior));
+   faces.push_back(MakeHullFace(points, a, b, d, interior));
+   faces.push_back(MakeHullFace(points, a, c, d, interior));
+   faces.push_back(MakeHullFace(points, b, c, d, interior));
+
+   std::vector<HullFace> visibleFaces;
+   std::vector<std::pair<std::uint32_t, std::uint32_t>> horizon;
+
+   for (std::size_t pointIndex = 0; pointIndex < points.size(); ++pointIndex)
+   {
+      const Locus::FVector3& point = points[pointIndex];
+
+      visibleFaces.clear();
+
+      for (std::size_t faceIndex = 0; faceIndex < faces.size(); )
+      {
+         if (Dot(faces[faceIndex].normal, point) - faces[faceIndex].offset > tolerance)
+         {
+            visibleFaces.push_back(faces[faceIndex]);
+
+            faces[faceIndex] = faces.back();
+            faces.pop_back();
+         }
+         else
+         {
+            ++faceIndex;
+         }
+      }
+
+      if (visibleFaces.empty())
+      {
+         continue;
+      }
+
+      //the horizon is made of the edges of visible faces that aren't shared with another visible face
+
+      horizon.clear();
+
+      for (const HullFace& face : visibleFaces)
+      {
+         for (int edgeIndex = 0; edgeIndex < 3; ++edgeIndex)
+         {
+            std::pair<std::uint32_t, std::uint32_t> edge(face.points[edgeIndex], face.points[(edgeIndex + 1) % 3]);
+
+            std::vector<std::pair<std::uint32_t, std::uint32_t>>::iterator reverseEdge = std::find(horizon.begin(), horizon.end(), std::make_pair(edge.second, edge.first));
+
+            if (reverseEdge != horizon.end())
+            {
+               *reverseEdge = horizon.back();
+               horizon.pop_back();
+            }
+            else
+            {
+               horizon.push_back(edge);
+            }
+         }
+      }
+
+      for (const std::pair<std::uint32_t, std::uint32_t>& edge : horizon)
+      {
+         faces.push_back(MakeHullFace(points, edge.first, edge.second, static_cast<std::uint32_t>(pointIndex), interior));
+      }
+   }
+
+   //the hull's vertices are the points its faces use
+
+   std::vector<bool> onHull(points.size(), false);
+
+   for (const HullFace& face : faces)
+   {
+      for (std::uint32_t facePoint : face.points)
+      {
+         if (!onHull[facePoint])
+         {
+            onHull[facePoint] = true;
+            vertices.push_back(points[facePoint]);
+         }
+      }
+   }
+}
+
+}
\ No newline at end of file
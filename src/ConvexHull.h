@@ -0,0 +1,66 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include "Locus/Geometry/Triangle.h"
+#include "Locus/Geometry/Transformation.h"
+
+#include <vector>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+//The vertices of the convex hull of a model, in model space. Convex shapes can be
+//tested against each other with GJK and EPA (see ConvexCollision.h), which only need
+//the point of the hull farthest along a direction
+class ConvexHull
+{
+public:
+   template <class ModelType>
+   explicit ConvexHull(const ModelType& model)
+   {
+      std::size_t numFaces = model.NumFaces();
+
+      std::vector<Locus::FVector3> points;
+      points.reserve(numFaces * Locus::Triangle3D_t::NumPointsOnATriangle);
+
+      for (std::size_t faceIndex = 0; faceIndex < numFaces; ++faceIndex)
+      {
+         Locus::Triangle3D_t triangle = model.GetFaceTriangle(faceIndex, Locus::Transformation::Identity());
+
+         for (std::size_t pointIndex = 0; pointIndex < Locus::Triangle3D_t::NumPointsOnATriangle; ++pointIndex)
+         {
+            points.push_back(triangle[pointIndex]);
+         }
+      }
+
+      Build(points);
+   }
+
+   //false if the model is too flat to have a hull with volume
+   bool IsValid() const;
+
+   const std::vector<Locus::FVector3>& GetVertices() const;
+
+   //the vertex farthest along direction
+   const Locus::FVector3& Support(const Locus::FVector3& direction) const;
+
+private:
+   void Build(const std::vector<Locus::FVector3>& points);
+
+   std::vector<Locus::FVector3> vertices;
+};
+
+}
\ No newline at end of file
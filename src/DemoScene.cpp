@@ -11,19 +11,17 @@
 #include "DemoScene.h"
 #include "Config.h"
 #include "Asteroid.h"
-#include "Shot.h"
+#include "ModelFrame.h"
+#include "ShotDrawable.h"
 #include "Planet.h"
 #include "PauseScene.h"
-#include "SAPReading.h"
-
-#include "Locus/Common/Random.h"
+#include "Random.h"
 
 #include "Locus/FileSystem/FileSystemUtil.h"
 #include "Locus/FileSystem/MountedFilePath.h"
 
 #include "Locus/Geometry/Geometry.h"
 #include "Locus/Geometry/Line.h"
-#include "Locus/Geometry/Frustum.h"
 
 #include "Locus/Rendering/MeshUtility.h"
 #include "Locus/Rendering/DrawUtility.h"
@@ -41,10 +39,11 @@
 
 #include "Locus/Rendering/Locus_glew.h"
 
-#include <stack>
+#include <algorithm>
 #include <unordered_map>
 #include <stdexcept>
 #include <fstream>
+#include <iostream>
 
 #include <cmath>
 
@@ -54,17 +53,10 @@
 
 #define SKY_BOX_RADIUS 100
 
-#define ASTEROID_SPACING_THRESHOLD 0
-#define MAX_ASTEROID_HITS 20
-#define MIN_ASTEROID_SCALE 10
-#define MAX_ASTEROID_SCALE 30
-
 #define FIELD_OF_VIEW 30
 #define Z_NEAR 0.01f
 
 #define FRUSTUM_VERTICAL_FIELD_OF_VIEW (1.9f * FIELD_OF_VIEW)
-#define FRUSTUM_NEAR_DISTANCE 0.01f
-#define FRUSTUM_FAR_DISTANCE (STAR_DISTANCE * 4)
 
 namespace MPM
 {
@@ -84,7 +76,9 @@ static const Locus::Key_t KEY_LIGHTS = Locus::Key_L;
 
 DemoScene::DemoScene(Locus::SceneManager& sceneManager, unsigned int resolutionX, unsigned int resolutionY)
    : Scene(sceneManager),
+     simulation((Config::GetWorldSeed() != 0) ? Config::GetWorldSeed() : MPM::Random::MakeSeed()),
      dieOnNextFrame(false),
+     player(simulation.GetPlayer()),
      maxLights(1),
      notTexturedNotLitProgramID(Locus::BAD_ID),
      texturedNotLitProgramID(Locus::BAD_ID),
@@ -92,18 +86,29 @@ DemoScene::DemoScene(Locus::SceneManager& sceneManager, unsigned int resolutionX
      resolutionY(resolutionY),
      lastMouseX(0),
      lastMouseY(0),
-     score(0),
      lives(3),
      level(1),
      crosshairsX(resolutionX/2),
      crosshairsY(resolutionY/2),
-     skyBox(SKY_BOX_RADIUS)
+     skyBox(SKY_BOX_RADIUS),
+     asteroidTextureIndex(0),
+     interpolationFactor(0.0f),
+     drawStatistics(),
+     drawStatisticsTime(0.0)
 {
-   ParseSAPFile(Locus::MountedFilePath("data/" + Config::GetModelFile()), asteroidMeshes);
+   simulation.SetListener(this);
 
    Load();
 }
 
+DemoScene::~DemoScene()
+{
+   for (Asteroid* meshSource : sharedMeshSources)
+   {
+      meshSource->DeleteGPUVertexData();
+   }
+}
+
 void DemoScene::Load()
 {
    minPlanetDistance = 2 * Config::GetAsteroidsBoundary() * 1.414213562373f + Config::GetMaxPlanetRadius() + 5;
@@ -111,6 +116,8 @@ void DemoScene::Load()
    starDistance = maxPlanetDistance + 50.0f;
    z_far = 4.0f * starDistance;
 
+   UpdateViewFrustum();
+
    LoadRenderingState();
    InitializeRenderingState();
    LoadTextures();
@@ -137,6 +144,9 @@ void DemoScene::LoadRenderingState()
 
    LoadShaderPrograms();
    LoadLights();
+
+   //without instancing, the shots and the asteroids are drawn one by one
+   instancedProgram.Load();
 }
 
 void DemoScene::LoadShaderPrograms()
@@ -205,7 +215,9 @@ void DemoScene::InitializeRenderingState()
    renderingState->SetOpenGLStateToDefault();
 
    renderingState->transformationStack.SetTransformationMode(Locus::TransformationStack::Projection);
-   renderingState->transformationStack.Load( Locus::Transformation::Perspective(FIELD_OF_VIEW, static_cast<float>(resolutionX)/resolutionY, Z_NEAR, z_far) );
+   projection = Locus::Transformation::Perspective(FIELD_OF_VIEW, static_cast<float>(resolutionX)/resolutionY, Z_NEAR, z_far);
+
+   renderingState->transformationStack.Load(projection);
 
    renderingState->transformationStack.SetTransformationMode(Locus::TransformationStack::ModelView);
    renderingState->transformationStack.LoadIdentity();
@@ -218,15 +230,17 @@ void DemoScene::LoadTextures()
    textureManager->LoadAllTextures();
 
    GLuint textureIndex = 0;
-   for (std::unique_ptr<Asteroid>& asteroid : asteroids)
+   for (Asteroid* asteroid : simulation.GetAsteroids())
    {
       textureIndex = (textureIndex + 1) % static_cast<GLuint>(textureManager->NumAsteroidTextures());
       asteroid->SetTexture( textureManager->GetTexture(MPM::TextureManager::MakeAsteroidTextureName(textureIndex)) );
    }
 
+   MPM::Random planetTextureRandom(simulation.GetWorldSeed(), RandomStream_PlanetTextures);
+
    for (std::unique_ptr<Planet>& planet : planets)
    {
-      planet->RandomizeTexture(*textureManager);
+      planet->RandomizeTexture(*textureManager, planetTextureRandom);
    }
 }
 
@@ -247,13 +261,26 @@ void DemoScene::InitializeMeshes()
    planetMesh->CreateGPUVertexData();
    planetMesh->UpdateGPUVertexData();
 
-   shotMesh = Locus::MeshUtility::MakeIcosahedron(SHOT_RADIUS);
+   shotMesh = std::make_unique<InstancedMesh>();
+   shotMesh->CopyFrom( *Locus::MeshUtility::MakeIcosahedron(SHOT_RADIUS) );
    shotMesh->gpuVertexDataTransferInfo.sendColors = false;
    shotMesh->gpuVertexDataTransferInfo.sendNormals = false;
 
    shotMesh->CreateGPUVertexData();
    shotMesh->UpdateGPUVertexData();
 
+   shotDrawables.clear();
+
+   for (const Locus::Color& lightColor : lightColors)
+   {
+      std::unique_ptr<ShotDrawable> shotDrawable = std::make_unique<ShotDrawable>(lightColor, shotMesh.get());
+
+      shotDrawable->CreateGPUVertexData();
+      shotDrawable->UpdateGPUVertexData();
+
+      shotDrawables.push_back( std::move(shotDrawable) );
+   }
+
    InitializeSkyBoxAndHUD();
 }
 
@@ -279,7 +306,7 @@ void DemoScene::InitializeStars()
    //randomly place a set amount of stars on the surface of a sphere
    //of radius STAR_DISTANCE centered at the origin
 
-   Locus::Random random;
+   MPM::Random random(simulation.GetWorldSeed(), RandomStream_Stars);
 
    std::vector<Locus::FVector3> starPositions(Config::GetNumStars());
    std::vector<Locus::Color> starColors(Config::GetNumStars());
@@ -330,7 +357,7 @@ void DemoScene::InitializePlanets()
    //randomly place a certain amount of planets (between MIN_PLANETS and MAX_PLANETS) a certain distance
    //away (between MIN_PLANET_DISTANCE and MAX_PLANET_DISTANCE) from the origin.
 
-   Locus::Random r;
+   MPM::Random r(simulation.GetWorldSeed(), RandomStream_Planets);
 
    int maxTries = 10;
 
@@ -392,298 +419,61 @@ void DemoScene::InitializePlanets()
 
 void DemoScene::InitializeAsteroids()
 {
-   for (std::unique_ptr<Asteroid>& asteroid : asteroids)
-   {
-      asteroid->DeleteGPUVertexData();
-   }
-
-   asteroids.clear();
-
-   collisionManager.Clear();
-
-   shots.clear();
-
-   //////////////////////////////////////////////////////////////////////
-
-   Locus::Random r;
-
-   GLuint textureIndex = 0;
-
-   asteroids.resize(Config::GetNumAsteroids());
-
-   std::size_t numAsteroidMeshes = asteroidMeshes.size();
-
-   std::vector<Asteroid> asteroidTemplates(numAsteroidMeshes);
-   for (std::size_t asteroidTemplateIndex = 0; asteroidTemplateIndex < numAsteroidMeshes; ++asteroidTemplateIndex)
-   {
-      asteroidTemplates[asteroidTemplateIndex].GrabMesh(*asteroidMeshes[asteroidTemplateIndex]);
-      asteroidTemplates[asteroidTemplateIndex].CreateBoundingVolumeHierarchy();
-   }
-
-   std::size_t numAsteroidTemplates = asteroidTemplates.size();
-
-   collisionManager.StartAddRemoveBatch();
-
-   player.SetModel(Config::GetPlayerCollisionRadius());
-   collisionManager.Add(&player);
-
-   float minAsteroidDistance = 0.0f;
-   float maxAsteroidDistance = Config::GetAsteroidsBoundary() - 5.0f;
-
-   std::size_t whichMesh = 0;
-
-   for (int i = 0; i < Config::GetNumAsteroids(); ++i)
-   {
-      //get asteroid type
-
-      asteroids[i] = std::make_unique<Asteroid>(MAX_ASTEROID_HITS);
-      asteroids[i]->GrabMeshAndCollidable(asteroidTemplates[whichMesh]);
-
-      whichMesh = (whichMesh + 1) % numAsteroidTemplates;
-
-      //randomize direction
-      float xDirection = static_cast<float>(r.RandomDouble(-1, 1));
-      float yDirection = static_cast<float>(r.RandomDouble(-1, 1));
-      float zDirection = static_cast<float>(r.RandomDouble(-1, 1));
-
-      asteroids[i]->motionProperties.direction.Set(xDirection, yDirection, zDirection);
-      Normalize(asteroids[i]->motionProperties.direction);
-
-      //randomize speed
-      asteroids[i]->motionProperties.speed = static_cast<float>(r.RandomDouble(Config::GetMinAsteroidSpeed(), Config::GetMaxAsteroidSpeed()));
-
-      //randomize rotation direction
-      xDirection = static_cast<float>(r.RandomDouble(-1, 1));
-      yDirection = static_cast<float>(r.RandomDouble(-1, 1));
-      zDirection = static_cast<float>(r.RandomDouble(-1, 1));
-
-      asteroids[i]->motionProperties.rotation.Set(xDirection, yDirection, zDirection);
-      
-      //randomize rotation speed
-      asteroids[i]->motionProperties.angularSpeed = static_cast<float>(r.RandomDouble(Config::GetMinAsteroidRotationSpeed(), Config::GetMaxAsteroidRotationSpeed()));
-
-      //randomize size
-      float scale = static_cast<float>(r.RandomDouble(MIN_ASTEROID_SCALE, MAX_ASTEROID_SCALE));
-      asteroids[i]->Scale( Locus::FVector3(scale, scale, scale) );
-
-      //randomize position (centroid)
-      Locus::FVector3 asteroidPosition;
-      bool goodLocation = false;
-
-      while (!goodLocation)
-      {
-         goodLocation = true;
-
-         bool goodPoint = false;
-
-         while (!goodPoint)
-         {
-            asteroidPosition.x = static_cast<float>(r.RandomDouble(-maxAsteroidDistance, maxAsteroidDistance));
-            asteroidPosition.y = static_cast<float>(r.RandomDouble(-maxAsteroidDistance, maxAsteroidDistance));
-            asteroidPosition.z = static_cast<float>(r.RandomDouble(-maxAsteroidDistance, maxAsteroidDistance));
+   asteroidTextureIndex = 0;
 
-            goodPoint = DistanceBetween(asteroidPosition, Locus::Vec3D::ZeroVector()) >= minAsteroidDistance;
-         }
-
-         for (int previousAsteroidIndex = 0; previousAsteroidIndex < i; ++previousAsteroidIndex)
-         {
-            if (DistanceBetween(asteroids[previousAsteroidIndex]->Position(), asteroidPosition) <= ASTEROID_SPACING_THRESHOLD)
-            {
-               goodLocation = false;
-               break;
-            }
-         }
-      } 
-
-      asteroids[i]->Translate(asteroidPosition);
-
-      textureIndex = (textureIndex + 1) % static_cast<GLuint>(textureManager->NumAsteroidTextures());
-      asteroids[i]->SetTexture( textureManager->GetTexture(MPM::TextureManager::MakeAsteroidTextureName(textureIndex)) );
-
-      asteroids[i]->CreateGPUVertexData();
-      asteroids[i]->UpdateGPUVertexData();
-      asteroids[i]->UpdateMaxDistanceToCenter();
-      asteroids[i]->UpdateBroadCollisionExtent();
-
-      collisionManager.Add(asteroids[i].get());
-   }
-
-   collisionManager.FinishAddRemoveBatch();
+   simulation.InitializeAsteroids();
 }
 
 void DemoScene::ShotFired()
 {
-   if (shots.size() < Config::GetNumShots())
-   {
-      std::unique_ptr<Shot> shot( std::make_unique<Shot>(player.viewpoint.GetForward(), player.viewpoint.GetPosition() + player.viewpoint.GetForward(), shotMesh.get()) );
-      shot->UpdateBroadCollisionExtent();
-
-      std::size_t numLightColors = lightColors.size();
-
-      shot->color = lightColors[currentLightColorIndex];
-
-      currentLightColorIndex = (currentLightColorIndex + 1) % numLightColors;
-
-      collisionManager.Add(shot.get());
-
-      shot->CreateGPUVertexData();
-      shot->UpdateGPUVertexData();
-
-      shots.push_back( std::move(shot) );
-
-      shotSoundEffect->Play();
-   }
+   simulation.FireShot(static_cast<unsigned int>(currentLightColorIndex));
 }
 
-void DemoScene::UpdateShotPositions(double DT)
+void DemoScene::AsteroidCreated(Asteroid& asteroid)
 {
-   std::size_t numShots = shots.size();
-
-   std::stack<std::size_t> shotsToRemove;
-
-   float boundary = Config::GetAsteroidsBoundary();
+   //split asteroids keep the texture of the asteroid they were split from
+   if (asteroid.GetTexture() == nullptr)
+   {
+      asteroidTextureIndex = (asteroidTextureIndex + 1) % textureManager->NumAsteroidTextures();
+      asteroid.SetTexture( textureManager->GetTexture(MPM::TextureManager::MakeAsteroidTextureName(asteroidTextureIndex)) );
+   }
 
-   float shotDistance = Norm(Locus::FVector3(boundary, boundary, boundary));
+   //asteroids sharing a mesh share its GPU vertex data too, which is made the first time
+   //one of them is created and kept as long as the mesh
+   Asteroid& meshSource = asteroid.GetMeshSource();
 
-   //check if shots go beyond the boundary. If they do, remove them
-   for (std::size_t shotIndex = 0; shotIndex < numShots; ++shotIndex)
+   if (!meshSource.HasGPUVertexData())
    {
-      if (shots[shotIndex]->IsValid())
-      {
-         shots[shotIndex]->MoveAlongDirection(static_cast<float>(DT) * Config::GetShotSpeed());
+      meshSource.CreateGPUVertexData();
+      meshSource.UpdateGPUVertexData();
 
-         if (DistanceBetween(shots[shotIndex]->GetPosition(), Locus::Vec3D::ZeroVector()) >= shotDistance)
-         {
-            shotsToRemove.push(shotIndex);
-         }
-         else
-         {
-            shots[shotIndex]->UpdateBroadCollisionExtent();
-
-            collisionManager.Update(shots[shotIndex].get());
-         }
-      }
-      else
+      if (asteroid.SharesMesh())
       {
-         shotsToRemove.push(shotIndex);
+         sharedMeshSources.push_back(&meshSource);
       }
    }
+}
 
-   if (!shotsToRemove.empty())
+void DemoScene::AsteroidDestroyed(Asteroid& asteroid)
+{
+   if (!asteroid.SharesMesh())
    {
-      collisionManager.StartAddRemoveBatch();
-
-      //remove the shots in backwards order as this is more efficient for vectors
-      do
-      {
-         std::size_t indexOfShotToRemove = shotsToRemove.top();
-         shotsToRemove.pop();
-
-         collisionManager.Remove(shots[indexOfShotToRemove].get());
-
-         shots.erase(shots.begin() + indexOfShotToRemove);
-
-      } while (!shotsToRemove.empty());
-
-      collisionManager.FinishAddRemoveBatch();
+      asteroid.DeleteGPUVertexData();
    }
 }
 
-Locus::Plane DemoScene::MakeHalfSplitPlane(const Locus::FVector3& shotPosition, const Locus::FVector3& asteroidCentroid)
+void DemoScene::ShotCreated()
 {
-   Locus::Plane orthogonalPlane(asteroidCentroid, player.viewpoint.GetForward());
-   Locus::FVector3 shotProjection = orthogonalPlane.getProjection(shotPosition);
+   std::size_t numLightColors = lightColors.size();
 
-   Locus::FVector3 normal = shotProjection - asteroidCentroid;
-   RotateAround(normal, -player.viewpoint.GetForward(), Locus::PI/2);
+   currentLightColorIndex = (currentLightColorIndex + 1) % numLightColors;
 
-   return Locus::Plane(asteroidCentroid, normal);
+   shotSoundEffect->Play();
 }
 
-void DemoScene::SplitAsteroid(std::size_t splitIndex, const Locus::FVector3& shotPosition)
+void DemoScene::AsteroidsHit()
 {
-   //split an asteroid in two. If it has no more hits left,
-   //simply remove the asteroid from the game
-
-   ++score;
-
-   asteroids[splitIndex]->decreaseHitsLeft();
-
-   int hitsLeft = asteroids[splitIndex]->getHitsLeft();
-
-   if (hitsLeft > 0)
-   {
-      std::unique_ptr<Asteroid> splitAsteroid1( std::make_unique<Asteroid>(hitsLeft) );
-      std::unique_ptr<Asteroid> splitAsteroid2( std::make_unique<Asteroid>(hitsLeft) );
-
-      Locus::Random random;
-
-      float xRotationDirection = static_cast<float>( random.RandomDouble(-1, 1) );
-      float yRotationDirection = static_cast<float>( random.RandomDouble(-1, 1) );
-      float zRotationDirection = static_cast<float>( random.RandomDouble(-1, 1) );
-
-      splitAsteroid1->motionProperties.rotation.Set(xRotationDirection, yRotationDirection, zRotationDirection);
-      splitAsteroid2->motionProperties.rotation.Set(xRotationDirection, yRotationDirection, zRotationDirection);
-
-      std::unique_ptr<Asteroid>& asteroidToSplit = asteroids[splitIndex];
-
-      splitAsteroid1->motionProperties.angularSpeed = asteroidToSplit->motionProperties.angularSpeed;
-      splitAsteroid2->motionProperties.angularSpeed = asteroidToSplit->motionProperties.angularSpeed;
-
-      splitAsteroid1->SetTexture(asteroidToSplit->GetTexture());
-      splitAsteroid2->SetTexture(asteroidToSplit->GetTexture());
-
-      Locus::Plane splitPlane = MakeHalfSplitPlane(shotPosition, asteroidToSplit->Position());
-
-      asteroidToSplit->DetermineSplit(splitPlane, asteroidToSplit->CurrentModelTransformation(), *splitAsteroid1, *splitAsteroid2);
-
-      if ((splitAsteroid1->NumFaces() > 0) && (splitAsteroid2->NumFaces() > 0))
-      {
-         splitAsteroid1->Reset(splitAsteroid1->centroid);
-         splitAsteroid2->Reset(splitAsteroid2->centroid);
-
-         splitAsteroid1->motionProperties.speed = asteroidToSplit->motionProperties.speed;
-         splitAsteroid2->motionProperties.speed = asteroidToSplit->motionProperties.speed;
-
-         splitAsteroid1->motionProperties.direction = splitPlane.getNormal();
-         Normalize(splitAsteroid1->motionProperties.direction);
-
-         splitAsteroid2->motionProperties.direction = -(splitAsteroid1->motionProperties.direction);
-
-         //avoiding immediate interpenetration
-         splitAsteroid1->lastCollision = splitAsteroid2.get();
-         splitAsteroid2->lastCollision = splitAsteroid1.get();
-
-         splitAsteroid1->lastCollisionTime = splitAsteroid2->lastCollisionTime = std::chrono::high_resolution_clock::now();
-
-         splitAsteroid1->AssignNormals();
-         splitAsteroid2->AssignNormals();
-
-         splitAsteroid1->CreateGPUVertexData();
-         splitAsteroid1->UpdateGPUVertexData();
-         splitAsteroid1->UpdateMaxDistanceToCenter();
-         splitAsteroid1->UpdateBroadCollisionExtent();
-         splitAsteroid1->CreateBoundingVolumeHierarchy();
-
-         splitAsteroid2->CreateGPUVertexData();
-         splitAsteroid2->UpdateGPUVertexData();
-         splitAsteroid2->UpdateMaxDistanceToCenter();
-         splitAsteroid2->UpdateBroadCollisionExtent();
-         splitAsteroid2->CreateBoundingVolumeHierarchy();
-
-         collisionManager.Add(splitAsteroid1.get());
-         collisionManager.Add(splitAsteroid2.get());
-
-         asteroids.emplace_back( std::move(splitAsteroid1) );
-         asteroids.emplace_back( std::move(splitAsteroid2) );
-      }
-   }
-
-   asteroids[splitIndex]->DeleteGPUVertexData();
-
-   collisionManager.Remove(asteroids[splitIndex].get());
-
-   asteroids.erase(asteroids.begin() + splitIndex);
+   asteroidShotCollisionSoundEffect->Play();
 }
 
 //////////////////////////////////////Events//////////////////////////////////////////
@@ -805,7 +595,9 @@ void DemoScene::Resized(int width, int height)
    crosshairsX = (resolutionX / 2);
    crosshairsY = (resolutionY / 2);
 
-   hud.Update(score, level, lives, shots.size(), crosshairsX, crosshairsY, 1);
+   UpdateViewFrustum();
+
+   hud.Update(simulation.GetScore(), level, lives, simulation.GetShots().Size(), crosshairsX, crosshairsY, 1);
 }
 
 void DemoScene::Activate()
@@ -822,6 +614,12 @@ void DemoScene::UpdateLastMousePosition()
    sceneManager.GetMousePosition(lastMouseX, lastMouseY);
 }
 
+void DemoScene::UpdateViewFrustum()
+{
+   //TODO: Fix fudging going on here
+   simulation.SetViewFrustum(2.5f * FIELD_OF_VIEW * (static_cast<float>(resolutionX)/resolutionY), FRUSTUM_VERTICAL_FIELD_OF_VIEW, starDistance * 4.0f);
+}
+
 bool DemoScene::Update(double DT)
 {
    if (dieOnNextFrame)
@@ -829,92 +627,37 @@ bool DemoScene::Update(double DT)
       return false;
    }
 
-   player.tick(DT);
-   collisionManager.Update(&player);
-
-   TickAsteroids(DT);
-   UpdateShotPositions(DT);
-
-   collisionManager.UpdateCollisions();
-   collisionManager.TransmitCollisions();
+   simulation.Advance(DT);
 
-   CheckForAsteroidHits();
+   hud.Update(simulation.GetScore(), level, lives, simulation.GetShots().Size(), crosshairsX, crosshairsY, static_cast<int>(1 / DT));
 
-   hud.Update(score, level, lives, shots.size(), crosshairsX, crosshairsY, static_cast<int>(1 / DT));
+   ReportDrawStatistics(DT);
 
    return true;
 }
 
-void DemoScene::TickAsteroids(double DT)
+void DemoScene::ReportDrawStatistics(double DT)
 {
-   //this function updates all asteroids' positions. If an asteroid is
-   //about to go beyond the asteroid boundary, it bounces off the side.
-   //This function also updates the visible asteroids and checks and responds 
-   //to asteroid-to-asteroid collisions
+   double interval = Config::GetDrawStatisticsInterval();
 
-   //update asteroid positions
-   for (std::unique_ptr<Asteroid>& asteroid : asteroids)
+   if (interval <= 0.0)
    {
-      Locus::FVector3 nextPosition = asteroid->Position() + ((asteroid->motionProperties.speed * asteroid->motionProperties.direction) * static_cast<float>(DT));
-
-      if (std::abs(nextPosition.x) >= Config::GetAsteroidsBoundary())
-      {
-         asteroid->negateXDirection();
-      }
-      if (std::abs(nextPosition.y) >= Config::GetAsteroidsBoundary())
-      {
-         asteroid->negateYDirection();
-      }
-      if (std::abs(nextPosition.z) >= Config::GetAsteroidsBoundary())
-      {
-         asteroid->negateZDirection();
-      }
-
-      asteroid->tick(DT);
-      asteroid->UpdateBroadCollisionExtent();
-
-      collisionManager.Update(asteroid.get());
+      return;
    }
 
-   //update asteroid visibility with camera frustum
-
-   Locus::FVector3 forward = player.viewpoint.GetForward();
-   Locus::FVector3 up = player.viewpoint.GetUp();
+   drawStatisticsTime += DT;
 
-   Locus::FVector3 point = player.viewpoint.GetPosition();
-
-   //TODO: Fix fudging going on here
-   Locus::Frustum viewFrustum(point, forward, up, 2.5f * FIELD_OF_VIEW * (static_cast<float>(resolutionX)/resolutionY), FRUSTUM_VERTICAL_FIELD_OF_VIEW, FRUSTUM_NEAR_DISTANCE, starDistance * 4.0f);
-
-   for (std::unique_ptr<Asteroid>& asteroid : asteroids)
+   if ((drawStatisticsTime >= interval) && (drawStatistics.numFrames > 0))
    {
-      asteroid->visible = viewFrustum.Within(asteroid->Position(), asteroid->GetMaxDistanceToCenter());
-   }
-}
+      double numFrames = static_cast<double>(drawStatistics.numFrames);
 
-void DemoScene::CheckForAsteroidHits()
-{
-   bool hadAnyHits = false;
+      std::cout << "frames: " << drawStatistics.numFrames
+                << "  asteroids: " << simulation.GetAsteroids().size()
+                << "  asteroid draw calls/frame: " << (drawStatistics.numAsteroidDrawCalls / numFrames)
+                << "  instanced asteroids/frame: " << (drawStatistics.numInstancedAsteroids / numFrames) << std::endl;
 
-   for (int asteroidIndex = static_cast<int>(asteroids.size() - 1); asteroidIndex >= 0; --asteroidIndex)
-   {
-      if (asteroids[asteroidIndex]->WasHit())
-      {
-         if (!hadAnyHits)
-         {
-            collisionManager.StartAddRemoveBatch();
-         }
-
-         SplitAsteroid(asteroidIndex, asteroids[asteroidIndex]->GetHitLocation());
-
-         hadAnyHits = true;
-      }
-   }
-
-   if (hadAnyHits)
-   {
-      asteroidShotCollisionSoundEffect->Play();
-      collisionManager.FinishAddRemoveBatch();
+      drawStatistics = DrawStatistics();
+      drawStatisticsTime = 0.0;
    }
 }
 
@@ -922,6 +665,11 @@ void DemoScene::Draw()
 {
    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+   ++drawStatistics.numFrames;
+
+   interpolationFactor = simulation.GetInterpolationFactor();
+   cameraOffset = player.viewpoint.GetPosition() - player.GetInterpolatedPosition(interpolationFactor);
+
    DrawSkyBox();
    DrawStars();
    DrawPlanets();
@@ -993,50 +741,35 @@ void DemoScene::DrawAsteroids()
 {
    bool shaderChanged = false;
 
-   struct ShotPositionAndDistance
-   {
-      const Shot* shot;
-      Locus::FVector3 position;
-      float squaredDistance;
-
-      bool operator <(const ShotPositionAndDistance& other) const
-      {
-         return squaredDistance < other.squaredDistance;
-      }
-   };
+   const ShotBuffer& shots = simulation.GetShots();
+   std::size_t numShots = shots.Size();
 
-   ShotPositionAndDistance singleShotPositionAndDistance;
+   shotPositionsAndDistances.resize(numShots);
 
-   std::vector<ShotPositionAndDistance> shotPositionsAndDistances;
-   shotPositionsAndDistances.reserve(shots.size());
-
-   for (const std::unique_ptr<Shot>& shot : shots)
+   for (std::size_t shotIndex = 0; shotIndex < numShots; ++shotIndex)
    {
-      if (shot->IsValid())
-      {
-         singleShotPositionAndDistance.shot = shot.get();
-         singleShotPositionAndDistance.position = shot->GetPosition();
-         singleShotPositionAndDistance.squaredDistance = SquaredNorm(singleShotPositionAndDistance.position - player.viewpoint.GetPosition());
+      ShotPositionAndDistance& shotPositionAndDistance = shotPositionsAndDistances[shotIndex];
 
-         shotPositionsAndDistances.push_back(singleShotPositionAndDistance);
-      }
+      shotPositionAndDistance.colorIndex = shots.GetColorIndex(shotIndex);
+      shotPositionAndDistance.position = shots.GetInterpolatedPosition(shotIndex, interpolationFactor) + cameraOffset;
+      shotPositionAndDistance.squaredDistance = SquaredNorm(shotPositionAndDistance.position - player.viewpoint.GetPosition());
    }
 
-   std::size_t numShotsAndPositions = shotPositionsAndDistances.size();
    unsigned int numShotPositionsToUse = 0;
 
-   if (numShotsAndPositions > 0)
+   if (numShots > 0)
    {
-      std::sort(shotPositionsAndDistances.begin(), shotPositionsAndDistances.end());
+      numShotPositionsToUse = (numShots > maxLights) ? maxLights : static_cast<unsigned int>(numShots);
 
-      numShotPositionsToUse = (numShotsAndPositions > maxLights) ? maxLights : numShotsAndPositions;
+      //only the nearest shots light the asteroids, so there's no need to sort the rest
+      std::partial_sort(shotPositionsAndDistances.begin(), shotPositionsAndDistances.begin() + numShotPositionsToUse, shotPositionsAndDistances.end());
 
       renderingState->shaderController.UseProgram(litProgramIDs[numShotPositionsToUse - 1]);
 
       for (unsigned int shotPositionIndex = 0; shotPositionIndex < numShotPositionsToUse; ++shotPositionIndex)
       {
          lights[shotPositionIndex].eyePosition = player.viewpoint.ToEyePosition(shotPositionsAndDistances[shotPositionIndex].position);
-         lights[shotPositionIndex].diffuseColor = shotPositionsAndDistances[shotPositionIndex].shot->color;
+         lights[shotPositionIndex].diffuseColor = lightColors[shotPositionsAndDistances[shotPositionIndex].colorIndex];
 
          renderingState->shaderController.SetLightUniforms(shotPositionIndex, lights[shotPositionIndex]);
       }
@@ -1046,20 +779,78 @@ void DemoScene::DrawAsteroids()
 
    renderingState->shaderController.SetTextureUniform(Locus::ShaderSource::Map_Diffuse, 0);
 
-   player.viewpoint.Activate(renderingState->transformationStack);
+   //asteroids made from the fracture library are drawn instanced, in one draw call per
+   //mesh source and texture. Fragments cut at runtime have a mesh of their own, so they
+   //are drawn one by one
+   asteroidInstances.clear();
 
-   for (const std::unique_ptr<Asteroid>& asteroid : asteroids)
+   for (Asteroid* asteroid : simulation.GetAsteroids())
    {
-      if (asteroid->visible)
+      if (!asteroid->visible)
       {
-         asteroid->GetTexture()->Bind();
+         continue;
+      }
 
-         renderingState->transformationStack.UploadTransformations(renderingState->shaderController, asteroid->CurrentModelTransformation());
-         asteroid->Draw(*renderingState);
+      if (asteroid->SharesMesh() && instancedProgram.IsLoaded())
+      {
+         asteroidInstances.push_back({ &asteroid->GetMeshSource(), asteroid->GetTexture(), asteroid });
+         continue;
       }
+
+      asteroid->GetTexture()->Bind();
+
+      player.viewpoint.Activate(renderingState->transformationStack);
+
+         renderingState->transformationStack.Translate(cameraOffset + asteroid->GetInterpolationOffset(interpolationFactor));
+         renderingState->transformationStack.UploadTransformations(renderingState->shaderController, asteroid->CurrentModelTransformation());
+
+         asteroid->GetMeshSource().Draw(*renderingState);
+
+      player.viewpoint.Deactivate(renderingState->transformationStack);
+
+      ++drawStatistics.numAsteroidDrawCalls;
    }
 
-   player.viewpoint.Deactivate(renderingState->transformationStack);
+   if (!asteroidInstances.empty())
+   {
+      std::sort(asteroidInstances.begin(), asteroidInstances.end());
+
+      instancedProgram.Begin(projection, player.viewpoint);
+      instancedProgram.SetLights(lights, numShotPositionsToUse);
+
+      for (std::size_t groupStart = 0; groupStart < asteroidInstances.size(); )
+      {
+         const Asteroid* meshSource = asteroidInstances[groupStart].meshSource;
+         Locus::Texture* texture = asteroidInstances[groupStart].texture;
+
+         std::size_t groupEnd = groupStart + 1;
+
+         while ((groupEnd < asteroidInstances.size()) && (asteroidInstances[groupEnd].meshSource == meshSource) && (asteroidInstances[groupEnd].texture == texture))
+         {
+            ++groupEnd;
+         }
+
+         asteroidInstanceAttributes.resize(groupEnd - groupStart);
+
+         for (std::size_t instanceIndex = groupStart; instanceIndex < groupEnd; ++instanceIndex)
+         {
+            const Asteroid* asteroid = asteroidInstances[instanceIndex].asteroid;
+
+            asteroidInstanceAttributes[instanceIndex - groupStart].Set(asteroid->CurrentModelTransformation(), cameraOffset + asteroid->GetInterpolationOffset(interpolationFactor), Locus::Color::White());
+         }
+
+         texture->Bind();
+
+         instancedProgram.Draw(*meshSource, asteroidInstanceAttributes);
+
+         ++drawStatistics.numAsteroidDrawCalls;
+         drawStatistics.numInstancedAsteroids += asteroidInstanceAttributes.size();
+
+         groupStart = groupEnd;
+      }
+
+      instancedProgram.End();
+   }
 
    if (shaderChanged)
    {
@@ -1073,20 +864,43 @@ void DemoScene::DrawShots()
 
    renderingState->shaderController.SetTextureUniform(Locus::ShaderSource::Map_Diffuse, 0);
 
-   for (const std::unique_ptr<Shot>& shot : shots)
+   const ShotBuffer& shots = simulation.GetShots();
+   std::size_t numShots = shots.Size();
+
+   if (instancedProgram.IsLoaded())
    {
-      if (shot->IsValid())
+      //every shot, whatever its color, in one draw call
+      shotInstances.resize(numShots);
+
+      ModelFrame shotFrame;
+
+      for (std::size_t shotIndex = 0; shotIndex < numShots; ++shotIndex)
       {
-         player.viewpoint.Activate(renderingState->transformationStack);
+         shotInstances[shotIndex].Set(shotFrame, cameraOffset + shots.GetInterpolatedPosition(shotIndex, interpolationFactor), lightColors[shots.GetColorIndex(shotIndex)]);
+      }
 
-            renderingState->transformationStack.Translate(shot->GetPosition());
-            renderingState->UploadTransformations();
+      instancedProgram.Begin(projection, player.viewpoint);
+      instancedProgram.Draw(*shotMesh, shotInstances);
+      instancedProgram.End();
 
-            shot->Draw(*renderingState);
+      return;
+   }
 
-         player.viewpoint.Deactivate(renderingState->transformationStack);
-      }
+   player.viewpoint.Activate(renderingState->transformationStack);
+
+   for (std::size_t shotIndex = 0; shotIndex < numShots; ++shotIndex)
+   {
+      renderingState->transformationStack.Push();
+
+      renderingState->transformationStack.Translate(cameraOffset + shots.GetInterpolatedPosition(shotIndex, interpolationFactor));
+      renderingState->UploadTransformations();
+
+      shotDrawables[shots.GetColorIndex(shotIndex)]->Draw(*renderingState);
+
+      renderingState->transformationStack.Pop();
    }
+
+   player.viewpoint.Deactivate(renderingState->transformationStack);
 }
 
 void DemoScene::DrawHUD()
@@ -16,16 +16,21 @@
 
 #include "Locus/Math/VectorsFwd.h"
 
+#include "Locus/Geometry/Transformation.h"
+
 #include "Locus/Rendering/DrawablePointCloud.h"
 #include "Locus/Rendering/SkyBox.h"
 #include "Locus/Rendering/Light.h"
 
-#include "Locus/Geometry/CollisionManager.h"
-
+#include "DemoSimulation.h"
+#include "InstancedMesh.h"
+#include "InstancedProgram.h"
 #include "Player.h"
 #include "HUD.h"
 
 #include <memory>
+#include <vector>
+#include <functional>
 
 #include <cstddef>
 
@@ -37,6 +42,7 @@ class SAPReader;
 class SoundEffect;
 class SoundState;
 class RenderingState;
+class Texture;
 
 }
 
@@ -45,13 +51,14 @@ namespace MPM
 
 class Asteroid;
 class Planet;
-class Shot;
+class ShotDrawable;
 class TextureManager;
 
-class DemoScene : public Locus::Scene
+class DemoScene : public Locus::Scene, public SimulationListener
 {
 public:
    DemoScene(Locus::SceneManager& sceneManager, unsigned int resolutionX, unsigned int resolutionY);
+   ~DemoScene();
 
    virtual void Activate() override;
 
@@ -73,14 +80,15 @@ private:
    std::unique_ptr< Locus::SoundState > soundState;
 
    std::unique_ptr< MPM::TextureManager > textureManager;
-   Locus::CollisionManager collisionManager;
+
+   DemoSimulation simulation;
 
    std::unique_ptr< Locus::SoundEffect > shotSoundEffect;
    std::unique_ptr< Locus::SoundEffect > asteroidShotCollisionSoundEffect;
 
    bool dieOnNextFrame;
 
-   Player player;
+   Player& player;
 
    unsigned int maxLights;
 
@@ -93,13 +101,17 @@ private:
    Locus::ID_t texturedNotLitProgramID;
    std::vector<Locus::ID_t> litProgramIDs;
 
+   //draws the shots in one call, if the GL context can draw instanced
+   InstancedProgram instancedProgram;
+
+   Locus::Transformation projection;
+
    unsigned int resolutionX;
    unsigned int resolutionY;
 
    int lastMouseX;
    int lastMouseY;
 
-   int score;
    int lives;
    int level;
 
@@ -116,15 +128,81 @@ private:
    std::vector<std::unique_ptr<Planet>> planets;
    Locus::DrawablePointCloud stars;
 
-   std::vector<std::unique_ptr<Shot>> shots;
-   std::unique_ptr<Locus::Mesh> shotMesh;
+   std::unique_ptr<InstancedMesh> shotMesh;
+
+   //one per light color, indexed by the color index each shot is fired with. Only used
+   //to draw the shots one by one when instancedProgram isn't loaded
+   std::vector<std::unique_ptr<ShotDrawable>> shotDrawables;
+
+   //kept between frames so that drawing the shots doesn't allocate
+   std::vector<InstanceAttributes> shotInstances;
+
    Locus::SkyBox skyBox;
 
-   std::vector<std::unique_ptr<Locus::Mesh>> asteroidMeshes;
-   std::vector<std::unique_ptr<Asteroid>> asteroids;
+   std::size_t asteroidTextureIndex;
+
+   //the shared meshes this scene made GPU vertex data for. They belong to the fracture
+   //library, which outlives the scene (and its GL context), so the scene deletes the data
+   std::vector<Asteroid*> sharedMeshSources;
+
+   //the simulation runs at a fixed rate, so each frame is drawn between its last two steps.
+   //The camera is drawn at the interpolated player position by moving the rest of the
+   //world by cameraOffset instead
+   float interpolationFactor;
+   Locus::FVector3 cameraOffset;
 
    HUD hud;
 
+   //a visible asteroid drawn instanced. Sorting them puts those that share a mesh source
+   //and a texture next to each other, so that they are drawn in one call
+   struct AsteroidInstance
+   {
+      const Asteroid* meshSource;
+      Locus::Texture* texture;
+      const Asteroid* asteroid;
+
+      bool operator <(const AsteroidInstance& other) const
+      {
+         if (meshSource != other.meshSource)
+         {
+            return std::less<const Asteroid*>()(meshSource, other.meshSource);
+         }
+
+         return std::less<Locus::Texture*>()(texture, other.texture);
+      }
+   };
+
+   //kept between frames so that drawing the asteroids doesn't allocate
+   std::vector<AsteroidInstance> asteroidInstances;
+   std::vector<InstanceAttributes> asteroidInstanceAttributes;
+
+   //a shot that may light the asteroids. Sorting them puts the nearest first
+   struct ShotPositionAndDistance
+   {
+      unsigned int colorIndex;
+      Locus::FVector3 position;
+      float squaredDistance;
+
+      bool operator <(const ShotPositionAndDistance& other) const
+      {
+         return squaredDistance < other.squaredDistance;
+      }
+   };
+
+   //kept between frames so that picking the shot lights doesn't allocate
+   std::vector<ShotPositionAndDistance> shotPositionsAndDistances;
+
+   //what drawing the asteroids took, summed over the frames since it was last reported
+   struct DrawStatistics
+   {
+      std::size_t numFrames;
+      std::size_t numAsteroidDrawCalls;
+      std::size_t numInstancedAsteroids;
+   };
+
+   DrawStatistics drawStatistics;
+   double drawStatisticsTime;
+
    void Initialize();
    void InitializeStars();
    void InitializeAsteroids();
@@ -140,16 +218,18 @@ private:
    void LoadLights();
    void LoadTextures();
 
-   void UpdateLastMousePosition();
+   void ReportDrawStatistics(double DT);
 
-   void TickAsteroids(double DT);
-   void CheckForAsteroidHits();
+   void UpdateLastMousePosition();
+   void UpdateViewFrustum();
 
-   Locus::Plane MakeHalfSplitPlane(const Locus::FVector3& shotPosition, const Locus::FVector3& asteroidCentroid);
-   void SplitAsteroid(std::size_t splitIndex, const Locus::FVector3& shotPosition);
-   void UpdateShotPositions(double DT);
    void ShotFired();
 
+   virtual void AsteroidCreated(Asteroid& asteroid) override;
+   virtual void AsteroidDestroyed(Asteroid& asteroid) override;
+   virtual void ShotCreated() override;
+   virtual void AsteroidsHit() override;
+
    void DrawShots();
    void DrawAsteroids();
    void DrawHUD();
@@ -0,0 +1,895 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "DemoSimulation.h"
+#include "Config.h"
+#include "Asteroid.h"
+#include "ContactCache.h"
+#include "FractureLibrary.h"
+#include "PoissonDiskSampler.h"
+
+#include "Locus/Geometry/Geometry.h"
+#include "Locus/Geometry/Frustum.h"
+#include "Locus/Geometry/Plane.h"
+
+#include "Locus/Rendering/Mesh.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <cmath>
+
+//TODO: Remove magic numbers, either by putting in data files or use a scripting interface
+
+#define ASTEROID_SPACING_THRESHOLD 0
+#define MAX_ASTEROID_HITS 20
+#define MIN_ASTEROID_SCALE 10
+#define MAX_ASTEROID_SCALE 30
+
+#define FRUSTUM_NEAR_DISTANCE 0.01f
+
+namespace MPM
+{
+
+static const float Default_View_Horizontal_Field_Of_View = 100.0f;
+static const float Default_View_Vertical_Field_Of_View = 57.0f;
+static const float Default_View_Far_Distance = 2000.0f;
+
+//how long, in seconds of simulated time, a pair that collided is left to separate
+static const float Collision_Debounce_Time = 0.5f;
+
+//asteroids are handed out to the worker threads in chunks of this many
+static const std::size_t Asteroid_Chunk_Size = 128;
+
+//////////////////////////////////////SimulationTimings//////////////////////////////////////////
+
+SimulationTimings::SimulationTimings()
+{
+   Reset();
+}
+
+void SimulationTimings::Reset()
+{
+   for (int phase = 0; phase < Num_Phases; ++phase)
+   {
+      phaseDurations[phase] = Clock::duration::zero();
+   }
+
+   numFrames = 0;
+}
+
+const char* SimulationTimings::PhaseName(Phase phase)
+{
+   switch (phase)
+   {
+      case Phase_Player:
+         return "Player::tick";
+
+      case Phase_Asteroids:
+         return "TickAsteroids";
+
+      case Phase_Shots:
+         return "UpdateShotPositions";
+
+      case Phase_UpdateCollisions:
+         return "UpdateCollisions";
+
+      case Phase_TransmitCollisions:
+         return "TransmitCollisions";
+
+      case Phase_AsteroidHits:
+         return "CheckForAsteroidHits";
+
+      default:
+         return "Unknown";
+   }
+}
+
+//////////////////////////////////////DemoSimulation//////////////////////////////////////////
+
+DemoSimulation::DemoSimulation(unsigned int worldSeed)
+   : listener(nullptr),
+     worldSeed(worldSeed),
+     asteroidRandom(worldSeed, RandomStream_Asteroids),
+     splitRandom(worldSeed, RandomStream_Splits),
+     workerPool(Config::GetNumWorkerThreads()),
+     broadphase(Broadphase::Create(Config::GetBroadphase(), workerPool)),
+     score(0),
+     numLibrarySplits(0),
+     numRuntimeSplits(0),
+     numAsteroidSyncs(0),
+     numDeferredAsteroidSyncs(0),
+     lodStep(0),
+     accumulatedTime(0.0),
+     interpolationFactor(0.0f),
+     viewHorizontalFieldOfView(Default_View_Horizontal_Field_Of_View),
+     viewVerticalFieldOfView(Default_View_Vertical_Field_Of_View),
+     viewFarDistance(Default_View_Far_Distance)
+{
+   std::string asteroidNarrowphase = Config::GetAsteroidNarrowphase();
+
+   if ((asteroidNarrowphase != "Hull") && (asteroidNarrowphase != "Triangles"))
+   {
+      throw std::invalid_argument("Unknown asteroid narrowphase " + asteroidNarrowphase);
+   }
+
+   Asteroid::SetTriangleAccurateCollisions(asteroidNarrowphase == "Triangles");
+
+   fractureLibrary = FractureLibrary::Load(Config::GetModelFile(), Config::GetFractureDepth(), workerPool);
+
+   //no asteroid is ever larger than the largest model at the largest scale; splitting only makes them smaller
+   float largestAsteroidRadius = 0.0f;
+
+   for (std::size_t modelIndex = 0; modelIndex < fractureLibrary->NumModels(); ++modelIndex)
+   {
+      largestAsteroidRadius = std::max(largestAsteroidRadius, fractureLibrary->GetModel(modelIndex).asteroid->GetMaxDistanceToCenter() * MAX_ASTEROID_SCALE);
+   }
+
+   broadphase->SetArena(Config::GetAsteroidsBoundary(), largestAsteroidRadius);
+}
+
+DemoSimulation::~DemoSimulation()
+{
+   //the splits still running read from the asteroids
+   workerPool.WaitForBackgroundTasks();
+
+   //the pool is destroyed before the contact cache, and each asteroid would otherwise
+   //look for its contacts on the way out
+   contactCache.Clear();
+
+   for (Asteroid* asteroid : asteroidPool.GetActive())
+   {
+      asteroid->SetContactCache(nullptr);
+   }
+}
+
+void DemoSimulation::SetListener(SimulationListener* listener)
+{
+   this->listener = listener;
+}
+
+void DemoSimulation::SetViewFrustum(float horizontalFieldOfView, float verticalFieldOfView, float farDistance)
+{
+   viewHorizontalFieldOfView = horizontalFieldOfView;
+   viewVerticalFieldOfView = verticalFieldOfView;
+   viewFarDistance = farDistance;
+}
+
+Player& DemoSimulation::GetPlayer()
+{
+   return player;
+}
+
+const std::vector<Asteroid*>& DemoSimulation::GetAsteroids() const
+{
+   return asteroidPool.GetActive();
+}
+
+const ShotBuffer& DemoSimulation::GetShots() const
+{
+   return shots;
+}
+
+int DemoSimulation::GetScore() const
+{
+   return score;
+}
+
+std::size_t DemoSimulation::GetNumLibrarySplits() const
+{
+   return numLibrarySplits;
+}
+
+std::size_t DemoSimulation::GetNumRuntimeSplits() const
+{
+   return numRuntimeSplits;
+}
+
+std::size_t DemoSimulation::GetNumAsteroidSyncs() const
+{
+   return numAsteroidSyncs;
+}
+
+std::size_t DemoSimulation::GetNumDeferredAsteroidSyncs() const
+{
+   return numDeferredAsteroidSyncs;
+}
+
+std::size_t DemoSimulation::GetNumContactCacheAllocations() const
+{
+   return contactCache.GetNumAllocations();
+}
+
+unsigned int DemoSimulation::GetWorldSeed() const
+{
+   return worldSeed;
+}
+
+const SimulationTimings& DemoSimulation::GetTimings() const
+{
+   return timings;
+}
+
+void DemoSimulation::ResetTimings()
+{
+   timings.Reset();
+}
+
+void DemoSimulation::InitializeAsteroids()
+{
+   workerPool.WaitForBackgroundTasks();
+   pendingSplits.clear();
+
+   for (Asteroid* asteroid : asteroidPool.GetActive())
+   {
+      if (listener != nullptr)
+      {
+         listener->AsteroidDestroyed(*asteroid);
+      }
+
+      //every contact goes at once below, so the asteroids don't remove theirs one by one
+      asteroid->SetContactCache(nullptr);
+   }
+
+   contactCache.Clear();
+
+   broadphase->Clear();
+
+   asteroidPool.Clear();
+
+   shots.Clear();
+   shots.Reserve(Config::GetNumShots());
+
+   //////////////////////////////////////////////////////////////////////
+
+   asteroidKinematics.Reserve(Config::GetNumAsteroids());
+   asteroidKinematics.SetBoundary(Config::GetAsteroidsBoundary());
+
+   numLibrarySplits = 0;
+   numRuntimeSplits = 0;
+
+   numAsteroidSyncs = 0;
+   numDeferredAsteroidSyncs = 0;
+
+   //the unbroken models of the fracture library serve as templates
+   std::size_t numAsteroidTemplates = fractureLibrary->NumModels();
+
+   broadphase->StartAddRemoveBatch();
+
+   player.SetModel(Config::GetPlayerCollisionRadius());
+   broadphase->Add(&player);
+
+   float minAsteroidDistance = 0.0f;
+   float maxAsteroidDistance = Config::GetAsteroidsBoundary() - 5.0f;
+
+   PoissonDiskSampler positionSampler(maxAsteroidDistance, ASTEROID_SPACING_THRESHOLD, minAsteroidDistance);
+
+   //everything random is drawn up front, in the same order for any number of threads
+
+   struct AsteroidSetup
+   {
+      AsteroidHandle handle;
+      const FractureNode* asteroidTemplate;
+      Locus::MotionProperties motionProperties;
+      float scale;
+      Locus::FVector3 position;
+   };
+
+   std::size_t numAsteroids = static_cast<std::size_t>(std::max(Config::GetNumAsteroids(), 0));
+
+   std::vector<AsteroidSetup> asteroidSetups(numAsteroids);
+
+   std::size_t whichMesh = 0;
+
+   for (AsteroidSetup& asteroidSetup : asteroidSetups)
+   {
+      //get asteroid type
+
+      asteroidSetup.handle = asteroidPool.Allocate(MAX_ASTEROID_HITS);
+      asteroidSetup.asteroidTemplate = &fractureLibrary->GetModel(whichMesh);
+
+      whichMesh = (whichMesh + 1) % numAsteroidTemplates;
+
+      //randomize direction
+      float xDirection = static_cast<float>(asteroidRandom.RandomDouble(-1, 1));
+      float yDirection = static_cast<float>(asteroidRandom.RandomDouble(-1, 1));
+      float zDirection = static_cast<float>(asteroidRandom.RandomDouble(-1, 1));
+
+      asteroidSetup.motionProperties.direction.Set(xDirection, yDirection, zDirection);
+      Normalize(asteroidSetup.motionProperties.direction);
+
+      //randomize speed
+      asteroidSetup.motionProperties.speed = static_cast<float>(asteroidRandom.RandomDouble(Config::GetMinAsteroidSpeed(), Config::GetMaxAsteroidSpeed()));
+
+      //randomize rotation direction
+      xDirection = static_cast<float>(asteroidRandom.RandomDouble(-1, 1));
+      yDirection = static_cast<float>(asteroidRandom.RandomDouble(-1, 1));
+      zDirection = static_cast<float>(asteroidRandom.RandomDouble(-1, 1));
+
+      asteroidSetup.motionProperties.rotation.Set(xDirection, yDirection, zDirection);
+
+      //randomize rotation speed
+      asteroidSetup.motionProperties.angularSpeed = static_cast<float>(asteroidRandom.RandomDouble(Config::GetMinAsteroidRotationSpeed(), Config::GetMaxAsteroidRotationSpeed()));
+
+      //randomize size
+      asteroidSetup.scale = static_cast<float>(asteroidRandom.RandomDouble(MIN_ASTEROID_SCALE, MAX_ASTEROID_SCALE));
+
+      //randomize position (centroid)
+      asteroidSetup.position = positionSampler.Place(asteroidRandom);
+   }
+
+   //each asteroid is made independently of the others
+   workerPool.ParallelFor(numAsteroids, Asteroid_Chunk_Size, [&](std::size_t begin, std::size_t end)
+   {
+      for (std::size_t setupIndex = begin; setupIndex < end; ++setupIndex)
+      {
+         const AsteroidSetup& asteroidSetup = asteroidSetups[setupIndex];
+
+         Asteroid* asteroid = asteroidPool.Get(asteroidSetup.handle);
+
+         asteroid->ShareMeshAndCollidable(asteroidSetup.asteroidTemplate->asteroid);
+         asteroid->motionProperties = asteroidSetup.motionProperties;
+
+         asteroid->Scale( Locus::FVector3(asteroidSetup.scale, asteroidSetup.scale, asteroidSetup.scale) );
+         asteroid->SetFractureNode(asteroidSetup.asteroidTemplate, asteroidSetup.scale);
+
+         asteroid->Translate(asteroidSetup.position);
+
+         asteroid->UpdateMaxDistanceToCenter();
+         asteroid->UpdateBroadCollisionExtent();
+         asteroid->SetContactCache(&contactCache);
+      }
+   });
+
+   //the kinematics, the broadphase and the listener (which uploads to the GPU) are
+   //told about the asteroids in one pass at the end
+   for (const AsteroidSetup& asteroidSetup : asteroidSetups)
+   {
+      Asteroid* asteroid = asteroidPool.Get(asteroidSetup.handle);
+
+      asteroid->AttachKinematics(asteroidKinematics);
+
+      if (listener != nullptr)
+      {
+         listener->AsteroidCreated(*asteroid);
+      }
+
+      broadphase->Add(asteroid);
+
+      asteroidPool.Activate(asteroidSetup.handle);
+   }
+
+   broadphase->FinishAddRemoveBatch();
+}
+
+bool DemoSimulation::FireShot(unsigned int colorIndex)
+{
+   if (shots.Size() < Config::GetNumShots())
+   {
+      shots.Add(player.viewpoint.GetPosition() + player.viewpoint.GetForward(), player.viewpoint.GetForward(), colorIndex);
+
+      if (listener != nullptr)
+      {
+         listener->ShotCreated();
+      }
+
+      return true;
+   }
+
+   return false;
+}
+
+unsigned int DemoSimulation::Advance(double frameDT)
+{
+   double stepDT = 1.0 / Config::GetSimulationRate();
+   unsigned int maxSteps = Config::GetMaxSimulationSteps();
+
+   accumulatedTime += frameDT;
+
+   unsigned int numSteps = 0;
+
+   while (accumulatedTime >= stepDT)
+   {
+      if (numSteps == maxSteps)
+      {
+         //drop the time that couldn't be simulated instead of carrying it into
+         //the next frame, which would only make that frame slower too
+         accumulatedTime = std::fmod(accumulatedTime, stepDT);
+         break;
+      }
+
+      Update(stepDT);
+
+      accumulatedTime -= stepDT;
+      ++numSteps;
+   }
+
+   interpolationFactor = static_cast<float>(accumulatedTime / stepDT);
+
+   return numSteps;
+}
+
+float DemoSimulation::GetInterpolationFactor() const
+{
+   return interpolationFactor;
+}
+
+void DemoSimulation::Update(double DT)
+{
+   SimulationTimings::Clock::time_point phaseStart = SimulationTimings::Clock::now();
+   SimulationTimings::Clock::time_point phaseEnd;
+
+   //counted in steps of the length actually in use, which MPM_Headless sets on its own
+   contactCache.SetDebounceFrames( static_cast<unsigned int>(std::ceil(Collision_Debounce_Time / DT)) );
+   contactCache.NextFrame();
+
+   #define END_PHASE(phase) phaseEnd = SimulationTimings::Clock::now(); \
+                            timings.phaseDurations[SimulationTimings::phase] += (phaseEnd - phaseStart); \
+                            phaseStart = phaseEnd
+
+   player.tick(DT);
+   broadphase->Update(&player);
+   END_PHASE(Phase_Player);
+
+   TickAsteroids(DT);
+   END_PHASE(Phase_Asteroids);
+
+   UpdateShotPositions(DT);
+   END_PHASE(Phase_Shots);
+
+   broadphase->UpdateCollisions();
+   END_PHASE(Phase_UpdateCollisions);
+
+   broadphase->TransmitCollisions();
+   player.PlayQueuedCollisionSound();
+   END_PHASE(Phase_TransmitCollisions);
+
+   CheckForAsteroidHits();
+   END_PHASE(Phase_AsteroidHits);
+
+   #undef END_PHASE
+
+   ++timings.numFrames;
+}
+
+void DemoSimulation::UpdateShotPositions(double DT)
+{
+   //shots don't go through the broadphase. They are moved and cast against the asteroids,
+   //which have already been moved this step, in one batch
+
+   float boundary = Config::GetAsteroidsBoundary();
+
+   float shotDistance = Norm(Locus::FVector3(boundary, boundary, boundary));
+
+   shots.Advance(static_cast<float>(DT) * Config::GetShotSpeed(), shotDistance);
+
+   shots.ResolveHits(asteroidKinematics, workerPool);
+}
+
+Locus::Plane DemoSimulation::MakeHalfSplitPlane(const Locus::FVector3& shotPosition, const Locus::FVector3& asteroidCentroid)
+{
+   Locus::Plane orthogonalPlane(asteroidCentroid, player.viewpoint.GetForward());
+   Locus::FVector3 shotProjection = orthogonalPlane.getProjection(shotPosition);
+
+   Locus::FVector3 normal = shotProjection - asteroidCentroid;
+   RotateAround(normal, -player.viewpoint.GetForward(), Locus::PI/2);
+
+   return Locus::Plane(asteroidCentroid, normal);
+}
+
+//copies a half out of the fracture library to where it lies in the asteroid it is split from
+static void PlaceFragment(Asteroid& fragment, const FractureNode& half, const Asteroid& asteroidToSplit)
+{
+   float scale = asteroidToSplit.GetFractureScale();
+
+   fragment.ShareMeshAndCollidable(half.asteroid);
+   fragment.SetFractureNode(&half, scale);
+
+   fragment.centroid = asteroidToSplit.GetModelFrame().ToWorld(half.offset);
+
+   fragment.Reset(fragment.centroid, asteroidToSplit.CurrentRotation());
+   fragment.Scale( Locus::FVector3(scale, scale, scale) );
+
+   fragment.UpdateMaxDistanceToCenter();
+}
+
+//the rotation that takes an asteroid from how it lay in from to how it lies in to. Both
+//frames are of the same asteroid, so they scale alike
+static Locus::Transformation RotationBetween(const ModelFrame& from, const ModelFrame& to)
+{
+   const Locus::FVector3 axes[3] = { Locus::Vec3D::XAxis(), Locus::Vec3D::YAxis(), Locus::Vec3D::ZAxis() };
+
+   Locus::Transformation rotation = Locus::Transformation::Identity();
+
+   for (unsigned int column = 0; column < 3; ++column)
+   {
+      Locus::FVector3 turnedAxis = to.VectorToWorld(from.VectorToModel(axes[column]));
+
+      rotation(0, column) = turnedAxis.x;
+      rotation(1, column) = turnedAxis.y;
+      rotation(2, column) = turnedAxis.z;
+   }
+
+   return rotation;
+}
+
+//moves a fragment cut from an asteroid in parentFrame to where it is in the asteroid
+//in currentParentFrame. turn is RotationBetween(parentFrame, currentParentFrame)
+static void PlaceSplitFragment(Asteroid& fragment, const ModelFrame& parentFrame, const ModelFrame& currentParentFrame, const Locus::Transformation& turn)
+{
+   fragment.centroid = currentParentFrame.ToWorld(parentFrame.ToModel(fragment.Position()));
+
+   fragment.Reset(fragment.centroid, turn);
+}
+
+void DemoSimulation::SplitAsteroid(std::size_t splitIndex, const Locus::FVector3& shotPosition)
+{
+   //split an asteroid in two. If it has no more hits left,
+   //simply remove the asteroid from the game. The halves are
+   //copied from the fracture library if it goes deep enough;
+   //otherwise the split is worked out in the background and
+   //FinishPendingSplits adds the fragments
+
+   ++score;
+
+   AsteroidHandle splitHandle = asteroidPool.GetActiveHandle(splitIndex);
+   Asteroid* asteroidToSplit = asteroidPool.Get(splitHandle);
+
+   asteroidToSplit->decreaseHitsLeft();
+
+   int hitsLeft = asteroidToSplit->getHitsLeft();
+
+   if (hitsLeft <= 0)
+   {
+      RemoveAsteroid(splitHandle);
+      return;
+   }
+
+   AsteroidHandle fragment1 = asteroidPool.Allocate(hitsLeft);
+   AsteroidHandle fragment2 = asteroidPool.Allocate(hitsLeft);
+
+   Asteroid* splitAsteroid1 = asteroidPool.Get(fragment1);
+   Asteroid* splitAsteroid2 = asteroidPool.Get(fragment2);
+
+   float xRotationDirection = static_cast<float>( splitRandom.RandomDouble(-1, 1) );
+   float yRotationDirection = static_cast<float>( splitRandom.RandomDouble(-1, 1) );
+   float zRotationDirection = static_cast<float>( splitRandom.RandomDouble(-1, 1) );
+
+   splitAsteroid1->motionProperties.rotation.Set(xRotationDirection, yRotationDirection, zRotationDirection);
+   splitAsteroid2->motionProperties.rotation.Set(xRotationDirection, yRotationDirection, zRotationDirection);
+
+   splitAsteroid1->motionProperties.angularSpeed = asteroidToSplit->motionProperties.angularSpeed;
+   splitAsteroid2->motionProperties.angularSpeed = asteroidToSplit->motionProperties.angularSpeed;
+
+   Locus::Plane splitPlane = MakeHalfSplitPlane(shotPosition, asteroidToSplit->Position());
+
+   splitAsteroid1->motionProperties.speed = asteroidToSplit->motionProperties.speed;
+   splitAsteroid2->motionProperties.speed = asteroidToSplit->motionProperties.speed;
+
+   splitAsteroid1->motionProperties.direction = splitPlane.getNormal();
+   Normalize(splitAsteroid1->motionProperties.direction);
+
+   splitAsteroid2->motionProperties.direction = -(splitAsteroid1->motionProperties.direction);
+
+   const FractureNode* fractureNode = asteroidToSplit->GetFractureNode();
+
+   if ((fractureNode != nullptr) && !fractureNode->children.empty())
+   {
+      //planes transform to model space by the transpose, like support directions
+      bool flipped = false;
+      std::size_t directionIndex = FractureLibrary::ClosestDirection(asteroidToSplit->GetModelFrame().SupportDirectionToModel(splitPlane.getNormal()), flipped);
+
+      const FractureNode* front = fractureNode->children[2 * directionIndex].get();
+      const FractureNode* back = fractureNode->children[2 * directionIndex + 1].get();
+
+      if ((front != nullptr) && (back != nullptr))
+      {
+         //the first fragment moves along the normal, so it is the half in front of the cut
+         PlaceFragment(*splitAsteroid1, flipped ? *back : *front, *asteroidToSplit);
+         PlaceFragment(*splitAsteroid2, flipped ? *front : *back, *asteroidToSplit);
+
+         splitAsteroid1->SetTexture(asteroidToSplit->GetTexture());
+         splitAsteroid2->SetTexture(asteroidToSplit->GetTexture());
+
+         AddFragments(fragment1, fragment2);
+         RemoveAsteroid(splitHandle);
+
+         ++numLibrarySplits;
+
+         return;
+      }
+   }
+
+   splitAsteroid1->SetTexture(asteroidToSplit->GetTexture());
+   splitAsteroid2->SetTexture(asteroidToSplit->GetTexture());
+
+   Locus::Transformation splitTransformation = asteroidToSplit->CurrentModelTransformation();
+   ModelFrame splitFrame(splitTransformation);
+
+   Locus::FVector3 splitPoint = asteroidToSplit->Position();
+   Locus::FVector3 splitNormal = splitPlane.getNormal();
+
+   //only reads the mesh of the asteroid being split, which nothing changes
+   //until it is removed, and writes to the fragments nothing else sees yet
+   workerPool.RunInBackground([=]
+   {
+      asteroidToSplit->GetMeshSource().DetermineSplit(splitPlane, splitTransformation, *splitAsteroid1, *splitAsteroid2);
+
+      if ((splitAsteroid1->NumFaces() > 0) && (splitAsteroid2->NumFaces() > 0))
+      {
+         splitAsteroid1->Reset(splitAsteroid1->centroid);
+         splitAsteroid2->Reset(splitAsteroid2->centroid);
+
+         splitAsteroid1->AssignNormals();
+         splitAsteroid2->AssignNormals();
+
+         splitAsteroid1->UpdateMaxDistanceToCenter();
+         splitAsteroid1->CreateBoundingVolumeHierarchy(*asteroidToSplit, splitFrame, splitPoint, splitNormal);
+         splitAsteroid1->CreateConvexHull();
+
+         splitAsteroid2->UpdateMaxDistanceToCenter();
+         splitAsteroid2->CreateBoundingVolumeHierarchy(*asteroidToSplit, splitFrame, splitPoint, -splitNormal);
+         splitAsteroid2->CreateConvexHull();
+      }
+   });
+
+   PendingSplit pendingSplit;
+
+   pendingSplit.parent = splitHandle;
+   pendingSplit.parentFrame = splitFrame;
+   pendingSplit.splitPoint = splitPoint;
+   pendingSplit.splitNormal = splitNormal;
+   pendingSplit.fragment1 = fragment1;
+   pendingSplit.fragment2 = fragment2;
+
+   pendingSplits.push_back(pendingSplit);
+
+   //shots can still hit the asteroid until the fragments take its place. Those hits are
+   //passed on to the fragments
+   asteroidToSplit->ClearHit();
+
+   ++numRuntimeSplits;
+}
+
+void DemoSimulation::FinishPendingSplits()
+{
+   //swaps the asteroids split during the previous step for their fragments. Called
+   //inside an add/remove batch of the broadphase
+
+   workerPool.WaitForBackgroundTasks();
+
+   for (PendingSplit& pendingSplit : pendingSplits)
+   {
+      Asteroid* parent = asteroidPool.Get(pendingSplit.parent);
+      Asteroid* splitAsteroid1 = asteroidPool.Get(pendingSplit.fragment1);
+      Asteroid* splitAsteroid2 = asteroidPool.Get(pendingSplit.fragment2);
+
+      if ((splitAsteroid1->NumFaces() > 0) && (splitAsteroid2->NumFaces() > 0))
+      {
+         //the asteroid kept moving and turning while it was being split. The fragments,
+         //which were cut where it was, are moved and turned with it
+
+         parent->CatchUpWithKinematics();
+
+         ModelFrame parentFrame(parent->CurrentModelTransformation());
+
+         Locus::Transformation turn = RotationBetween(pendingSplit.parentFrame, parentFrame);
+
+         PlaceSplitFragment(*splitAsteroid1, pendingSplit.parentFrame, parentFrame, turn);
+         PlaceSplitFragment(*splitAsteroid2, pendingSplit.parentFrame, parentFrame, turn);
+
+         if (parent->WasHit())
+         {
+            //the fragment on the side of the cut that the shot hit takes the hit
+            Locus::FVector3 hitLocation = pendingSplit.parentFrame.ToWorld(parentFrame.ToModel(parent->GetHitLocation()));
+
+            Asteroid* hitFragment = (Dot(pendingSplit.splitNormal, hitLocation - pendingSplit.splitPoint) >= 0.0f) ? splitAsteroid1 : splitAsteroid2;
+
+            hitFragment->RegisterHit(parent->GetHitLocation());
+         }
+
+         AddFragments(pendingSplit.fragment1, pendingSplit.fragment2);
+      }
+      else
+      {
+         asteroidPool.Release(pendingSplit.fragment1);
+         asteroidPool.Release(pendingSplit.fragment2);
+      }
+
+      RemoveAsteroid(pendingSplit.parent);
+   }
+
+   pendingSplits.clear();
+}
+
+void DemoSimulation::AddFragments(AsteroidHandle fragment1, AsteroidHandle fragment2)
+{
+   Asteroid* splitAsteroid1 = asteroidPool.Get(fragment1);
+   Asteroid* splitAsteroid2 = asteroidPool.Get(fragment2);
+
+   //avoiding immediate interpenetration
+   splitAsteroid1->SetContactCache(&contactCache);
+   splitAsteroid2->SetContactCache(&contactCache);
+
+   contactCache.MarkResolved(splitAsteroid1, splitAsteroid2);
+
+   splitAsteroid1->UpdateBroadCollisionExtent();
+   splitAsteroid1->AttachKinematics(asteroidKinematics);
+
+   splitAsteroid2->UpdateBroadCollisionExtent();
+   splitAsteroid2->AttachKinematics(asteroidKinematics);
+
+   if (listener != nullptr)
+   {
+      listener->AsteroidCreated(*splitAsteroid1);
+      listener->AsteroidCreated(*splitAsteroid2);
+   }
+
+   broadphase->Add(splitAsteroid1);
+   broadphase->Add(splitAsteroid2);
+
+   asteroidPool.Activate(fragment1);
+   asteroidPool.Activate(fragment2);
+}
+
+void DemoSimulation::RemoveAsteroid(AsteroidHandle handle)
+{
+   Asteroid* asteroid = asteroidPool.Get(handle);
+
+   if (listener != nullptr)
+   {
+      listener->AsteroidDestroyed(*asteroid);
+   }
+
+   broadphase->Remove(asteroid);
+
+   asteroidPool.Release(handle);
+}
+
+void DemoSimulation::TickAsteroids(double DT)
+{
+   //this function moves the asteroids' clock on. Asteroids bounce off the
+   //side of the asteroid boundary as they reach it, and their positions are
+   //worked out from the line they are on when asked for (see AsteroidKinematics).
+   //This function also updates the visible asteroids.
+   //
+   //Every asteroid is updated independently of the others, so the work is
+   //split between the worker threads and the results are the same for any
+   //number of threads
+   //
+   //Asteroids in view or within Config::GetLODDistance() of the player are synced
+   //with their kinematics every step. The rest are at reduced detail: they are synced
+   //at least every Config::GetLODUpdateInterval() steps, catching up on the rotation
+   //they skipped, and stay in the broadphase with their bounding sphere grown by how
+   //far they can move in between. Their positions are exact regardless
+
+   float dt = static_cast<float>(DT);
+
+   unsigned int lodInterval = std::max(Config::GetLODUpdateInterval(), 1u);
+   float lodDistance = Config::GetLODDistance();
+
+   std::size_t numAsteroids = asteroidKinematics.Size();
+
+   Locus::FVector3 forward = player.viewpoint.GetForward();
+   Locus::FVector3 up = player.viewpoint.GetUp();
+
+   Locus::FVector3 point = player.viewpoint.GetPosition();
+
+   Locus::Frustum viewFrustum(point, forward, up, viewHorizontalFieldOfView, viewVerticalFieldOfView, FRUSTUM_NEAR_DISTANCE, viewFarDistance);
+
+   asteroidsSynced.resize(numAsteroids);
+
+   //only the asteroids that reach the boundary this step are touched
+   asteroidKinematics.Advance(DT);
+
+   //update the asteroids' visibility with the camera frustum, then have each asteroid
+   //that isn't putting it off pull its new transformation
+   workerPool.ParallelFor(numAsteroids, Asteroid_Chunk_Size, [&](std::size_t begin, std::size_t end)
+   {
+      for (std::size_t kinematicsIndex = begin; kinematicsIndex < end; ++kinematicsIndex)
+      {
+         Asteroid* asteroid = asteroidKinematics.GetAsteroid(kinematicsIndex);
+
+         Locus::FVector3 position = asteroidKinematics.GetPosition(kinematicsIndex);
+         float radius = asteroidKinematics.GetRadius(kinematicsIndex);
+
+         asteroid->visible = viewFrustum.Within(position, radius);
+
+         bool reducedDetail = (lodInterval > 1) && !asteroid->visible && (DistanceBetween(position, point) - radius > lodDistance);
+
+         //the syncs are spread over the steps by kinematics index. The broad margin covers
+         //lodInterval - 1 steps, so counting the steps since the broad extent was updated
+         //bounds the wait even when the asteroid's index changes or it was caught up in between
+         if (reducedDetail && asteroid->CanDeferSync() && (asteroid->GetNumStepsSinceBroadUpdate() + 1 < lodInterval) &&
+             (((lodStep + kinematicsIndex) % lodInterval) != 0))
+         {
+            asteroid->DeferSync(DT);
+
+            asteroidsSynced[kinematicsIndex] = 0;
+            continue;
+         }
+
+         float maxStepDistance = Norm(asteroidKinematics.GetDirection(kinematicsIndex)) * asteroid->motionProperties.speed * dt;
+
+         asteroid->SyncWithKinematics(DT);
+         asteroid->SetDetail(reducedDetail, (lodInterval - 1) * maxStepDistance);
+         asteroid->UpdateBroadCollisionExtent();
+
+         asteroidsSynced[kinematicsIndex] = 1;
+      }
+   });
+
+   //the broadphase isn't thread safe so it is updated in one batch afterwards. Asteroids
+   //that put off syncing haven't changed their broad extent
+   for (std::size_t kinematicsIndex = 0; kinematicsIndex < numAsteroids; ++kinematicsIndex)
+   {
+      if (asteroidsSynced[kinematicsIndex] != 0)
+      {
+         broadphase->Update(asteroidKinematics.GetAsteroid(kinematicsIndex));
+
+         ++numAsteroidSyncs;
+      }
+      else
+      {
+         ++numDeferredAsteroidSyncs;
+      }
+   }
+
+   ++lodStep;
+}
+
+void DemoSimulation::CheckForAsteroidHits()
+{
+   //asteroids split last step are replaced before looking for new hits, so one that
+   //was hit again in the meantime is not split twice
+   bool hadPendingSplits = !pendingSplits.empty();
+
+   if (hadPendingSplits)
+   {
+      broadphase->StartAddRemoveBatch();
+
+      FinishPendingSplits();
+   }
+
+   bool hadAnyHits = false;
+
+   const std::vector<Asteroid*>& asteroids = asteroidPool.GetActive();
+
+   //backwards, since removing an asteroid moves the last one into its place
+   for (int asteroidIndex = static_cast<int>(asteroids.size() - 1); asteroidIndex >= 0; --asteroidIndex)
+   {
+      if (asteroids[asteroidIndex]->WasHit())
+      {
+         if (!hadAnyHits && !hadPendingSplits)
+         {
+            broadphase->StartAddRemoveBatch();
+         }
+
+         //splitting reads the asteroid's transformation
+         asteroids[asteroidIndex]->CatchUpWithKinematics();
+
+         SplitAsteroid(asteroidIndex, asteroids[asteroidIndex]->GetHitLocation());
+
+         hadAnyHits = true;
+      }
+   }
+
+   if (hadAnyHits && (listener != nullptr))
+   {
+      listener->AsteroidsHit();
+   }
+
+   if (hadAnyHits || hadPendingSplits)
+   {
+      broadphase->FinishAddRemoveBatch();
+   }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "AsteroidKinematics.h"
+#include "AsteroidPool.h"
+#include "Broadphase.h"
+#include "ContactCache.h"
+#include "FractureLibrary.h"
+#include "ModelFrame.h"
+#include "Player.h"
+#include "Random.h"
+#include "ShotBuffer.h"
+#include "WorkerPool.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <cstddef>
+
+namespace Locus
+{
+
+class Plane;
+
+}
+
+namespace MPM
+{
+
+class Asteroid;
+
+//Receives the simulation events that have consequences outside of the simulation
+//itself (GPU resources, sound). A simulation without a listener (e.g. one run
+//headless) simply doesn't report them
+class SimulationListener
+{
+public:
+   virtual ~SimulationListener() {}
+
+   virtual void AsteroidCreated(Asteroid& asteroid) = 0;
+   virtual void AsteroidDestroyed(Asteroid& asteroid) = 0;
+   virtual void ShotCreated() = 0;
+   virtual void AsteroidsHit() = 0;
+};
+
+struct SimulationTimings
+{
+   typedef std::chrono::high_resolution_clock Clock;
+
+   enum Phase
+   {
+      Phase_Player = 0,
+      Phase_Asteroids,
+      Phase_Shots,
+      Phase_UpdateCollisions,
+      Phase_TransmitCollisions,
+      Phase_AsteroidHits,
+      Num_Phases
+   };
+
+   SimulationTimings();
+
+   void Reset();
+
+   static const char* PhaseName(Phase phase);
+
+   Clock::duration phaseDurations[Num_Phases];
+   std::size_t numFrames;
+};
+
+//The gameplay state of the demo: the player, the asteroids, the shots and the
+//collisions between them. It owns no window, GL context or audio
+class DemoSimulation
+{
+public:
+   //every random stream of the simulation is derived from worldSeed
+   DemoSimulation(unsigned int worldSeed);
+   ~DemoSimulation();
+
+   void SetListener(SimulationListener* listener);
+   void SetViewFrustum(float horizontalFieldOfView, float verticalFieldOfView, float farDistance);
+
+   void InitializeAsteroids();
+
+   //runs as many fixed length simulation steps as fit in the time accumulated so far,
+   //including frameDT, but no more than Config::GetMaxSimulationSteps(). Returns the
+   //number of steps run
+   unsigned int Advance(double frameDT);
+
+   //runs a single simulation step of length DT
+   void Update(double DT);
+
+   //how far between the previous simulation step and the current one the remaining
+   //accumulated time lies, in [0, 1). Used to interpolate what is drawn
+   float GetInterpolationFactor() const;
+
+   //fires a shot from the player unless Config::GetNumShots() shots are already in flight.
+   //colorIndex is kept with the shot for whoever draws it
+   bool FireShot(unsigned int colorIndex);
+
+   Player& GetPlayer();
+
+   //the asteroids in the simulation, in no particular order
+   const std::vector<Asteroid*>& GetAsteroids() const;
+   const ShotBuffer& GetShots() const;
+
+   int GetScore() const;
+
+   //how many asteroids were split by copying halves out of the fracture library, and how
+   //many had to be cut in the background, since InitializeAsteroids
+   std::size_t GetNumLibrarySplits() const;
+   std::size_t GetNumRuntimeSplits() const;
+
+   //how many times asteroids were synced with their kinematics, and how many times ones
+   //at reduced detail put it off, since InitializeAsteroids
+   std::size_t GetNumAsteroidSyncs() const;
+   std::size_t GetNumDeferredAsteroidSyncs() const;
+
+   //how many times the contact cache allocated since InitializeAsteroids
+   std::size_t GetNumContactCacheAllocations() const;
+
+   unsigned int GetWorldSeed() const;
+
+   const SimulationTimings& GetTimings() const;
+   void ResetTimings();
+
+private:
+   SimulationListener* listener;
+
+   unsigned int worldSeed;
+
+   MPM::Random asteroidRandom;
+   MPM::Random splitRandom;
+
+   WorkerPool workerPool;
+
+   ContactCache contactCache;
+
+   std::unique_ptr<Broadphase> broadphase;
+
+   Player player;
+
+   int score;
+
+   std::size_t numLibrarySplits;
+   std::size_t numRuntimeSplits;
+
+   std::size_t numAsteroidSyncs;
+   std::size_t numDeferredAsteroidSyncs;
+
+   //counts the steps, to spread the syncs of asteroids at reduced detail over them
+   unsigned int lodStep;
+
+   double accumulatedTime;
+   float interpolationFactor;
+
+   float viewHorizontalFieldOfView;
+   float viewVerticalFieldOfView;
+   float viewFarDistance;
+
+   std::shared_ptr<const FractureLibrary> fractureLibrary;
+
+   AsteroidKinematics asteroidKinematics;
+   AsteroidPool asteroidPool;
+
+   //whether each asteroid, by kinematics index, was synced during the last TickAsteroids
+   std::vector<unsigned char> asteroidsSynced;
+   ShotBuffer shots;
+
+   //an asteroid that was shot and is being split on a worker thread. It stays in the
+   //simulation until the next step, when the fragments take its place
+   struct PendingSplit
+   {
+      AsteroidHandle parent;
+
+      //the parent's frame, and the cut, at the time of the split
+      ModelFrame parentFrame;
+      Locus::FVector3 splitPoint;
+      Locus::FVector3 splitNormal;
+
+      //allocated from the pool, but not active until they take the parent's place
+      AsteroidHandle fragment1;
+      AsteroidHandle fragment2;
+   };
+
+   std::vector<PendingSplit> pendingSplits;
+
+   SimulationTimings timings;
+
+   void TickAsteroids(double DT);
+   void UpdateShotPositions(double DT);
+   void CheckForAsteroidHits();
+
+   Locus::Plane MakeHalfSplitPlane(const Locus::FVector3& shotPosition, const Locus::FVector3& asteroidCentroid);
+   void SplitAsteroid(std::size_t splitIndex, const Locus::FVector3& shotPosition);
+   void FinishPendingSplits();
+   void AddFragments(AsteroidHandle fragment1, AsteroidHandle fragment2);
+   void RemoveAsteroid(AsteroidHandle handle);
+};
+
+}
\ No newline at end of file
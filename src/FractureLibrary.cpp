@@ -0,0 +1,213 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "FractureLibrary.h"
+#include "SAPReading.h"
+#include "WorkerPool.h"
+
+#include "Locus/FileSystem/MountedFilePath.h"
+
+#include "Locus/Geometry/Plane.h"
+#include "Locus/Geometry/Transformation.h"
+
+#include "Locus/Rendering/Mesh.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include <cmath>
+
+namespace MPM
+{
+
+//the cuts follow the three axes and the four diagonals of a cube, so no cut is more
+//than about 40 degrees away from one of them
+static const float Inverse_Root_3 = 0.57735026919f;
+
+static const Locus::FVector3 Directions[FractureLibrary::Num_Directions] =
+{
+   Locus::FVector3(1.0f, 0.0f, 0.0f),
+   Locus::FVector3(0.0f, 1.0f, 0.0f),
+   Locus::FVector3(0.0f, 0.0f, 1.0f),
+   Locus::FVector3(Inverse_Root_3, Inverse_Root_3, Inverse_Root_3),
+   Locus::FVector3(-Inverse_Root_3, Inverse_Root_3, Inverse_Root_3),
+   Locus::FVector3(Inverse_Root_3, -Inverse_Root_3, Inverse_Root_3),
+   Locus::FVector3(Inverse_Root_3, Inverse_Root_3, -Inverse_Root_3)
+};
+
+FractureNode::FractureNode()
+   : asteroid( std::make_shared<Asteroid>() )
+{
+}
+
+static void FinishFragment(FractureNode& fragment, const FractureNode& node, const Locus::FVector3& cutNormal)
+{
+   //same as splitting at runtime: the piece is moved to its centroid, which the cut
+   //leaves where it was in the model space of the piece it was cut from
+   fragment.offset = fragment.asteroid->centroid;
+
+   fragment.asteroid->Reset(fragment.asteroid->centroid);
+   fragment.asteroid->AssignNormals();
+   fragment.asteroid->UpdateMaxDistanceToCenter();
+   fragment.asteroid->CreateBoundingVolumeHierarchy(*node.asteroid, ModelFrame(), Locus::Vec3D::ZeroVector(), cutNormal);
+   fragment.asteroid->CreateConvexHull();
+}
+
+//returns how many fragments were made
+static std::size_t Fracture(FractureNode& node, unsigned int depth)
+{
+   if (depth == 0)
+   {
+      return 0;
+   }
+
+   std::size_t numFragments = 0;
+
+   node.children.resize(2 * FractureLibrary::Num_Directions);
+
+   for (std::size_t directionIndex = 0; directionIndex < FractureLibrary::Num_Directions; ++directionIndex)
+   {
+      std::unique_ptr<FractureNode> front( std::make_unique<FractureNode>() );
+      std::unique_ptr<FractureNode> back( std::make_unique<FractureNode>() );
+
+      //every piece, the models included, is centered on its centroid, so the origin of its
+      //model space is where the cut goes through
+      Locus::Plane cut(Locus::Vec3D::ZeroVector(), Directions[directionIndex]);
+
+      node.asteroid->DetermineSplit(cut, Locus::Transformation::Identity(), *front->asteroid, *back->asteroid);
+
+      if ((front->asteroid->NumFaces() > 0) && (back->asteroid->NumFaces() > 0))
+      {
+         FinishFragment(*front, node, Directions[directionIndex]);
+         FinishFragment(*back, node, -Directions[directionIndex]);
+
+         numFragments += 2 + Fracture(*front, depth - 1) + Fracture(*back, depth - 1);
+
+         node.children[2 * directionIndex] = std::move(front);
+         node.children[2 * directionIndex + 1] = std::move(back);
+      }
+   }
+
+   return numFragments;
+}
+
+FractureLibrary::FractureLibrary()
+   : numFragments(0)
+{
+}
+
+void FractureLibrary::Build(const std::vector<std::unique_ptr<Locus::Mesh>>& meshes, unsigned int depth, WorkerPool& workerPool)
+{
+   std::size_t numModels = meshes.size();
+
+   models.clear();
+   models.resize(numModels);
+
+   std::vector<std::size_t> numModelFragments(numModels, 0);
+
+   workerPool.ParallelFor(numModels, 1, [&](std::size_t begin, std::size_t end)
+   {
+      for (std::size_t modelIndex = begin; modelIndex < end; ++modelIndex)
+      {
+         std::unique_ptr<FractureNode> model( std::make_unique<FractureNode>() );
+
+         model->asteroid->GrabMesh(*meshes[modelIndex]);
+
+         model->asteroid->ComputeCentroid();
+         model->asteroid->ToModel();
+         model->asteroid->centroid = Locus::Vec3D::ZeroVector();
+
+         model->asteroid->UpdateMaxDistanceToCenter();
+         model->asteroid->CreateBoundingVolumeHierarchy();
+         model->asteroid->CreateConvexHull();
+         model->offset = Locus::Vec3D::ZeroVector();
+
+         numModelFragments[modelIndex] = Fracture(*model, depth);
+
+         models[modelIndex] = std::move(model);
+      }
+   });
+
+   numFragments = 0;
+
+   for (std::size_t modelFragments : numModelFragments)
+   {
+      numFragments += modelFragments;
+   }
+}
+
+std::shared_ptr<const FractureLibrary> FractureLibrary::Load(const std::string& modelFile, unsigned int depth, WorkerPool& workerPool)
+{
+   static std::mutex librariesMutex;
+   static std::map<std::pair<std::string, unsigned int>, std::shared_ptr<const FractureLibrary>> libraries;
+
+   std::lock_guard<std::mutex> lock(librariesMutex);
+
+   std::shared_ptr<const FractureLibrary>& library = libraries[std::make_pair(modelFile, depth)];
+
+   if (library == nullptr)
+   {
+      std::vector<std::unique_ptr<Locus::Mesh>> meshes;
+
+      ParseSAPFile(Locus::MountedFilePath("data/" + modelFile), meshes);
+
+      std::shared_ptr<FractureLibrary> newLibrary = std::make_shared<FractureLibrary>();
+      newLibrary->Build(meshes, depth, workerPool);
+
+      library = newLibrary;
+   }
+
+   return library;
+}
+
+std::size_t FractureLibrary::NumModels() const
+{
+   return models.size();
+}
+
+const FractureNode& FractureLibrary::GetModel(std::size_t modelIndex) const
+{
+   return *models[modelIndex];
+}
+
+std::size_t FractureLibrary::NumFragments() const
+{
+   return numFragments;
+}
+
+const Locus::FVector3& FractureLibrary::Direction(std::size_t directionIndex)
+{
+   return Directions[directionIndex];
+}
+
+std::size_t FractureLibrary::ClosestDirection(const Locus::FVector3& normal, bool& flipped)
+{
+   std::size_t closestDirection = 0;
+   float largestAlignment = -1.0f;
+
+   flipped = false;
+
+   for (std::size_t directionIndex = 0; directionIndex < Num_Directions; ++directionIndex)
+   {
+      float alignment = Dot(normal, Directions[directionIndex]);
+
+      if (std::abs(alignment) > largestAlignment)
+      {
+         largestAlignment = std::abs(alignment);
+         closestDirection = directionIndex;
+         flipped = (alignment < 0.0f);
+      }
+   }
+
+   return closestDirection;
+}
+
+}
\ No newline at end of file
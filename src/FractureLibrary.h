@@ -0,0 +1,90 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Asteroid.h"
+
+#include "Locus/Math/Vectors.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+namespace Locus
+{
+
+class Mesh;
+
+}
+
+namespace MPM
+{
+
+class WorkerPool;
+
+//One piece of a pre-fractured asteroid model
+struct FractureNode
+{
+   FractureNode();
+
+   //the piece, centered on its own centroid, with its sphere tree and convex hull. The
+   //asteroids made from it share its mesh
+   std::shared_ptr<Asteroid> asteroid;
+
+   //where the piece's centroid lies in the model space of the piece it was cut from
+   Locus::FVector3 offset;
+
+   //children[2 * d] and children[2 * d + 1] are the halves on the front and back of the
+   //plane through the centroid along FractureLibrary::Direction(d). Both are null if
+   //that cut came out empty, and there are none at all at the bottom of the library
+   std::vector<std::unique_ptr<FractureNode>> children;
+};
+
+//Every asteroid model cut into halves along a fixed set of directions, each half cut
+//again the same way, down to a given depth. Splitting an asteroid that came out of the
+//library only has to pick the cut closest to where it was hit and copy the halves
+class FractureLibrary
+{
+public:
+   static const std::size_t Num_Directions = 7;
+
+   FractureLibrary();
+
+   FractureLibrary(const FractureLibrary&) = delete;
+   FractureLibrary& operator=(const FractureLibrary&) = delete;
+
+   //cuts every mesh depth times. The meshes are cut in parallel
+   void Build(const std::vector<std::unique_ptr<Locus::Mesh>>& meshes, unsigned int depth, WorkerPool& workerPool);
+
+   //the library of the models in modelFile (in data/) cut depth times. It is built the
+   //first time it is asked for and shared by every simulation after that
+   static std::shared_ptr<const FractureLibrary> Load(const std::string& modelFile, unsigned int depth, WorkerPool& workerPool);
+
+   std::size_t NumModels() const;
+   const FractureNode& GetModel(std::size_t modelIndex) const;
+
+   std::size_t NumFragments() const;
+
+   //a unit direction
+   static const Locus::FVector3& Direction(std::size_t directionIndex);
+
+   //the direction closest to the normal of a cut, in model space, either way around.
+   //flipped is set if the normal points away from it
+   static std::size_t ClosestDirection(const Locus::FVector3& normal, bool& flipped);
+
+private:
+   std::vector<std::unique_ptr<FractureNode>> models;
+   std::size_t numFragments;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,344 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "GridBroadphase.h"
+#include "CollisionBody.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+#include <cassert>
+#include <cmath>
+
+namespace MPM
+{
+
+//occupied cells are handed out to the worker threads in chunks of this many
+static const std::size_t Cell_Chunk_Size = 64;
+
+bool GridBroadphase::CellRange::operator==(const CellRange& other) const
+{
+   return (min[0] == other.min[0]) && (min[1] == other.min[1]) && (min[2] == other.min[2]) &&
+          (max[0] == other.max[0]) && (max[1] == other.max[1]) && (max[2] == other.max[2]);
+}
+
+GridBroadphase::GridBroadphase(WorkerPool& workerPool)
+   : PairBroadphase(workerPool), halfExtent(0.0f), cellSize(1.0f), inverseCellSize(1.0f), numCellsPerAxis(1), cells(1)
+{
+}
+
+void GridBroadphase::SetArena(float halfExtent, float largestRadius)
+{
+   this->halfExtent = halfExtent;
+
+   float arenaLength = 2 * halfExtent;
+
+   cellSize = std::max(2 * largestRadius, arenaLength / Max_Cells_Per_Axis);
+
+   if (cellSize > 0.0f)
+   {
+      numCellsPerAxis = std::max(1, static_cast<int>(std::ceil(arenaLength / cellSize)));
+      inverseCellSize = 1.0f / cellSize;
+   }
+   else
+   {
+      numCellsPerAxis = 1;
+      inverseCellSize = 0.0f;
+   }
+
+   cells.clear();
+   cells.resize(static_cast<std::size_t>(numCellsPerAxis) * numCellsPerAxis * numCellsPerAxis);
+
+   occupiedCells.clear();
+
+   std::size_t numProxies = proxies.size();
+
+   for (std::size_t proxyIndex = 0; proxyIndex < numProxies; ++proxyIndex)
+   {
+      proxies[proxyIndex].cellRange = ComputeCellRange(*proxies[proxyIndex].body);
+      AddToCells(proxyIndex);
+   }
+}
+
+int GridBroadphase::GetNumCellsPerAxis() const
+{
+   return numCellsPerAxis;
+}
+
+float GridBroadphase::GetCellSize() const
+{
+   return cellSize;
+}
+
+void GridBroadphase::Add(CollisionBody* body)
+{
+   assert(body->GetBroadphaseIndex() == CollisionBody::No_Broadphase_Index);
+
+   std::size_t proxyIndex = proxies.size();
+
+   Proxy proxy;
+   proxy.body = body;
+   proxy.cellRange = ComputeCellRange(*body);
+
+   proxies.push_back(proxy);
+
+   body->SetBroadphaseIndex(proxyIndex);
+
+   AddToCells(proxyIndex);
+}
+
+void GridBroadphase::Remove(CollisionBody* body)
+{
+   std::size_t proxyIndex = body->GetBroadphaseIndex();
+
+   assert(proxyIndex < proxies.size());
+
+   RemoveFromCells(proxyIndex);
+
+   std::size_t lastProxyIndex = proxies.size() - 1;
+
+   if (proxyIndex != lastProxyIndex)
+   {
+      RenumberInCells(lastProxyIndex, proxyIndex);
+
+      proxies[proxyIndex] = proxies[lastProxyIndex];
+      proxies[proxyIndex].body->SetBroadphaseIndex(proxyIndex);
+   }
+
+   proxies.pop_back();
+
+   body->SetBroadphaseIndex(CollisionBody::No_Broadphase_Index);
+}
+
+void GridBroadphase::Update(CollisionBody* body)
+{
+   std::size_t proxyIndex = body->GetBroadphaseIndex();
+
+   assert(proxyIndex < proxies.size());
+
+   CellRange cellRange = ComputeCellRange(*body);
+
+   if (cellRange == proxies[proxyIndex].cellRange)
+   {
+      return;
+   }
+
+   RemoveFromCells(proxyIndex);
+
+   proxies[proxyIndex].cellRange = cellRange;
+
+   AddToCells(proxyIndex);
+}
+
+void GridBroadphase::Clear()
+{
+   for (Proxy& proxy : proxies)
+   {
+      proxy.body->SetBroadphaseIndex(CollisionBody::No_Broadphase_Index);
+   }
+
+   proxies.clear();
+
+   for (std::size_t cellIndex : occupiedCells)
+   {
+      cells[cellIndex].proxyIndices.clear();
+   }
+
+   occupiedCells.clear();
+
+   pairs.clear();
+}
+
+void GridBroadphase::UpdateCollisions()
+{
+   std::size_t numOccupiedCells = occupiedCells.size();
+   std::size_t numChunks = (numOccupiedCells + Cell_Chunk_Size - 1) / Cell_Chunk_Size;
+
+   if (chunkPairs.size() < numChunks)
+   {
+      chunkPairs.resize(numChunks);
+   }
+
+   workerPool.ParallelFor(numOccupiedCells, Cell_Chunk_Size, [&](std::size_t begin, std::size_t end)
+   {
+      std::vector<CollisionPair>& cellPairs = chunkPairs[begin / Cell_Chunk_Size];
+
+      cellPairs.clear();
+
+      for (std::size_t occupiedIndex = begin; occupiedIndex < end; ++occupiedIndex)
+      {
+         FindPairsInCell(occupiedCells[occupiedIndex], cellPairs);
+      }
+   });
+
+   pairs.clear();
+
+   for (std::size_t chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+   {
+      pairs.insert(pairs.end(), chunkPairs[chunkIndex].begin(), chunkPairs[chunkIndex].end());
+   }
+}
+
+int GridBroadphase::ToCellCoordinate(float coordinate) const
+{
+   float cellCoordinate = std::floor((coordinate + halfExtent) * inverseCellSize);
+
+   if (cellCoordinate <= 0.0f)
+   {
+      return 0;
+   }
+
+   if (cellCoordinate >= numCellsPerAxis - 1)
+   {
+      return numCellsPerAxis - 1;
+   }
+
+   return static_cast<int>(cellCoordinate);
+}
+
+GridBroadphase::CellRange GridBroadphase::ComputeCellRange(const CollisionBody& body) const
+{
+   const Locus::FVector3& center = body.GetBroadCenter();
+   float radius = body.GetBroadRadius();
+
+   CellRange cellRange;
+
+   cellRange.min[0] = ToCellCoordinate(center.x - radius);
+   cellRange.min[1] = ToCellCoordinate(center.y - radius);
+   cellRange.min[2] = ToCellCoordinate(center.z - radius);
+
+   cellRange.max[0] = ToCellCoordinate(center.x + radius);
+   cellRange.max[1] = ToCellCoordinate(center.y + radius);
+   cellRange.max[2] = ToCellCoordinate(center.z + radius);
+
+   return cellRange;
+}
+
+std::size_t GridBroadphase::ToCellIndex(int x, int y, int z) const
+{
+   return (static_cast<std::size_t>(z) * numCellsPerAxis + y) * numCellsPerAxis + x;
+}
+
+void GridBroadphase::AddToCells(std::size_t proxyIndex)
+{
+   const CellRange& cellRange = proxies[proxyIndex].cellRange;
+
+   for (int z = cellRange.min[2]; z <= cellRange.max[2]; ++z)
+   {
+      for (int y = cellRange.min[1]; y <= cellRange.max[1]; ++y)
+      {
+         for (int x = cellRange.min[0]; x <= cellRange.max[0]; ++x)
+         {
+            std::size_t cellIndex = ToCellIndex(x, y, z);
+            Cell& cell = cells[cellIndex];
+
+            if (cell.proxyIndices.empty())
+            {
+               cell.occupiedIndex = occupiedCells.size();
+               occupiedCells.push_back(cellIndex);
+            }
+
+            cell.proxyIndices.push_back(proxyIndex);
+         }
+      }
+   }
+}
+
+void GridBroadphase::RemoveFromCells(std::size_t proxyIndex)
+{
+   const CellRange& cellRange = proxies[proxyIndex].cellRange;
+
+   for (int z = cellRange.min[2]; z <= cellRange.max[2]; ++z)
+   {
+      for (int y = cellRange.min[1]; y <= cellRange.max[1]; ++y)
+      {
+         for (int x = cellRange.min[0]; x <= cellRange.max[0]; ++x)
+         {
+            Cell& cell = cells[ToCellIndex(x, y, z)];
+
+            std::vector<std::size_t>::iterator proxyIter = std::find(cell.proxyIndices.begin(), cell.proxyIndices.end(), proxyIndex);
+
+            assert(proxyIter != cell.proxyIndices.end());
+
+            *proxyIter = cell.proxyIndices.back();
+            cell.proxyIndices.pop_back();
+
+            if (cell.proxyIndices.empty())
+            {
+               std::size_t movedCellIndex = occupiedCells.back();
+
+               occupiedCells[cell.occupiedIndex] = movedCellIndex;
+               cells[movedCellIndex].occupiedIndex = cell.occupiedIndex;
+
+               occupiedCells.pop_back();
+            }
+         }
+      }
+   }
+}
+
+void GridBroadphase::RenumberInCells(std::size_t oldProxyIndex, std::size_t newProxyIndex)
+{
+   const CellRange& cellRange = proxies[oldProxyIndex].cellRange;
+
+   for (int z = cellRange.min[2]; z <= cellRange.max[2]; ++z)
+   {
+      for (int y = cellRange.min[1]; y <= cellRange.max[1]; ++y)
+      {
+         for (int x = cellRange.min[0]; x <= cellRange.max[0]; ++x)
+         {
+            Cell& cell = cells[ToCellIndex(x, y, z)];
+
+            std::replace(cell.proxyIndices.begin(), cell.proxyIndices.end(), oldProxyIndex, newProxyIndex);
+         }
+      }
+   }
+}
+
+void GridBroadphase::FindPairsInCell(std::size_t cellIndex, std::vector<CollisionPair>& cellPairs) const
+{
+   int cellCoordinates[3];
+
+   cellCoordinates[0] = static_cast<int>(cellIndex % numCellsPerAxis);
+   cellCoordinates[1] = static_cast<int>((cellIndex / numCellsPerAxis) % numCellsPerAxis);
+   cellCoordinates[2] = static_cast<int>(cellIndex / (static_cast<std::size_t>(numCellsPerAxis) * numCellsPerAxis));
+
+   const std::vector<std::size_t>& proxyIndices = cells[cellIndex].proxyIndices;
+   std::size_t numProxies = proxyIndices.size();
+
+   for (std::size_t i = 0; i < numProxies; ++i)
+   {
+      const Proxy& proxy1 = proxies[proxyIndices[i]];
+
+      for (std::size_t j = i + 1; j < numProxies; ++j)
+      {
+         const Proxy& proxy2 = proxies[proxyIndices[j]];
+
+         //only the first cell the two share reports the pair
+         bool firstSharedCell = true;
+
+         for (int axis = 0; axis < 3; ++axis)
+         {
+            if (std::max(proxy1.cellRange.min[axis], proxy2.cellRange.min[axis]) != cellCoordinates[axis])
+            {
+               firstSharedCell = false;
+               break;
+            }
+         }
+
+         if (firstSharedCell && IsCandidatePair(*proxy1.body, *proxy2.body))
+         {
+            cellPairs.push_back( CollisionPair(proxy1.body, proxy2.body) );
+         }
+      }
+   }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Broadphase.h"
+
+#include <vector>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+//A uniform grid over the cubic arena. Each body is kept in every cell its broad extent
+//overlaps, so adding, updating or removing a body only touches the handful of cells
+//around it, and a body that stays within the same cells costs nothing to update.
+//Pairs are found cell by cell on the worker threads. A pair that shares several cells
+//is only reported by the lowest of them (the first cell of their overlap), so no pair
+//is reported twice
+class GridBroadphase : public PairBroadphase
+{
+public:
+   GridBroadphase(WorkerPool& workerPool);
+
+   //the cells are made about as wide as the largest body, but never so small that there
+   //are more than Max_Cells_Per_Axis of them along an axis. Bodies already in the grid
+   //are redistributed into the new cells
+   virtual void SetArena(float halfExtent, float largestRadius) override;
+
+   virtual void Add(CollisionBody* body) override;
+   virtual void Remove(CollisionBody* body) override;
+   virtual void Update(CollisionBody* body) override;
+   virtual void Clear() override;
+
+   virtual void UpdateCollisions() override;
+
+   int GetNumCellsPerAxis() const;
+   float GetCellSize() const;
+
+   static const int Max_Cells_Per_Axis = 128;
+
+private:
+   struct CellRange
+   {
+      int min[3];
+      int max[3];
+
+      bool operator==(const CellRange& other) const;
+   };
+
+   struct Proxy
+   {
+      CollisionBody* body;
+      CellRange cellRange;
+   };
+
+   struct Cell
+   {
+      std::vector<std::size_t> proxyIndices;
+      std::size_t occupiedIndex;
+   };
+
+   float halfExtent;
+   float cellSize;
+   float inverseCellSize;
+   int numCellsPerAxis;
+
+   std::vector<Proxy> proxies;
+   std::vector<Cell> cells;
+
+   //indices of the cells that hold at least one body, so that pair finding skips empty space
+   std::vector<std::size_t> occupiedCells;
+
+   //pairs found by each chunk of occupied cells, merged into pairs in chunk order
+   std::vector<std::vector<CollisionPair>> chunkPairs;
+
+   int ToCellCoordinate(float coordinate) const;
+   CellRange ComputeCellRange(const CollisionBody& body) const;
+   std::size_t ToCellIndex(int x, int y, int z) const;
+
+   void AddToCells(std::size_t proxyIndex);
+   void RemoveFromCells(std::size_t proxyIndex);
+   void RenumberInCells(std::size_t oldProxyIndex, std::size_t newProxyIndex);
+
+   void FindPairsInCell(std::size_t cellIndex, std::vector<CollisionPair>& cellPairs) const;
+};
+
+}
\ No newline at end of file
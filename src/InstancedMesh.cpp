@@ -0,0 +1,37 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "InstancedMesh.h"
+
+#include "Locus/Geometry/Triangle.h"
+
+#include "Locus/Rendering/DefaultGPUVertexData.h"
+
+namespace MPM
+{
+
+bool InstancedMesh::BindGPUVertexData() const
+{
+   if (gpuVertexData == nullptr)
+   {
+      return false;
+   }
+
+   gpuVertexData->Bind();
+
+   return true;
+}
+
+std::size_t InstancedMesh::NumGPUVertices() const
+{
+   return NumFaces() * Locus::Triangle3D_t::NumPointsOnATriangle;
+}
+
+}
@@ -0,0 +1,32 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Rendering/Mesh.h"
+
+#include <cstddef>
+
+namespace MPM
+{
+
+//A mesh that an InstancedProgram can draw many copies of in one draw call. Locus keeps a
+//drawable's GPU vertex data to the drawable itself, so this only lets the program bind it
+class InstancedMesh : public Locus::Mesh
+{
+public:
+   //binds the GPU vertex data, an array of Locus::GPUVertexDataStorage with one entry per
+   //corner of each face, as the current array buffer. Returns false if there is none
+   bool BindGPUVertexData() const;
+
+   std::size_t NumGPUVertices() const;
+};
+
+}
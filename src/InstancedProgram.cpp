@@ -0,0 +1,465 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "InstancedProgram.h"
+#include "InstancedMesh.h"
+#include "ModelFrame.h"
+
+#include "Locus/Geometry/Transformation.h"
+
+#include "Locus/Rendering/DefaultGPUVertexData.h"
+#include "Locus/Rendering/Light.h"
+#include "Locus/Rendering/Viewpoint.h"
+
+#include <algorithm>
+#include <string>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+//lighting is worked out in eye space. Asteroids are only ever scaled uniformly, so the
+//normal is turned by the same transformations as the position and normalized again per
+//fragment
+static const char* Vertex_Shader_Source =
+   "#version 110\n"
+   "uniform mat4 view;\n"
+   "uniform mat4 projection;\n"
+   "attribute vec3 position;\n"
+   "attribute vec3 normal;\n"
+   "attribute vec2 texCoord;\n"
+   "attribute vec4 instanceColor;\n"
+   "attribute mat4 instanceTransformation;\n"
+   "varying vec3 fragEyePosition;\n"
+   "varying vec3 fragEyeNormal;\n"
+   "varying vec2 fragTexCoord;\n"
+   "varying vec4 fragColor;\n"
+   "void main()\n"
+   "{\n"
+   "   vec4 eyePosition = view * (instanceTransformation * vec4(position, 1.0));\n"
+   "   vec4 eyeNormal = view * (instanceTransformation * vec4(normal, 0.0));\n"
+   "   fragEyePosition = eyePosition.xyz;\n"
+   "   fragEyeNormal = eyeNormal.xyz;\n"
+   "   fragTexCoord = texCoord;\n"
+   "   fragColor = instanceColor;\n"
+   "   gl_Position = projection * eyePosition;\n"
+   "}\n";
+
+//the lights are a fixed size array with only the first numLights in use, so that one
+//program serves any number of them. BuildProgram puts the #version and MAX_LIGHTS in
+//front
+static const char* Fragment_Shader_Source =
+   "uniform sampler2D diffuseMap;\n"
+   "uniform int numLights;\n"
+   "uniform vec3 lightEyePositions[MAX_LIGHTS];\n"
+   "uniform vec3 lightColors[MAX_LIGHTS];\n"
+   "uniform vec3 lightAttenuations[MAX_LIGHTS];\n"
+   "varying vec3 fragEyePosition;\n"
+   "varying vec3 fragEyeNormal;\n"
+   "varying vec2 fragTexCoord;\n"
+   "varying vec4 fragColor;\n"
+   "void main()\n"
+   "{\n"
+   "   vec4 color = fragColor * texture2D(diffuseMap, fragTexCoord);\n"
+   "   if (numLights > 0)\n"
+   "   {\n"
+   "      vec3 normal = normalize(fragEyeNormal);\n"
+   "      vec3 diffuse = vec3(0.0);\n"
+   "      for (int lightIndex = 0; lightIndex < MAX_LIGHTS; ++lightIndex)\n"
+   "      {\n"
+   "         if (lightIndex < numLights)\n"
+   "         {\n"
+   "            vec3 toLight = lightEyePositions[lightIndex] - fragEyePosition;\n"
+   "            float distance = length(toLight);\n"
+   "            float attenuation = dot(lightAttenuations[lightIndex], vec3(1.0, distance, distance * distance));\n"
+   "            diffuse += lightColors[lightIndex] * max(dot(normal, toLight / distance), 0.0) / attenuation;\n"
+   "         }\n"
+   "      }\n"
+   "      color.rgb *= diffuse;\n"
+   "   }\n"
+   "   gl_FragColor = color;\n"
+   "}\n";
+
+static const std::size_t Min_Instance_Buffer_Capacity = 64;
+
+static bool InstancingSupported()
+{
+   return (GLEW_VERSION_3_3 || (GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced));
+}
+
+static void VertexAttribDivisor(GLuint location, GLuint divisor)
+{
+   if (GLEW_VERSION_3_3)
+   {
+      glVertexAttribDivisor(location, divisor);
+   }
+   else
+   {
+      glVertexAttribDivisorARB(location, divisor);
+   }
+}
+
+static void DrawArraysInstanced(GLenum mode, GLsizei numVertices, GLsizei numInstances)
+{
+   if (GLEW_VERSION_3_3)
+   {
+      glDrawArraysInstanced(mode, 0, numVertices, numInstances);
+   }
+   else
+   {
+      glDrawArraysInstancedARB(mode, 0, numVertices, numInstances);
+   }
+}
+
+static GLuint CompileShader(GLenum type, const std::string& source)
+{
+   GLuint shaderID = glCreateShader(type);
+
+   const char* sourceString = source.c_str();
+
+   glShaderSource(shaderID, 1, &sourceString, nullptr);
+   glCompileShader(shaderID);
+
+   GLint compiled = GL_FALSE;
+   glGetShaderiv(shaderID, GL_COMPILE_STATUS, &compiled);
+
+   if (compiled == GL_FALSE)
+   {
+      glDeleteShader(shaderID);
+      return 0;
+   }
+
+   return shaderID;
+}
+
+static void* BufferOffset(std::size_t offset)
+{
+   return reinterpret_cast<void*>(offset);
+}
+
+static void SetColumnMajor(float (&matrix)[16], const Locus::FVector3 (&columns)[4])
+{
+   for (int column = 0; column < 4; ++column)
+   {
+      matrix[4 * column] = columns[column].x;
+      matrix[4 * column + 1] = columns[column].y;
+      matrix[4 * column + 2] = columns[column].z;
+      matrix[4 * column + 3] = (column == 3) ? 1.0f : 0.0f;
+   }
+}
+
+void InstanceAttributes::Set(const ModelFrame& frame, const Locus::FVector3& offset, const Locus::Color& color)
+{
+   Locus::FVector3 columns[4] = { frame.VectorToWorld(Locus::Vec3D::XAxis()),
+                                  frame.VectorToWorld(Locus::Vec3D::YAxis()),
+                                  frame.VectorToWorld(Locus::Vec3D::ZAxis()),
+                                  frame.GetOrigin() + offset };
+
+   SetColumnMajor(transformation, columns);
+
+   this->color[0] = color.r / 255.0f;
+   this->color[1] = color.g / 255.0f;
+   this->color[2] = color.b / 255.0f;
+   this->color[3] = color.a / 255.0f;
+}
+
+void InstanceAttributes::Set(const Locus::Transformation& modelTransformation, const Locus::FVector3& offset, const Locus::Color& color)
+{
+   //model transformations are affine, so the bottom row is left out
+   Locus::FVector3 columns[4];
+
+   for (int column = 0; column < 4; ++column)
+   {
+      columns[column] = Locus::FVector3(modelTransformation(0, column), modelTransformation(1, column), modelTransformation(2, column));
+   }
+
+   columns[3] += offset;
+
+   SetColumnMajor(transformation, columns);
+
+   this->color[0] = color.r / 255.0f;
+   this->color[1] = color.g / 255.0f;
+   this->color[2] = color.b / 255.0f;
+   this->color[3] = color.a / 255.0f;
+}
+
+InstancedProgram::InstancedProgram()
+   : programID(0), instanceBufferID(0), instanceBufferCapacity(0),
+     positionLocation(-1), normalLocation(-1), texCoordLocation(-1), instanceColorLocation(-1), instanceTransformationLocation(-1),
+     viewLocation(-1), projectionLocation(-1), diffuseMapLocation(-1),
+     numLightsLocation(-1), lightEyePositionsLocation(-1), lightColorsLocation(-1), lightAttenuationsLocation(-1),
+     previousProgramID(0)
+{
+}
+
+InstancedProgram::~InstancedProgram()
+{
+   Unload();
+}
+
+bool InstancedProgram::Load()
+{
+   Unload();
+
+   if (!InstancingSupported() || !BuildProgram())
+   {
+      Unload();
+      return false;
+   }
+
+   glGenBuffers(1, &instanceBufferID);
+
+   return true;
+}
+
+bool InstancedProgram::BuildProgram()
+{
+   GLuint vertexShaderID = CompileShader(GL_VERTEX_SHADER, Vertex_Shader_Source);
+   GLuint fragmentShaderID = CompileShader(GL_FRAGMENT_SHADER, "#version 110\n#define MAX_LIGHTS " + std::to_string(Max_Lights) + "\n" + Fragment_Shader_Source);
+
+   if ((vertexShaderID != 0) && (fragmentShaderID != 0))
+   {
+      programID = glCreateProgram();
+
+      glAttachShader(programID, vertexShaderID);
+      glAttachShader(programID, fragmentShaderID);
+      glLinkProgram(programID);
+   }
+
+   //the program keeps the shaders for as long as they are attached
+   glDeleteShader(vertexShaderID);
+   glDeleteShader(fragmentShaderID);
+
+   if (programID == 0)
+   {
+      return false;
+   }
+
+   GLint linked = GL_FALSE;
+   glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+
+   if (linked == GL_FALSE)
+   {
+      return false;
+   }
+
+   positionLocation = glGetAttribLocation(programID, "position");
+   normalLocation = glGetAttribLocation(programID, "normal");
+   texCoordLocation = glGetAttribLocation(programID, "texCoord");
+   instanceColorLocation = glGetAttribLocation(programID, "instanceColor");
+   instanceTransformationLocation = glGetAttribLocation(programID, "instanceTransformation");
+
+   viewLocation = glGetUniformLocation(programID, "view");
+   projectionLocation = glGetUniformLocation(programID, "projection");
+   diffuseMapLocation = glGetUniformLocation(programID, "diffuseMap");
+
+   numLightsLocation = glGetUniformLocation(programID, "numLights");
+   lightEyePositionsLocation = glGetUniformLocation(programID, "lightEyePositions");
+   lightColorsLocation = glGetUniformLocation(programID, "lightColors");
+   lightAttenuationsLocation = glGetUniformLocation(programID, "lightAttenuations");
+
+   if ((positionLocation < 0) || (normalLocation < 0) || (texCoordLocation < 0) || (instanceColorLocation < 0) || (instanceTransformationLocation < 0))
+   {
+      return false;
+   }
+
+   attributeLocations.clear();
+
+   attributeLocations.push_back(static_cast<GLuint>(positionLocation));
+   attributeLocations.push_back(static_cast<GLuint>(normalLocation));
+   attributeLocations.push_back(static_cast<GLuint>(texCoordLocation));
+   attributeLocations.push_back(static_cast<GLuint>(instanceColorLocation));
+
+   //a mat4 attribute takes four locations in a row, one per column
+   for (GLuint column = 0; column < 4; ++column)
+   {
+      attributeLocations.push_back(static_cast<GLuint>(instanceTransformationLocation) + column);
+   }
+
+   attributesWereEnabled.resize(attributeLocations.size());
+
+   return true;
+}
+
+void InstancedProgram::Unload()
+{
+   if (instanceBufferID != 0)
+   {
+      glDeleteBuffers(1, &instanceBufferID);
+      instanceBufferID = 0;
+   }
+
+   instanceBufferCapacity = 0;
+
+   if (programID != 0)
+   {
+      glDeleteProgram(programID);
+      programID = 0;
+   }
+
+   attributeLocations.clear();
+   attributesWereEnabled.clear();
+}
+
+bool InstancedProgram::IsLoaded() const
+{
+   return (instanceBufferID != 0);
+}
+
+void InstancedProgram::Begin(const Locus::Transformation& projection, const Locus::Viewpoint& viewpoint)
+{
+   glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgramID);
+   glUseProgram(programID);
+
+   //the view is affine, so it is found from where it takes the origin and the axes
+   Locus::FVector3 eyeOrigin = viewpoint.ToEyePosition(Locus::Vec3D::ZeroVector());
+
+   Locus::FVector3 viewColumns[4] = { viewpoint.ToEyePosition(Locus::Vec3D::XAxis()) - eyeOrigin,
+                                      viewpoint.ToEyePosition(Locus::Vec3D::YAxis()) - eyeOrigin,
+                                      viewpoint.ToEyePosition(Locus::Vec3D::ZAxis()) - eyeOrigin,
+                                      eyeOrigin };
+
+   float view[16];
+   SetColumnMajor(view, viewColumns);
+
+   float projectionMatrix[16];
+
+   for (int column = 0; column < 4; ++column)
+   {
+      for (int row = 0; row < 4; ++row)
+      {
+         projectionMatrix[4 * column + row] = projection(row, column);
+      }
+   }
+
+   glUniformMatrix4fv(viewLocation, 1, GL_FALSE, view);
+   glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, projectionMatrix);
+   glUniform1i(diffuseMapLocation, 0);
+   glUniform1i(numLightsLocation, 0);
+
+   for (std::size_t attributeIndex = 0; attributeIndex < attributeLocations.size(); ++attributeIndex)
+   {
+      glGetVertexAttribiv(attributeLocations[attributeIndex], GL_VERTEX_ATTRIB_ARRAY_ENABLED, &attributesWereEnabled[attributeIndex]);
+      glEnableVertexAttribArray(attributeLocations[attributeIndex]);
+   }
+
+   VertexAttribDivisor(instanceColorLocation, 1);
+
+   for (GLuint column = 0; column < 4; ++column)
+   {
+      VertexAttribDivisor(instanceTransformationLocation + column, 1);
+   }
+}
+
+void InstancedProgram::SetLights(const std::vector<Locus::Light>& lights, unsigned int numLights)
+{
+   if (numLights > Max_Lights)
+   {
+      numLights = Max_Lights;
+   }
+
+   if (numLights > lights.size())
+   {
+      numLights = static_cast<unsigned int>(lights.size());
+   }
+
+   if (numLights > 0)
+   {
+      float eyePositions[3 * Max_Lights];
+      float colors[3 * Max_Lights];
+      float attenuations[3 * Max_Lights];
+
+      for (unsigned int lightIndex = 0; lightIndex < numLights; ++lightIndex)
+      {
+         const Locus::Light& light = lights[lightIndex];
+
+         eyePositions[3 * lightIndex] = light.eyePosition.x;
+         eyePositions[3 * lightIndex + 1] = light.eyePosition.y;
+         eyePositions[3 * lightIndex + 2] = light.eyePosition.z;
+
+         colors[3 * lightIndex] = light.diffuseColor.r / 255.0f;
+         colors[3 * lightIndex + 1] = light.diffuseColor.g / 255.0f;
+         colors[3 * lightIndex + 2] = light.diffuseColor.b / 255.0f;
+
+         attenuations[3 * lightIndex] = light.attenuation;
+         attenuations[3 * lightIndex + 1] = light.linearAttenuation;
+         attenuations[3 * lightIndex + 2] = light.quadraticAttenuation;
+      }
+
+      glUniform3fv(lightEyePositionsLocation, static_cast<GLsizei>(numLights), eyePositions);
+      glUniform3fv(lightColorsLocation, static_cast<GLsizei>(numLights), colors);
+      glUniform3fv(lightAttenuationsLocation, static_cast<GLsizei>(numLights), attenuations);
+   }
+
+   glUniform1i(numLightsLocation, static_cast<GLint>(numLights));
+}
+
+void InstancedProgram::Draw(const InstancedMesh& mesh, const std::vector<InstanceAttributes>& instances)
+{
+   if (instances.empty() || !mesh.BindGPUVertexData())
+   {
+      return;
+   }
+
+   GLsizei vertexStride = static_cast<GLsizei>(sizeof(Locus::GPUVertexDataStorage));
+
+   glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, vertexStride, BufferOffset(offsetof(Locus::GPUVertexDataStorage, position)));
+   glVertexAttribPointer(normalLocation, 3, GL_FLOAT, GL_FALSE, vertexStride, BufferOffset(offsetof(Locus::GPUVertexDataStorage, normal)));
+   glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, vertexStride, BufferOffset(offsetof(Locus::GPUVertexDataStorage, texCoord)));
+
+   glBindBuffer(GL_ARRAY_BUFFER, instanceBufferID);
+
+   //a fresh store every draw (orphaning), so the driver doesn't wait for the last draw
+   //to finish with the old one
+   if (instances.size() > instanceBufferCapacity)
+   {
+      instanceBufferCapacity = std::max(2 * instanceBufferCapacity, std::max(instances.size(), Min_Instance_Buffer_Capacity));
+   }
+
+   glBufferData(GL_ARRAY_BUFFER, instanceBufferCapacity * sizeof(InstanceAttributes), nullptr, GL_STREAM_DRAW);
+   glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(InstanceAttributes), instances.data());
+
+   GLsizei instanceStride = static_cast<GLsizei>(sizeof(InstanceAttributes));
+
+   glVertexAttribPointer(instanceColorLocation, 4, GL_FLOAT, GL_FALSE, instanceStride, BufferOffset(offsetof(InstanceAttributes, color)));
+
+   for (GLuint column = 0; column < 4; ++column)
+   {
+      glVertexAttribPointer(instanceTransformationLocation + column, 4, GL_FLOAT, GL_FALSE, instanceStride,
+                            BufferOffset(offsetof(InstanceAttributes, transformation) + 4 * column * sizeof(float)));
+   }
+
+   DrawArraysInstanced(GL_TRIANGLES, static_cast<GLsizei>(mesh.NumGPUVertices()), static_cast<GLsizei>(instances.size()));
+}
+
+void InstancedProgram::End()
+{
+   VertexAttribDivisor(instanceColorLocation, 0);
+
+   for (GLuint column = 0; column < 4; ++column)
+   {
+      VertexAttribDivisor(instanceTransformationLocation + column, 0);
+   }
+
+   for (std::size_t attributeIndex = 0; attributeIndex < attributeLocations.size(); ++attributeIndex)
+   {
+      if (attributesWereEnabled[attributeIndex] == GL_FALSE)
+      {
+         glDisableVertexAttribArray(attributeLocations[attributeIndex]);
+      }
+   }
+
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+   glUseProgram(static_cast<GLuint>(previousProgramID));
+}
+
+}
@@ -0,0 +1,115 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include "Locus/Rendering/Color.h"
+#include "Locus/Rendering/Locus_glew.h"
+
+#include <vector>
+
+#include <cstddef>
+
+namespace Locus
+{
+
+class Transformation;
+class Viewpoint;
+struct Light;
+
+}
+
+namespace MPM
+{
+
+class InstancedMesh;
+class ModelFrame;
+
+//What an InstancedProgram draws one copy of a mesh with
+struct InstanceAttributes
+{
+   //the model transformation (column-major, as GL takes it)
+   float transformation[16];
+
+   //multiplies the texture color, each component in [0, 1]
+   float color[4];
+
+   void Set(const ModelFrame& frame, const Locus::FVector3& offset, const Locus::Color& color);
+   void Set(const Locus::Transformation& modelTransformation, const Locus::FVector3& offset, const Locus::Color& color);
+};
+
+//A textured shader program that draws many copies of one InstancedMesh in a single
+//glDrawArraysInstanced call. Each copy's model transformation and color are per-instance
+//vertex attributes, streamed into a buffer of the program's own every draw. Locus'
+//programs take the model transformation as a uniform, so this one is built here. It is
+//drawn with between Begin and End, which put back the program that was in use
+class InstancedProgram
+{
+public:
+   //the most point lights SetLights takes
+   static const unsigned int Max_Lights = 8;
+
+   InstancedProgram();
+   ~InstancedProgram();
+
+   InstancedProgram(const InstancedProgram&) = delete;
+   InstancedProgram& operator=(const InstancedProgram&) = delete;
+
+   //needs a current GL context. Returns false, leaving the program unloaded, if the
+   //context can't draw instanced or the program doesn't build
+   bool Load();
+   void Unload();
+
+   bool IsLoaded() const;
+
+   //draws with the texture bound to texture unit 0, as seen from viewpoint through projection.
+   //What is drawn is unlit until SetLights is called
+   void Begin(const Locus::Transformation& projection, const Locus::Viewpoint& viewpoint);
+
+   //lights what is drawn after it with the first numLights of lights (at most Max_Lights),
+   //whose positions are in eye space. Each gives diffuse light, falling off with its
+   //constant, linear and quadratic attenuation. 0 lights draws unlit
+   void SetLights(const std::vector<Locus::Light>& lights, unsigned int numLights);
+
+   void Draw(const InstancedMesh& mesh, const std::vector<InstanceAttributes>& instances);
+   void End();
+
+private:
+   GLuint programID;
+   GLuint instanceBufferID;
+   std::size_t instanceBufferCapacity;
+
+   GLint positionLocation;
+   GLint normalLocation;
+   GLint texCoordLocation;
+   GLint instanceColorLocation;
+   GLint instanceTransformationLocation;
+
+   GLint viewLocation;
+   GLint projectionLocation;
+   GLint diffuseMapLocation;
+
+   GLint numLightsLocation;
+   GLint lightEyePositionsLocation;
+   GLint lightColorsLocation;
+   GLint lightAttenuationsLocation;
+
+   GLint previousProgramID;
+
+   //the attribute arrays the program uses, and whether each was enabled before Begin
+   std::vector<GLuint> attributeLocations;
+   std::vector<GLint> attributesWereEnabled;
+
+   bool BuildProgram();
+};
+
+}
@@ -0,0 +1,57 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "LocusBroadphase.h"
+#include "CollisionBody.h"
+
+namespace MPM
+{
+
+void LocusBroadphase::Add(CollisionBody* body)
+{
+   collisionManager.Add(body);
+}
+
+void LocusBroadphase::Remove(CollisionBody* body)
+{
+   collisionManager.Remove(body);
+}
+
+void LocusBroadphase::Update(CollisionBody* body)
+{
+   collisionManager.Update(body);
+}
+
+void LocusBroadphase::Clear()
+{
+   collisionManager.Clear();
+}
+
+void LocusBroadphase::StartAddRemoveBatch()
+{
+   collisionManager.StartAddRemoveBatch();
+}
+
+void LocusBroadphase::FinishAddRemoveBatch()
+{
+   collisionManager.FinishAddRemoveBatch();
+}
+
+void LocusBroadphase::UpdateCollisions()
+{
+   collisionManager.UpdateCollisions();
+}
+
+void LocusBroadphase::TransmitCollisions()
+{
+   collisionManager.TransmitCollisions();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Broadphase.h"
+
+#include "Locus/Geometry/CollisionManager.h"
+
+namespace MPM
+{
+
+//The generic Locus::CollisionManager behind the Broadphase interface
+class LocusBroadphase : public Broadphase
+{
+public:
+   virtual void Add(CollisionBody* body) override;
+   virtual void Remove(CollisionBody* body) override;
+   virtual void Update(CollisionBody* body) override;
+   virtual void Clear() override;
+
+   virtual void StartAddRemoveBatch() override;
+   virtual void FinishAddRemoveBatch() override;
+
+   virtual void UpdateCollisions() override;
+   virtual void TransmitCollisions() override;
+
+private:
+   Locus::CollisionManager collisionManager;
+};
+
+}
\ No newline at end of file
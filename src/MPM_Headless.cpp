@@ -0,0 +1,439 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+//Runs the demo's gameplay loop (DemoSimulation) with no window, GL context or audio
+//at a fixed time step and reports how long each phase of the simulation took.
+//With --benchmark-broadphase it instead compares the broadphases on their own, with
+//--benchmark-split-trees it times building fragment trees from their parents' trees,
+//and with --check it runs the simulation checks (SimulationChecks.h)
+
+#include "Locus/FileSystem/FileSystem.h"
+#include "Locus/FileSystem/FileSystemUtil.h"
+
+#include "Locus/Common/Exception.h"
+
+#include "BroadphaseBenchmark.h"
+#include "Config.h"
+#include "DemoSimulation.h"
+#include "FractureLibrary.h"
+#include "NarrowphaseScratch.h"
+#include "Random.h"
+#include "SimulationChecks.h"
+#include "SplitTreeBenchmark.h"
+#include "WorkerPool.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+#include <stdlib.h>
+
+namespace
+{
+
+const unsigned int Default_Seed = 1;
+
+struct HeadlessOptions
+{
+   HeadlessOptions()
+      : numFrames(1000), DT(1.0 / 60), seed(0), numAsteroids(-1), numThreads(-1), fractureDepth(-1), lodInterval(-1), fireEvery(10), sweepPerFrame(0.01f), benchmarkBroadphaseFrames(0), benchmarkSplitTreeRepeats(0), check(false)
+   {
+   }
+
+   int numFrames;
+   double DT;
+   unsigned int seed;
+   int numAsteroids;
+   int numThreads;
+   int fractureDepth;
+   int lodInterval;
+   std::string modelFile;
+   int fireEvery;
+   float sweepPerFrame;
+   std::string broadphase;
+   std::string asteroidNarrowphase;
+   int benchmarkBroadphaseFrames;
+   int benchmarkSplitTreeRepeats;
+   bool check;
+};
+
+void PrintUsage()
+{
+   std::cout << "Usage: MPM_Headless [options]" << std::endl
+             << "  --frames N        number of frames to simulate (default 1000)" << std::endl
+             << "  --dt SECONDS      length of each simulation step (default 1/60)" << std::endl
+             << "  --seed N          world seed, 0 for the default (default World_Seed from options.config.xml," << std::endl
+             << "                    or 1 if that is 0)" << std::endl
+             << "  --asteroids N     number of asteroids (default from options.config.xml)" << std::endl
+             << "  --model FILE      asteroid model file in data/ (default from options.config.xml)" << std::endl
+             << "  --threads N       worker threads, 0 for one per hardware thread (default from options.config.xml)" << std::endl
+             << "  --fire-every N    fire a shot every N frames, 0 to never fire (default 10)" << std::endl
+             << "  --sweep RADIANS   player yaw per frame so that shots spread out (default 0.01)" << std::endl
+             << "  --broadphase NAME Grid, SAP or Locus (default from options.config.xml)" << std::endl
+             << "  --narrowphase NAME" << std::endl
+             << "                    Hull or Triangles for asteroid-asteroid collisions (default from options.config.xml)" << std::endl
+             << "  --fracture-depth N" << std::endl
+             << "                    times each model is cut up in advance (default from options.config.xml)" << std::endl
+             << "  --lod-interval N  most steps between updates of off-screen, distant asteroids, 1 to update" << std::endl
+             << "                    every asteroid every step (default from options.config.xml)" << std::endl
+             << "  --benchmark-broadphase N" << std::endl
+             << "                    instead of running the game, time each broadphase for N frames" << std::endl
+             << "                    with 200, 2000 and 20000 bodies" << std::endl
+             << "  --benchmark-split-trees N" << std::endl
+             << "                    instead of running the game, build the tree of every fragment in the" << std::endl
+             << "                    fracture library N times from its parent's tree and N times from scratch" << std::endl
+             << "  --check           instead of running the game, check collision and motion results against" << std::endl
+             << "                    known answers and exit with an error if any differ" << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, HeadlessOptions& options)
+{
+   for (int argIndex = 1; argIndex < argc; ++argIndex)
+   {
+      std::string arg = argv[argIndex];
+
+      if ((arg == "--help") || (arg == "-h"))
+      {
+         return false;
+      }
+
+      if (arg == "--check")
+      {
+         options.check = true;
+         continue;
+      }
+
+      if (argIndex + 1 >= argc)
+      {
+         throw std::invalid_argument("Missing value for " + arg);
+      }
+
+      std::string value = argv[++argIndex];
+
+      if (arg == "--frames")
+      {
+         options.numFrames = std::stoi(value);
+      }
+      else if (arg == "--dt")
+      {
+         options.DT = std::stod(value);
+      }
+      else if (arg == "--seed")
+      {
+         options.seed = static_cast<unsigned int>(std::stoul(value));
+      }
+      else if (arg == "--asteroids")
+      {
+         options.numAsteroids = std::stoi(value);
+      }
+      else if (arg == "--threads")
+      {
+         options.numThreads = std::stoi(value);
+      }
+      else if (arg == "--model")
+      {
+         options.modelFile = value;
+      }
+      else if (arg == "--fire-every")
+      {
+         options.fireEvery = std::stoi(value);
+      }
+      else if (arg == "--sweep")
+      {
+         options.sweepPerFrame = std::stof(value);
+      }
+      else if (arg == "--broadphase")
+      {
+         options.broadphase = value;
+      }
+      else if (arg == "--narrowphase")
+      {
+         options.asteroidNarrowphase = value;
+      }
+      else if (arg == "--fracture-depth")
+      {
+         options.fractureDepth = std::stoi(value);
+      }
+      else if (arg == "--lod-interval")
+      {
+         options.lodInterval = std::stoi(value);
+      }
+      else if (arg == "--benchmark-broadphase")
+      {
+         options.benchmarkBroadphaseFrames = std::stoi(value);
+      }
+      else if (arg == "--benchmark-split-trees")
+      {
+         options.benchmarkSplitTreeRepeats = std::stoi(value);
+      }
+      else
+      {
+         throw std::invalid_argument("Unknown option " + arg);
+      }
+   }
+
+   if ((options.numFrames <= 0) || (options.DT <= 0.0))
+   {
+      throw std::invalid_argument("--frames and --dt must be positive");
+   }
+
+   return true;
+}
+
+double ToMilliseconds(MPM::SimulationTimings::Clock::duration duration)
+{
+   return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void PrintReport(const HeadlessOptions& options, MPM::DemoSimulation& simulation, MPM::SimulationTimings::Clock::duration wallTime)
+{
+   const MPM::SimulationTimings& timings = simulation.GetTimings();
+
+   double numFrames = static_cast<double>(timings.numFrames);
+
+   std::cout << "frames: " << timings.numFrames << "  DT: " << options.DT << "  seed: " << options.seed
+             << "  asteroids: " << MPM::Config::GetNumAsteroids() << "  model: " << MPM::Config::GetModelFile()
+             << "  worker threads: " << MPM::Config::GetNumWorkerThreads() << "  broadphase: " << MPM::Config::GetBroadphase()
+             << "  narrowphase: " << MPM::Config::GetAsteroidNarrowphase() << "  fracture depth: " << MPM::Config::GetFractureDepth()
+             << "  LOD interval: " << MPM::Config::GetLODUpdateInterval() << std::endl << std::endl;
+
+   std::cout << std::left << std::setw(24) << "phase" << std::right << std::setw(14) << "total (ms)" << std::setw(18) << "per frame (ms)" << std::endl;
+
+   std::cout << std::fixed << std::setprecision(4);
+
+   MPM::SimulationTimings::Clock::duration simulationTime = MPM::SimulationTimings::Clock::duration::zero();
+
+   for (int phase = 0; phase < MPM::SimulationTimings::Num_Phases; ++phase)
+   {
+      MPM::SimulationTimings::Clock::duration phaseDuration = timings.phaseDurations[phase];
+      simulationTime += phaseDuration;
+
+      std::cout << std::left << std::setw(24) << MPM::SimulationTimings::PhaseName(static_cast<MPM::SimulationTimings::Phase>(phase))
+                << std::right << std::setw(14) << ToMilliseconds(phaseDuration)
+                << std::setw(18) << ToMilliseconds(phaseDuration) / numFrames << std::endl;
+   }
+
+   std::cout << std::left << std::setw(24) << "total" << std::right << std::setw(14) << ToMilliseconds(simulationTime)
+             << std::setw(18) << ToMilliseconds(simulationTime) / numFrames << std::endl << std::endl;
+
+   std::cout << std::setprecision(1);
+   std::cout << "frames/second: " << (numFrames * 1000.0 / ToMilliseconds(wallTime)) << std::endl;
+
+   std::cout << "asteroids remaining: " << simulation.GetAsteroids().size() << "  shots in flight: " << simulation.GetShots().Size()
+             << "  score: " << simulation.GetScore() << std::endl;
+
+   std::cout << "narrowphase queries: " << MPM::NarrowphaseScratch::GetNumQueries()
+             << "  scratch allocations: " << MPM::NarrowphaseScratch::GetNumAllocations()
+             << "  contact cache allocations: " << simulation.GetNumContactCacheAllocations() << std::endl;
+
+   std::cout << "splits from the fracture library: " << simulation.GetNumLibrarySplits()
+             << "  splits cut at runtime: " << simulation.GetNumRuntimeSplits() << std::endl;
+
+   std::cout << "asteroid updates: " << simulation.GetNumAsteroidSyncs()
+             << "  put off at reduced detail: " << simulation.GetNumDeferredAsteroidSyncs() << std::endl;
+}
+
+void RunSimulation(const HeadlessOptions& options)
+{
+   MPM::DemoSimulation simulation(options.seed);
+
+   simulation.InitializeAsteroids();
+
+   MPM::Player& player = simulation.GetPlayer();
+
+   MPM::NarrowphaseScratch::ResetCounters();
+
+   MPM::SimulationTimings::Clock::time_point start = MPM::SimulationTimings::Clock::now();
+
+   for (int frame = 0; frame < options.numFrames; ++frame)
+   {
+      player.Rotate(Locus::FVector3(0.0f, options.sweepPerFrame, 0.0f));
+
+      if ((options.fireEvery > 0) && ((frame % options.fireEvery) == 0))
+      {
+         simulation.FireShot(0);
+      }
+
+      simulation.Update(options.DT);
+   }
+
+   PrintReport(options, simulation, MPM::SimulationTimings::Clock::now() - start);
+}
+
+void BenchmarkBroadphases(const HeadlessOptions& options)
+{
+   static const std::size_t Num_Bodies[] = {200, 2000, 20000};
+   static const char* Broadphase_Names[] = {"Locus", "Grid", "SAP"};
+
+   MPM::WorkerPool workerPool(MPM::Config::GetNumWorkerThreads());
+
+   std::cout << "frames: " << options.benchmarkBroadphaseFrames << "  DT: " << options.DT << "  seed: " << options.seed
+             << "  worker threads: " << workerPool.NumThreads() << std::endl << std::endl;
+
+   std::cout << std::left << std::setw(12) << "broadphase" << std::right << std::setw(10) << "bodies" << std::setw(10) << "arena"
+             << std::setw(18) << "update (ms/frame)" << std::setw(18) << "pairs (ms/frame)" << std::setw(10) << "pairs" << std::setw(12) << "reinserted" << std::endl;
+
+   std::cout << std::fixed;
+
+   for (std::size_t numBodies : Num_Bodies)
+   {
+      for (const char* broadphaseName : Broadphase_Names)
+      {
+         MPM::BroadphaseBenchmarkResult result = MPM::RunBroadphaseBenchmark(broadphaseName, numBodies, options.benchmarkBroadphaseFrames, options.DT, options.seed, workerPool);
+
+         std::cout << std::left << std::setw(12) << result.broadphaseName << std::right << std::setw(10) << result.numBodies
+                   << std::setw(10) << std::setprecision(0) << result.arenaHalfExtent
+                   << std::setw(18) << std::setprecision(4) << result.updateMillisecondsPerFrame
+                   << std::setw(18) << result.pairsMillisecondsPerFrame;
+
+         if (result.broadphaseName != "Locus")
+         {
+            std::cout << std::setw(10) << result.numPairs;
+         }
+
+         if (result.broadphaseName == "SAP")
+         {
+            std::cout << std::setw(12) << result.numReinsertions;
+         }
+
+         std::cout << std::endl;
+      }
+   }
+}
+
+void BenchmarkSplitTrees(const HeadlessOptions& options)
+{
+   MPM::WorkerPool workerPool(MPM::Config::GetNumWorkerThreads());
+
+   std::shared_ptr<const MPM::FractureLibrary> library = MPM::FractureLibrary::Load(MPM::Config::GetModelFile(), MPM::Config::GetFractureDepth(), workerPool);
+
+   std::cout << "model: " << MPM::Config::GetModelFile() << "  fracture depth: " << MPM::Config::GetFractureDepth()
+             << "  fragments: " << library->NumFragments() << "  repeats: " << options.benchmarkSplitTreeRepeats
+             << "  split trees above: " << MPM::Asteroid::Min_Faces_For_Split_Tree << " faces" << std::endl << std::endl;
+
+   std::cout << std::left << std::setw(12) << "faces" << std::right << std::setw(10) << "halves"
+             << std::setw(18) << "from parent (us)" << std::setw(18) << "from scratch (us)" << std::endl;
+
+   std::cout << std::fixed << std::setprecision(2);
+
+   for (const MPM::SplitTreeBenchmarkRow& row : MPM::RunSplitTreeBenchmark(*library, options.benchmarkSplitTreeRepeats))
+   {
+      std::string faces = std::to_string(row.minFaces) + ((row.maxFaces > 0) ? "-" + std::to_string(row.maxFaces - 1) : "+");
+
+      std::cout << std::left << std::setw(12) << faces << std::right << std::setw(10) << row.numHalves
+                << std::setw(18) << row.splitBuildMicroseconds << std::setw(18) << row.rebuildMicroseconds << std::endl;
+   }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+   try
+   {
+      HeadlessOptions options;
+
+      if (!ParseOptions(argc, argv, options))
+      {
+         PrintUsage();
+         return EXIT_SUCCESS;
+      }
+
+      if (options.check)
+      {
+         return MPM::RunSimulationChecks(std::cout) ? EXIT_SUCCESS : EXIT_FAILURE;
+      }
+
+      Locus::FileSystem fileSystem(argv[0]);
+
+#ifdef MPM_USE_ARCHIVE
+      Locus::MountDirectoryOrArchive(Locus::GetExePath() + "resources.zip");
+#else
+      Locus::MountDirectoryOrArchive(Locus::GetExePath() + "resources/");
+#endif
+
+      MPM::Config::Set();
+
+      //unlike the game, runs are reproducible unless asked otherwise
+      if (options.seed != 0)
+      {
+         MPM::Config::SetWorldSeed(options.seed);
+      }
+      else if (MPM::Config::GetWorldSeed() == 0)
+      {
+         MPM::Config::SetWorldSeed(Default_Seed);
+      }
+
+      options.seed = MPM::Config::GetWorldSeed();
+
+      if (options.numAsteroids > 0)
+      {
+         MPM::Config::SetNumAsteroids(options.numAsteroids);
+      }
+
+      if (options.numThreads >= 0)
+      {
+         MPM::Config::SetNumWorkerThreads(static_cast<unsigned int>(options.numThreads));
+      }
+
+      if (!options.modelFile.empty())
+      {
+         MPM::Config::SetModelFile(options.modelFile);
+      }
+
+      if (!options.broadphase.empty())
+      {
+         MPM::Config::SetBroadphase(options.broadphase);
+      }
+
+      if (!options.asteroidNarrowphase.empty())
+      {
+         MPM::Config::SetAsteroidNarrowphase(options.asteroidNarrowphase);
+      }
+
+      if (options.fractureDepth >= 0)
+      {
+         MPM::Config::SetFractureDepth(static_cast<unsigned int>(options.fractureDepth));
+      }
+
+      if (options.lodInterval > 0)
+      {
+         MPM::Config::SetLODUpdateInterval(static_cast<unsigned int>(options.lodInterval));
+      }
+
+      if (options.benchmarkBroadphaseFrames > 0)
+      {
+         BenchmarkBroadphases(options);
+      }
+      else if (options.benchmarkSplitTreeRepeats > 0)
+      {
+         BenchmarkSplitTrees(options);
+      }
+      else
+      {
+         RunSimulation(options);
+      }
+   }
+   catch (Locus::Exception& locusException)
+   {
+      std::cout << "Fatal Error: " << locusException.Message() << std::endl;
+      return EXIT_FAILURE;
+   }
+   catch (std::exception& stdException)
+   {
+      std::cout << "Fatal Error: " << stdException.what() << std::endl;
+      PrintUsage();
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "ModelFrame.h"
+
+#include "Locus/Geometry/Vector3Geometry.h"
+
+#include <algorithm>
+
+namespace MPM
+{
+
+ModelFrame::ModelFrame()
+   : xColumn(Locus::Vec3D::XAxis()), yColumn(Locus::Vec3D::YAxis()), zColumn(Locus::Vec3D::ZAxis())
+{
+   UpdateInverse();
+}
+
+ModelFrame::ModelFrame(const Locus::Transformation& transformation)
+{
+   origin = transformation.MultVertex(Locus::Vec3D::ZeroVector());
+
+   xColumn = transformation.MultVertex(Locus::Vec3D::XAxis()) - origin;
+   yColumn = transformation.MultVertex(Locus::Vec3D::YAxis()) - origin;
+   zColumn = transformation.MultVertex(Locus::Vec3D::ZAxis()) - origin;
+
+   UpdateInverse();
+}
+
+ModelFrame ModelFrame::Relative(const ModelFrame& from, const ModelFrame& to)
+{
+   ModelFrame relative;
+
+   relative.origin = to.ToModel(from.origin);
+
+   relative.xColumn = to.VectorToModel(from.xColumn);
+   relative.yColumn = to.VectorToModel(from.yColumn);
+   relative.zColumn = to.VectorToModel(from.zColumn);
+
+   relative.UpdateInverse();
+
+   return relative;
+}
+
+void ModelFrame::UpdateInverse()
+{
+   xRow = Cross(yColumn, zColumn);
+   yRow = Cross(zColumn, xColumn);
+   zRow = Cross(xColumn, yColumn);
+
+   float inverseDeterminant = 1.0f / Dot(xColumn, xRow);
+
+   xRow = xRow * inverseDeterminant;
+   yRow = yRow * inverseDeterminant;
+   zRow = zRow * inverseDeterminant;
+
+   largestScale = std::max({ Norm(xColumn), Norm(yColumn), Norm(zColumn) });
+}
+
+Locus::FVector3 ModelFrame::ToWorld(const Locus::FVector3& point) const
+{
+   return origin + VectorToWorld(point);
+}
+
+Locus::FVector3 ModelFrame::ToModel(const Locus::FVector3& point) const
+{
+   return VectorToModel(point - origin);
+}
+
+Locus::FVector3 ModelFrame::VectorToWorld(const Locus::FVector3& vector) const
+{
+   return xColumn * vector.x + yColumn * vector.y + zColumn * vector.z;
+}
+
+Locus::FVector3 ModelFrame::VectorToModel(const Locus::FVector3& vector) const
+{
+   return Locus::FVector3(Dot(xRow, vector), Dot(yRow, vector), Dot(zRow, vector));
+}
+
+Locus::FVector3 ModelFrame::SupportDirectionToModel(const Locus::FVector3& direction) const
+{
+   return Locus::FVector3(Dot(xColumn, direction), Dot(yColumn, direction), Dot(zColumn, direction));
+}
+
+const Locus::FVector3& ModelFrame::GetOrigin() const
+{
+   return origin;
+}
+
+float ModelFrame::GetLargestScale() const
+{
+   return largestScale;
+}
+
+}
\ No newline at end of file
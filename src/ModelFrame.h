@@ -0,0 +1,66 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include "Locus/Geometry/Transformation.h"
+
+namespace MPM
+{
+
+//A model transformation (translation, rotation and scale) kept as its translation and
+//the columns of its 3x3 part, along with the inverse. Collision queries move their
+//primitives into a model's space with it once per query rather than moving every
+//candidate triangle out of it, and bodies compute theirs once per step for all of
+//their pairs
+class ModelFrame
+{
+public:
+   ModelFrame();
+   explicit ModelFrame(const Locus::Transformation& transformation);
+
+   //the frame that takes points from from's model space into to's model space
+   static ModelFrame Relative(const ModelFrame& from, const ModelFrame& to);
+
+   Locus::FVector3 ToWorld(const Locus::FVector3& point) const;
+   Locus::FVector3 ToModel(const Locus::FVector3& point) const;
+
+   Locus::FVector3 VectorToWorld(const Locus::FVector3& vector) const;
+   Locus::FVector3 VectorToModel(const Locus::FVector3& vector) const;
+
+   //the model-space direction whose farthest point is the farthest point along the
+   //world-space direction. This is the transpose, not the inverse, of the 3x3 part
+   Locus::FVector3 SupportDirectionToModel(const Locus::FVector3& direction) const;
+
+   const Locus::FVector3& GetOrigin() const;
+
+   //the most the frame stretches any length
+   float GetLargestScale() const;
+
+private:
+   Locus::FVector3 origin;
+
+   Locus::FVector3 xColumn;
+   Locus::FVector3 yColumn;
+   Locus::FVector3 zColumn;
+
+   //the rows of the inverse of the 3x3 part
+   Locus::FVector3 xRow;
+   Locus::FVector3 yRow;
+   Locus::FVector3 zRow;
+
+   float largestScale;
+
+   void UpdateInverse();
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "NarrowphaseScratch.h"
+
+#include <memory>
+#include <mutex>
+
+//thread_local isn't available with Visual Studio 2013, and neither compiler's thread
+//local storage runs constructors, so each thread keeps a plain pointer to its scratch
+#ifdef _MSC_VER
+#define MPM_THREAD_LOCAL __declspec(thread)
+#else
+#define MPM_THREAD_LOCAL __thread
+#endif
+
+namespace MPM
+{
+
+static MPM_THREAD_LOCAL NarrowphaseScratch* threadScratch = nullptr;
+
+//every scratch made so far. They are kept until the program exits, so that the counts of
+//threads that have finished still add up
+static std::mutex scratchesMutex;
+static std::vector<std::unique_ptr<NarrowphaseScratch>> scratches;
+
+NarrowphaseScratch::NarrowphaseScratch()
+   : numAllocations(0), numQueries(0)
+{
+}
+
+NarrowphaseScratch& NarrowphaseScratch::ForThisThread()
+{
+   if (threadScratch == nullptr)
+   {
+      std::lock_guard<std::mutex> lock(scratchesMutex);
+
+      scratches.push_back(std::unique_ptr<NarrowphaseScratch>(new NarrowphaseScratch()));
+      threadScratch = scratches.back().get();
+   }
+
+   return *threadScratch;
+}
+
+void NarrowphaseScratch::CountQuery()
+{
+   ++numQueries;
+}
+
+std::size_t NarrowphaseScratch::GetNumAllocations()
+{
+   std::lock_guard<std::mutex> lock(scratchesMutex);
+
+   std::size_t total = 0;
+
+   for (const std::unique_ptr<NarrowphaseScratch>& scratch : scratches)
+   {
+      total += scratch->numAllocations;
+   }
+
+   return total;
+}
+
+std::size_t NarrowphaseScratch::GetNumQueries()
+{
+   std::lock_guard<std::mutex> lock(scratchesMutex);
+
+   std::size_t total = 0;
+
+   for (const std::unique_ptr<NarrowphaseScratch>& scratch : scratches)
+   {
+      total += scratch->numQueries;
+   }
+
+   return total;
+}
+
+void NarrowphaseScratch::ResetCounters()
+{
+   std::lock_guard<std::mutex> lock(scratchesMutex);
+
+   for (const std::unique_ptr<NarrowphaseScratch>& scratch : scratches)
+   {
+      scratch->numAllocations = 0;
+      scratch->numQueries = 0;
+   }
+}
+
+}
\ No newline at end of file
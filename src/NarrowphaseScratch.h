@@ -0,0 +1,98 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MPM
+{
+
+//Working memory for narrowphase queries. Every thread has its own, and queries clear
+//and refill its buffers rather than making new ones, so once the buffers have grown
+//large enough for the meshes in play a query doesn't allocate. Every time a buffer
+//has to grow is counted, which shows how many allocations the narrowphase made. The
+//counts are kept per thread, so that counting doesn't make the threads wait on each other
+class NarrowphaseScratch
+{
+public:
+   typedef std::pair<std::uint32_t, std::uint32_t> IndexPair;
+
+   struct PolytopeFace
+   {
+      std::uint32_t vertices[3];
+      Locus::FVector3 normal;
+      float distance;
+   };
+
+   NarrowphaseScratch();
+
+   NarrowphaseScratch(const NarrowphaseScratch&) = delete;
+   NarrowphaseScratch& operator=(const NarrowphaseScratch&) = delete;
+
+   static NarrowphaseScratch& ForThisThread();
+
+   //adds value to buffer, counting the allocation if buffer has to grow for it
+   template <class T>
+   void Push(std::vector<T>& buffer, const T& value)
+   {
+      if (buffer.size() == buffer.capacity())
+      {
+         ++numAllocations;
+      }
+
+      buffer.push_back(value);
+   }
+
+   //resizes buffer, counting the allocation if buffer has to grow for it
+   template <class T>
+   void Resize(std::vector<T>& buffer, std::size_t size)
+   {
+      if (size > buffer.capacity())
+      {
+         ++numAllocations;
+      }
+
+      buffer.resize(size);
+   }
+
+   void CountQuery();
+
+   //the counts summed over every thread's scratch. Only call these while no queries are
+   //running (e.g. between simulation steps)
+   static std::size_t GetNumAllocations();
+   static std::size_t GetNumQueries();
+   static void ResetCounters();
+
+   std::vector<std::uint32_t> nodeStack;
+   std::vector<IndexPair> nodePairStack;
+
+   //the triangles of a leaf that pass a query's bounding box test
+   std::vector<std::uint32_t> triangleCandidates;
+
+   //the polytope EPA expands: its vertices on the Minkowski difference, the point on
+   //the first shape each of them came from, its faces and the horizon being replaced
+   std::vector<Locus::FVector3> polytopeVertices;
+   std::vector<Locus::FVector3> polytopeSources;
+   std::vector<PolytopeFace> polytopeFaces;
+   std::vector<IndexPair> polytopeEdges;
+
+private:
+   std::size_t numAllocations;
+   std::size_t numQueries;
+};
+
+}
\ No newline at end of file
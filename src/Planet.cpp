@@ -10,6 +10,7 @@
 
 #include "Planet.h"
 #include "TextureManager.h"
+#include "Random.h"
 
 #include "Locus/Rendering/Mesh.h"
 #include "Locus/Rendering/RenderingState.h"
@@ -17,8 +18,6 @@
 #include "Locus/Rendering/ShaderVariables.h"
 #include "Locus/Rendering/Texture.h"
 
-#include "Locus/Common/Random.h"
-
 #include <cassert>
 
 namespace MPM
@@ -40,9 +39,9 @@ unsigned int Planet::GetTextureIndex() const
    return textureIndex;
 }
 
-void Planet::RandomizeTexture(const MPM::TextureManager& textureManager)
+void Planet::RandomizeTexture(const MPM::TextureManager& textureManager, MPM::Random& random)
 {
-   textureIndex = static_cast<unsigned int>( Locus::Random().RandomInt(0, static_cast<int>(textureManager.NumPlanetTextures()) - 1) );
+   textureIndex = static_cast<unsigned int>( random.RandomInt(0, static_cast<int>(textureManager.NumPlanetTextures()) - 1) );
 }
 
 void Planet::Draw(Locus::RenderingState& renderingState) const
@@ -27,6 +27,7 @@ namespace MPM
 {
 
 class TextureManager;
+class Random;
 
 class Planet : public Locus::Moveable
 {
@@ -36,7 +37,7 @@ public:
    float GetRadius() const;
    unsigned int GetTextureIndex() const;
 
-   void RandomizeTexture(const MPM::TextureManager& textureManager);
+   void RandomizeTexture(const MPM::TextureManager& textureManager, MPM::Random& random);
 
    void Draw(Locus::RenderingState& renderingState) const;
 
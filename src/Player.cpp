@@ -10,7 +10,10 @@
 
 #include "Player.h"
 #include "Asteroid.h"
+#include "ContactCache.h"
+#include "NarrowphaseScratch.h"
 #include "CollidableTypes.h"
+#include "CollisionDispatch.h"
 #include "Config.h"
 
 #include "Locus/Geometry/Geometry.h"
@@ -29,7 +32,7 @@ namespace MPM
 
 Player::Player()
    : translateAhead(false), translateBack(false), translateRight(false),
-     translateLeft(false), translateUp(false), translateDown(false)
+     translateLeft(false), translateUp(false), translateDown(false), collisionSoundQueued(false)
 {
    collidableType = CollidableType_Player;
 }
@@ -38,17 +41,28 @@ void Player::SetModel(float radius)
 {
    model = Locus::ModelUtility::MakeCube(2 * radius);
 
-   boundingVolumeHierarchy = std::make_unique<Locus::SphereTree_t>(model, 6);
+   boundingVolumeHierarchy = std::make_unique<TriangleTree>(model, 6);
 
    model.UpdateMaxDistanceToCenter();
 
    model.Reset(viewpoint.GetPosition(), viewpoint.GetRotation(), Locus::Transformation::IdentityScale());
+
+   UpdateModelFrame();
+
+   previousPosition = viewpoint.GetPosition();
+}
+
+Locus::FVector3 Player::GetInterpolatedPosition(float alpha) const
+{
+   return previousPosition + alpha * (viewpoint.GetPosition() - previousPosition);
 }
 
 void Player::Rotate(const Locus::FVector3& rotation)
 {
    viewpoint.RotateBy(rotation);
    model.Rotate(rotation);
+
+   UpdateModelFrame();
 }
 
 void Player::LoadCollisionSoundEffect(const std::string& pathToSoundEffect)
@@ -60,61 +74,70 @@ void Player::LoadCollisionSoundEffect(const std::string& pathToSoundEffect)
 
 void Player::UpdateBroadCollisionExtent()
 {
-   Collidable::UpdateBroadCollisionExtent(viewpoint.GetPosition(), model.GetMaxDistanceToCenter());
+   CollisionBody::UpdateBroadCollisionExtent(viewpoint.GetPosition(), model.GetMaxDistanceToCenter());
+
+   UpdateModelFrame();
+}
+
+void Player::UpdateModelFrame()
+{
+   modelFrame = ModelFrame(model.CurrentModelTransformation());
 }
 
 bool Player::CollidesWith(Collidable& collidable) const
 {
-   return (collidable.GetCollidableType() == CollidableType_Asteroid);
+   return CollisionDispatch::ShouldCollide(collidableType, collidable.GetCollidableType());
 }
 
 void Player::ResolveCollision(Collidable& collidable)
 {
-   ResolveCollision( dynamic_cast<Asteroid&>(collidable) );
+   CollisionDispatch::Resolve(*this, static_cast<CollisionBody&>(collidable));
 }
 
 void Player::ResolveCollision(Asteroid& asteroid)
 {
-   std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+   ContactCache* contactCache = asteroid.GetContactCache();
 
-   if (asteroid.lastCollision == this)
+   if ((contactCache != nullptr) && contactCache->IsDebounced(this, &asteroid))
    {
-      std::chrono::high_resolution_clock::duration diff = now - asteroid.lastCollisionTime;
-      if (std::chrono::duration_cast<std::chrono::milliseconds>(diff).count() < 500)
-      {
-         return;
-      }
+      return;
    }
 
-   std::unordered_set<std::size_t> thisIntersectionSet;
-   std::unordered_set<std::size_t> asteroidIntersectionSet;
+   asteroid.CatchUpWithKinematics();
 
-   boundingVolumeHierarchy->GetIntersection(model, asteroid.GetBoundingVolumeHierarchy(), asteroid, thisIntersectionSet, asteroidIntersectionSet);
+   Locus::Triangle3D_t thisIntersectingTriangle;
+   Locus::Triangle3D_t asteroidTriangle;
 
-   if ((thisIntersectionSet.size() > 0) && (asteroidIntersectionSet.size() > 0))
+   if (boundingVolumeHierarchy->GetIntersection(modelFrame, asteroid.GetBoundingVolumeHierarchy(), asteroid.GetModelFrame(),
+                                                NarrowphaseScratch::ForThisThread(), thisIntersectingTriangle, asteroidTriangle))
    {
-      Locus::Triangle3D_t thisIntersectingTriangle;
-      Locus::Triangle3D_t asteroidTriangle;
+      Locus::FVector3 collisionPoint = (viewpoint.GetPosition() + asteroid.centroid) / 2.0f;
+      Locus::FVector3 impulseDirection = NormVector(asteroid.centroid - viewpoint.GetPosition());
 
-      if (model.GetResolvedCollision(asteroid, model.CurrentModelTransformation(), asteroid.CurrentModelTransformation(), thisIntersectionSet, asteroidIntersectionSet, thisIntersectingTriangle, asteroidTriangle))
-      {
-         Locus::FVector3 collisionPoint = (viewpoint.GetPosition() + asteroid.centroid) / 2.0f;
-         Locus::FVector3 impulseDirection = NormVector(asteroid.centroid - viewpoint.GetPosition());
-
-         Locus::ResolveCollision(1.0f, model.BoundingSphere(), asteroid.BoundingSphere(), collisionPoint, impulseDirection,
-                                 motionProperties, asteroid.motionProperties);
+      Locus::ResolveCollision(1.0f, model.BoundingSphere(), asteroid.BoundingSphere(), collisionPoint, impulseDirection,
+                              motionProperties, asteroid.motionProperties);
 
-         asteroid.lastCollision = this;
-         asteroid.lastCollisionTime = std::chrono::high_resolution_clock::now();
+      asteroid.CommitMotionProperties();
 
-         if (collisionSoundEffect != nullptr)
-         {
-            collisionSoundEffect->Play();
-         }
+      if (contactCache != nullptr)
+      {
+         contactCache->MarkResolved(this, &asteroid);
       }
+
+      collisionSoundQueued = true;
    }
 }
 
+void Player::PlayQueuedCollisionSound()
+{
+   if (collisionSoundQueued && (collisionSoundEffect != nullptr))
+   {
+      collisionSoundEffect->Play();
+   }
+
+   collisionSoundQueued = false;
+}
+
 void Player::tick(double DT)
 {
    //translate the player based on the user's control key input
@@ -133,6 +156,8 @@ void Player::tick(double DT)
    Locus::FVector3 originalPosition = viewpoint.GetPosition();
    Locus::FVector3 newPosition;
 
+   previousPosition = originalPosition;
+
    if (!ApproximatelyEqual(translation, Locus::Vec3D::ZeroVector()))
    {
       translation *= static_cast<float>(DT);
@@ -10,15 +10,17 @@
 
 #pragma once
 
-#include "Locus/Geometry/Collidable.h"
 #include "Locus/Geometry/Model.h"
 #include "Locus/Geometry/MotionProperties.h"
-#include "Locus/Geometry/BoundingVolumeHierarchy.h"
 
 #include "Locus/Rendering/Viewpoint.h"
 
 #include "Locus/Audio/SoundEffect.h"
 
+#include "CollisionBody.h"
+#include "ModelFrame.h"
+#include "TriangleTree.h"
+
 #include <memory>
 #include <string>
 
@@ -27,13 +29,16 @@ namespace MPM
 
 class Asteroid;
 
-class Player : public Locus::Collidable
+class Player : public CollisionBody
 {
 public:
    Player();
 
    void tick(double DT);
 
+   //the position drawn alpha of the way between the previous tick and the current one
+   Locus::FVector3 GetInterpolatedPosition(float alpha) const;
+
    bool translateAhead;
    bool translateBack;
    bool translateRight;
@@ -53,16 +58,29 @@ public:
 
    void LoadCollisionSoundEffect(const std::string& pathToSoundEffect);
 
+   //collisions are resolved on the worker threads, so the sound of one is only queued
+   //there. This plays it, and is called on the main thread once they are all resolved
+   void PlayQueuedCollisionSound();
+
    Locus::Viewpoint viewpoint;
 
 private:
    Locus::Model_t model;
 
-   std::unique_ptr< Locus::SphereTree_t > boundingVolumeHierarchy;
+   std::unique_ptr< TriangleTree > boundingVolumeHierarchy;
+
+   //the model transformation as of the last time the player moved or turned, shared by
+   //the collision queries of every pair the player is in
+   ModelFrame modelFrame;
 
    Locus::MotionProperties motionProperties;
 
+   Locus::FVector3 previousPosition;
+
    std::unique_ptr< Locus::SoundEffect > collisionSoundEffect;
+   bool collisionSoundQueued;
+
+   void UpdateModelFrame();
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,109 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "PoissonDiskSampler.h"
+#include "Random.h"
+
+#include <algorithm>
+
+namespace MPM
+{
+
+//the grid is at most this many cells along each axis, however small minDistance is
+static const std::size_t Max_Cells_Per_Axis = 64;
+
+static const std::size_t No_Point = static_cast<std::size_t>(-1);
+
+PoissonDiskSampler::PoissonDiskSampler(float halfExtent, float minDistance, float minDistanceFromOrigin)
+   : halfExtent(halfExtent), minDistance(minDistance), minDistanceFromOrigin(minDistanceFromOrigin)
+{
+   float extent = 2 * halfExtent;
+
+   cellSize = std::max(minDistance, extent / Max_Cells_Per_Axis);
+   cellsPerAxis = (cellSize > 0.0f) ? std::min(static_cast<std::size_t>(extent / cellSize) + 1, Max_Cells_Per_Axis) : 1;
+
+   cellLastPoints.assign(cellsPerAxis * cellsPerAxis * cellsPerAxis, No_Point);
+}
+
+Locus::FVector3 PoissonDiskSampler::Place(Random& random)
+{
+   Locus::FVector3 candidate;
+
+   do
+   {
+      candidate.x = static_cast<float>(random.RandomDouble(-halfExtent, halfExtent));
+      candidate.y = static_cast<float>(random.RandomDouble(-halfExtent, halfExtent));
+      candidate.z = static_cast<float>(random.RandomDouble(-halfExtent, halfExtent));
+
+   } while ((SquaredNorm(candidate) < minDistanceFromOrigin * minDistanceFromOrigin) || !Fits(candidate));
+
+   std::size_t cell = (CellCoordinate(candidate.z) * cellsPerAxis + CellCoordinate(candidate.y)) * cellsPerAxis + CellCoordinate(candidate.x);
+
+   previousPointsInCell.push_back(cellLastPoints[cell]);
+   cellLastPoints[cell] = points.size();
+
+   points.push_back(candidate);
+
+   return candidate;
+}
+
+std::size_t PoissonDiskSampler::NumPoints() const
+{
+   return points.size();
+}
+
+std::size_t PoissonDiskSampler::CellCoordinate(float coordinate) const
+{
+   if (cellSize <= 0.0f)
+   {
+      return 0;
+   }
+
+   float cellCoordinate = (coordinate + halfExtent) / cellSize;
+
+   return std::min(static_cast<std::size_t>(std::max(cellCoordinate, 0.0f)), cellsPerAxis - 1);
+}
+
+bool PoissonDiskSampler::Fits(const Locus::FVector3& candidate) const
+{
+   //cells are at least minDistance wide, so only the neighbouring cells can hold a point that close
+   std::size_t x = CellCoordinate(candidate.x);
+   std::size_t y = CellCoordinate(candidate.y);
+   std::size_t z = CellCoordinate(candidate.z);
+
+   std::size_t lastX = std::min(x + 1, cellsPerAxis - 1);
+   std::size_t lastY = std::min(y + 1, cellsPerAxis - 1);
+   std::size_t lastZ = std::min(z + 1, cellsPerAxis - 1);
+
+   float squaredMinDistance = minDistance * minDistance;
+
+   for (std::size_t cellZ = (z > 0) ? z - 1 : 0; cellZ <= lastZ; ++cellZ)
+   {
+      for (std::size_t cellY = (y > 0) ? y - 1 : 0; cellY <= lastY; ++cellY)
+      {
+         for (std::size_t cellX = (x > 0) ? x - 1 : 0; cellX <= lastX; ++cellX)
+         {
+            std::size_t cell = (cellZ * cellsPerAxis + cellY) * cellsPerAxis + cellX;
+
+            for (std::size_t pointIndex = cellLastPoints[cell]; pointIndex != No_Point; pointIndex = previousPointsInCell[pointIndex])
+            {
+               if (SquaredNorm(points[pointIndex] - candidate) <= squaredMinDistance)
+               {
+                  return false;
+               }
+            }
+         }
+      }
+   }
+
+   return true;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include <vector>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+class Random;
+
+//Places points at random in the cube [-halfExtent, halfExtent]^3, no two of them within
+//minDistance of each other, by throwing darts. The points placed so far are binned into a
+//grid with cells at least minDistance wide, so a candidate is only checked against the
+//points in the 27 cells around it and each try takes the same time however many there are
+class PoissonDiskSampler
+{
+public:
+   //points are also kept at least minDistanceFromOrigin from the origin
+   PoissonDiskSampler(float halfExtent, float minDistance, float minDistanceFromOrigin);
+
+   //draws candidates from random until one fits, then places it. The coordinates are drawn
+   //x, y then z, and a candidate fits unless it is within minDistance of a placed point
+   Locus::FVector3 Place(Random& random);
+
+   std::size_t NumPoints() const;
+
+private:
+   float halfExtent;
+   float minDistance;
+   float minDistanceFromOrigin;
+
+   float cellSize;
+   std::size_t cellsPerAxis;
+
+   std::vector<Locus::FVector3> points;
+
+   //the last point placed in each cell, and for each point the one placed before it in its cell
+   std::vector<std::size_t> cellLastPoints;
+   std::vector<std::size_t> previousPointsInCell;
+
+   std::size_t CellCoordinate(float coordinate) const;
+   bool Fits(const Locus::FVector3& candidate) const;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "Random.h"
+
+#include <random>
+
+namespace MPM
+{
+
+//splitmix64, used to spread a seed over xoshiro's state. Its output for consecutive
+//inputs is well mixed, which xoshiro needs from its initial state
+static std::uint64_t SplitMix(std::uint64_t& x)
+{
+   x += 0x9E3779B97F4A7C15ULL;
+
+   std::uint64_t z = x;
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+   return z ^ (z >> 31);
+}
+
+static std::uint64_t RotateLeft(std::uint64_t x, int k)
+{
+   return (x << k) | (x >> (64 - k));
+}
+
+Random::Random()
+{
+   Seed(MakeSeed());
+}
+
+Random::Random(unsigned int seed, unsigned int stream, unsigned int substream)
+{
+   Seed(seed, stream, substream);
+}
+
+unsigned int Random::MakeSeed()
+{
+   return std::random_device()();
+}
+
+void Random::Seed(unsigned int seed, unsigned int stream, unsigned int substream)
+{
+   //hash the seed, stream and substream together one after the other, so that nearby
+   //streams of nearby seeds still start far apart
+   std::uint64_t key = seed;
+   key = SplitMix(key) ^ stream;
+   key = SplitMix(key) ^ substream;
+
+   for (std::uint64_t& word : state)
+   {
+      word = SplitMix(key);
+   }
+}
+
+std::uint64_t Random::Next()
+{
+   std::uint64_t result = RotateLeft(state[1] * 5, 7) * 9;
+
+   std::uint64_t t = state[1] << 17;
+
+   state[2] ^= state[0];
+   state[3] ^= state[1];
+   state[1] ^= state[2];
+   state[0] ^= state[3];
+
+   state[2] ^= t;
+
+   state[3] = RotateLeft(state[3], 45);
+
+   return result;
+}
+
+double Random::NextUnit()
+{
+   //the top 53 bits fill a double's mantissa exactly, giving [0, 1)
+   return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int Random::RandomInt(int min, int max)
+{
+   std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(max) - min) + 1;
+
+   //reject the top few values that would make the lower part of the range more likely
+   std::uint64_t limit = UINT64_MAX - (UINT64_MAX % range);
+
+   std::uint64_t value = Next();
+   while (value >= limit)
+   {
+      value = Next();
+   }
+
+   return static_cast<int>(min + static_cast<std::int64_t>(value % range));
+}
+
+double Random::RandomDouble(double min, double max)
+{
+   return min + NextUnit() * (max - min);
+}
+
+bool Random::FlipCoin(double probability)
+{
+   return NextUnit() < probability;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace MPM
+{
+
+//the independent streams drawn from one world seed. Each subsystem draws from its own
+//stream so that drawing more or fewer numbers in one never changes what another sees
+enum RandomStream
+{
+   RandomStream_Default = 0,
+   RandomStream_Asteroids,
+   RandomStream_Splits,
+   RandomStream_Stars,
+   RandomStream_Planets,
+   RandomStream_PlanetTextures,
+   RandomStream_Broadphase_Benchmark
+};
+
+//Seedable counterpart to Locus::Random. Game state that has to be reproducible
+//(e.g. for benchmarking) draws from one of these rather than from Locus::Random.
+//The generator is xoshiro256**, whose state is derived by hashing (seed, stream, substream),
+//so any number of streams can be made from one seed without drawing from each other.
+//Work split across threads draws from one substream per chunk (not per thread) so that
+//the results don't depend on the number of threads. The numbers are produced without
+//<random>'s distributions, so a given seed gives the same world with any standard library
+class Random
+{
+public:
+   Random();
+   Random(unsigned int seed, unsigned int stream = RandomStream_Default, unsigned int substream = 0);
+
+   static unsigned int MakeSeed();
+
+   void Seed(unsigned int seed, unsigned int stream = RandomStream_Default, unsigned int substream = 0);
+
+   int RandomInt(int min, int max);
+   double RandomDouble(double min, double max);
+   bool FlipCoin(double probability);
+
+private:
+   std::uint64_t state[4];
+
+   std::uint64_t Next();
+   double NextUnit();
+};
+
+}
\ No newline at end of file
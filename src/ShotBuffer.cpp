@@ -0,0 +1,393 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "ShotBuffer.h"
+#include "Asteroid.h"
+#include "AsteroidKinematics.h"
+#include "NarrowphaseScratch.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <cmath>
+
+namespace MPM
+{
+
+static const std::size_t Shot_Chunk_Size = 256;
+
+//the grid is at most this many cells along each axis, however small the asteroids are
+static const std::size_t Max_Cells_Per_Axis = 32;
+
+static const std::size_t No_Hit = std::numeric_limits<std::size_t>::max();
+
+template <class T>
+static void SwapAndPop(std::vector<T>& values, std::size_t index)
+{
+   values[index] = values.back();
+   values.pop_back();
+}
+
+ShotBuffer::ShotBuffer()
+   : cellSize(0.0f), cellsPerAxis(0)
+{
+   gridOrigin[0] = gridOrigin[1] = gridOrigin[2] = 0.0f;
+}
+
+void ShotBuffer::Add(const Locus::FVector3& position, const Locus::FVector3& direction, unsigned int colorIndex)
+{
+   positionX.push_back(position.x);
+   positionY.push_back(position.y);
+   positionZ.push_back(position.z);
+
+   previousPositionX.push_back(position.x);
+   previousPositionY.push_back(position.y);
+   previousPositionZ.push_back(position.z);
+
+   directionX.push_back(direction.x);
+   directionY.push_back(direction.y);
+   directionZ.push_back(direction.z);
+
+   colorIndices.push_back(colorIndex);
+}
+
+void ShotBuffer::Remove(std::size_t index)
+{
+   SwapAndPop(positionX, index);
+   SwapAndPop(positionY, index);
+   SwapAndPop(positionZ, index);
+
+   SwapAndPop(previousPositionX, index);
+   SwapAndPop(previousPositionY, index);
+   SwapAndPop(previousPositionZ, index);
+
+   SwapAndPop(directionX, index);
+   SwapAndPop(directionY, index);
+   SwapAndPop(directionZ, index);
+
+   SwapAndPop(colorIndices, index);
+}
+
+void ShotBuffer::Clear()
+{
+   positionX.clear();
+   positionY.clear();
+   positionZ.clear();
+
+   previousPositionX.clear();
+   previousPositionY.clear();
+   previousPositionZ.clear();
+
+   directionX.clear();
+   directionY.clear();
+   directionZ.clear();
+
+   colorIndices.clear();
+}
+
+void ShotBuffer::Reserve(std::size_t capacity)
+{
+   positionX.reserve(capacity);
+   positionY.reserve(capacity);
+   positionZ.reserve(capacity);
+
+   previousPositionX.reserve(capacity);
+   previousPositionY.reserve(capacity);
+   previousPositionZ.reserve(capacity);
+
+   directionX.reserve(capacity);
+   directionY.reserve(capacity);
+   directionZ.reserve(capacity);
+
+   colorIndices.reserve(capacity);
+
+   hitAsteroids.reserve(capacity);
+   hitFractions.reserve(capacity);
+}
+
+std::size_t ShotBuffer::Size() const
+{
+   return positionX.size();
+}
+
+Locus::FVector3 ShotBuffer::GetPosition(std::size_t index) const
+{
+   return Locus::FVector3(positionX[index], positionY[index], positionZ[index]);
+}
+
+Locus::FVector3 ShotBuffer::GetInterpolatedPosition(std::size_t index, float alpha) const
+{
+   Locus::FVector3 previousPosition(previousPositionX[index], previousPositionY[index], previousPositionZ[index]);
+
+   return previousPosition + alpha * (GetPosition(index) - previousPosition);
+}
+
+unsigned int ShotBuffer::GetColorIndex(std::size_t index) const
+{
+   return colorIndices[index];
+}
+
+void ShotBuffer::Advance(float units, float maxDistance)
+{
+   std::size_t numShots = Size();
+
+   //the arrays don't alias, so these loops vectorize
+   for (std::size_t shotIndex = 0; shotIndex < numShots; ++shotIndex)
+   {
+      previousPositionX[shotIndex] = positionX[shotIndex];
+      previousPositionY[shotIndex] = positionY[shotIndex];
+      previousPositionZ[shotIndex] = positionZ[shotIndex];
+
+      positionX[shotIndex] += units * directionX[shotIndex];
+      positionY[shotIndex] += units * directionY[shotIndex];
+      positionZ[shotIndex] += units * directionZ[shotIndex];
+   }
+
+   //remove the shots that went beyond maxDistance. Going backwards, the shot swapped
+   //into a removed one's place has already been checked
+   float maxSquaredDistance = maxDistance * maxDistance;
+
+   for (std::size_t shotIndex = numShots; shotIndex-- > 0; )
+   {
+      float squaredDistance = positionX[shotIndex] * positionX[shotIndex] + positionY[shotIndex] * positionY[shotIndex] + positionZ[shotIndex] * positionZ[shotIndex];
+
+      if (squaredDistance >= maxSquaredDistance)
+      {
+         Remove(shotIndex);
+      }
+   }
+}
+
+std::size_t ShotBuffer::ResolveHits(const AsteroidKinematics& kinematics, WorkerPool& workerPool)
+{
+   std::size_t numShots = Size();
+
+   if ((numShots == 0) || (kinematics.Size() == 0))
+   {
+      return 0;
+   }
+
+   BinAsteroids(kinematics);
+
+   hitAsteroids.resize(numShots);
+   hitFractions.resize(numShots);
+
+   //every shot is cast independently of the others and only writes its own result
+   workerPool.ParallelFor(numShots, Shot_Chunk_Size, [&](std::size_t begin, std::size_t end)
+   {
+      for (std::size_t shotIndex = begin; shotIndex < end; ++shotIndex)
+      {
+         FindFirstHit(shotIndex, kinematics);
+      }
+   });
+
+   //hits are registered on this thread as several shots may hit the same asteroid. Going
+   //backwards, the shot swapped into a removed one's place has already been dealt with
+   std::size_t numHits = 0;
+
+   for (std::size_t shotIndex = numShots; shotIndex-- > 0; )
+   {
+      if (hitAsteroids[shotIndex] != No_Hit)
+      {
+         Locus::FVector3 previousPosition(previousPositionX[shotIndex], previousPositionY[shotIndex], previousPositionZ[shotIndex]);
+
+         kinematics.GetAsteroid(hitAsteroids[shotIndex])->RegisterHit(previousPosition + hitFractions[shotIndex] * (GetPosition(shotIndex) - previousPosition));
+
+         Remove(shotIndex);
+         ++numHits;
+      }
+   }
+
+   return numHits;
+}
+
+void ShotBuffer::BinAsteroids(const AsteroidKinematics& kinematics)
+{
+   std::size_t numAsteroids = kinematics.Size();
+
+   Locus::FVector3 min = kinematics.GetPosition(0);
+   Locus::FVector3 max = min;
+   float maxReach = 0.0f;
+
+   for (std::size_t kinematicsIndex = 0; kinematicsIndex < numAsteroids; ++kinematicsIndex)
+   {
+      Locus::FVector3 position = kinematics.GetPosition(kinematicsIndex);
+      float reach = kinematics.GetRadius(kinematicsIndex) + SHOT_RADIUS;
+
+      min.x = std::min(min.x, position.x - reach);
+      min.y = std::min(min.y, position.y - reach);
+      min.z = std::min(min.z, position.z - reach);
+
+      max.x = std::max(max.x, position.x + reach);
+      max.y = std::max(max.y, position.y + reach);
+      max.z = std::max(max.z, position.z + reach);
+
+      maxReach = std::max(maxReach, reach);
+   }
+
+   gridOrigin[0] = min.x;
+   gridOrigin[1] = min.y;
+   gridOrigin[2] = min.z;
+
+   float extent = std::max(std::max(max.x - min.x, max.y - min.y), max.z - min.z);
+
+   //cells are at least as wide as the largest asteroid, so each asteroid is listed in at most 8
+   cellSize = std::max(2 * maxReach, extent / Max_Cells_Per_Axis);
+   cellsPerAxis = std::min(static_cast<std::size_t>(extent / cellSize) + 1, Max_Cells_Per_Axis);
+
+   std::size_t numCells = cellsPerAxis * cellsPerAxis * cellsPerAxis;
+
+   //counting sort of the asteroids by cell: count, sum the counts up to each cell's end,
+   //then fill each cell from its end back to its start
+
+   cellStarts.assign(numCells + 1, 0);
+
+   std::size_t first[3], last[3];
+
+   for (int pass = 0; pass < 2; ++pass)
+   {
+      for (std::size_t kinematicsIndex = 0; kinematicsIndex < numAsteroids; ++kinematicsIndex)
+      {
+         Locus::FVector3 position = kinematics.GetPosition(kinematicsIndex);
+         float reach = kinematics.GetRadius(kinematicsIndex) + SHOT_RADIUS;
+
+         CellRange(position - Locus::FVector3(reach, reach, reach), position + Locus::FVector3(reach, reach, reach), first, last);
+
+         for (std::size_t z = first[2]; z <= last[2]; ++z)
+         {
+            for (std::size_t y = first[1]; y <= last[1]; ++y)
+            {
+               for (std::size_t x = first[0]; x <= last[0]; ++x)
+               {
+                  std::size_t cell = (z * cellsPerAxis + y) * cellsPerAxis + x;
+
+                  if (pass == 0)
+                  {
+                     ++cellStarts[cell];
+                  }
+                  else
+                  {
+                     cellAsteroids[--cellStarts[cell]] = kinematicsIndex;
+                  }
+               }
+            }
+         }
+      }
+
+      if (pass == 0)
+      {
+         for (std::size_t cell = 1; cell <= numCells; ++cell)
+         {
+            cellStarts[cell] += cellStarts[cell - 1];
+         }
+
+         cellAsteroids.resize(cellStarts[numCells]);
+      }
+   }
+}
+
+bool ShotBuffer::CellRange(const Locus::FVector3& min, const Locus::FVector3& max, std::size_t (&first)[3], std::size_t (&last)[3]) const
+{
+   const float mins[3] = { min.x, min.y, min.z };
+   const float maxes[3] = { max.x, max.y, max.z };
+
+   float lastCell = static_cast<float>(cellsPerAxis - 1);
+
+   for (int axis = 0; axis < 3; ++axis)
+   {
+      float firstCoordinate = std::floor((mins[axis] - gridOrigin[axis]) / cellSize);
+      float lastCoordinate = std::floor((maxes[axis] - gridOrigin[axis]) / cellSize);
+
+      if ((lastCoordinate < 0.0f) || (firstCoordinate > lastCell))
+      {
+         return false;
+      }
+
+      first[axis] = static_cast<std::size_t>(std::max(firstCoordinate, 0.0f));
+      last[axis] = static_cast<std::size_t>(std::min(lastCoordinate, lastCell));
+   }
+
+   return true;
+}
+
+void ShotBuffer::FindFirstHit(std::size_t index, const AsteroidKinematics& kinematics)
+{
+   hitAsteroids[index] = No_Hit;
+   hitFractions[index] = 1.0f;
+
+   Locus::FVector3 start(previousPositionX[index], previousPositionY[index], previousPositionZ[index]);
+   Locus::FVector3 end = GetPosition(index);
+
+   Locus::FVector3 min(std::min(start.x, end.x), std::min(start.y, end.y), std::min(start.z, end.z));
+   Locus::FVector3 max(std::max(start.x, end.x), std::max(start.y, end.y), std::max(start.z, end.z));
+
+   std::size_t first[3], last[3];
+
+   //the grid covers every asteroid, so a segment outside of it can't hit any
+   if (!CellRange(min, max, first, last))
+   {
+      return;
+   }
+
+   Locus::FVector3 segment = end - start;
+   float segmentSquaredLength = SquaredNorm(segment);
+
+   NarrowphaseScratch& scratch = NarrowphaseScratch::ForThisThread();
+
+   //an asteroid in more than one of the cells is cast against more than once, which
+   //doesn't change the result as only the nearest hit is kept
+   for (std::size_t z = first[2]; z <= last[2]; ++z)
+   {
+      for (std::size_t y = first[1]; y <= last[1]; ++y)
+      {
+         for (std::size_t x = first[0]; x <= last[0]; ++x)
+         {
+            std::size_t cell = (z * cellsPerAxis + y) * cellsPerAxis + x;
+
+            for (std::size_t entry = cellStarts[cell]; entry < cellStarts[cell + 1]; ++entry)
+            {
+               std::size_t kinematicsIndex = cellAsteroids[entry];
+
+               //early out if the shot misses the asteroid's bounding sphere
+
+               Locus::FVector3 toCentroid = kinematics.GetPosition(kinematicsIndex) - start;
+
+               float closestFraction = (segmentSquaredLength > 0.0f) ? std::min(std::max(Dot(toCentroid, segment) / segmentSquaredLength, 0.0f), 1.0f) : 0.0f;
+
+               float reach = kinematics.GetRadius(kinematicsIndex) + SHOT_RADIUS;
+
+               if (SquaredNorm(toCentroid - closestFraction * segment) > reach * reach)
+               {
+                  continue;
+               }
+
+               const Asteroid* asteroid = kinematics.GetAsteroid(kinematicsIndex);
+
+               //an asteroid at reduced detail may not have been synced with its kinematics this
+               //step. The segment is moved back by as much instead
+               Locus::FVector3 frameLag = asteroid->GetFrameLag();
+
+               std::size_t hitTriangle;
+               float hitFraction;
+
+               if (asteroid->GetBoundingVolumeHierarchy().GetFirstHit(asteroid->GetModelFrame(), start - frameLag, end - frameLag, SHOT_RADIUS, scratch, hitTriangle, hitFraction) &&
+                   ((hitAsteroids[index] == No_Hit) || (hitFraction < hitFractions[index])))
+               {
+                  hitAsteroids[index] = kinematicsIndex;
+                  hitFractions[index] = hitFraction;
+               }
+            }
+         }
+      }
+   }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include <vector>
+
+#include <cstddef>
+
+//TODO: Remove magic numbers, either by putting in data files or use a scripting interface
+#define SHOT_RADIUS 0.5f
+
+namespace MPM
+{
+
+class AsteroidKinematics;
+class WorkerPool;
+
+//Every shot in flight, kept as contiguous arrays (struct of arrays) like the asteroids'
+//kinematics. The shots are moved in one pass and cast against the asteroids in one
+//batched query per step, rather than each being a body in the broadphase
+class ShotBuffer
+{
+public:
+   ShotBuffer();
+
+   void Add(const Locus::FVector3& position, const Locus::FVector3& direction, unsigned int colorIndex);
+   void Clear();
+   void Reserve(std::size_t capacity);
+
+   std::size_t Size() const;
+
+   Locus::FVector3 GetPosition(std::size_t index) const;
+   Locus::FVector3 GetInterpolatedPosition(std::size_t index, float alpha) const;
+
+   //whatever the shot was fired with. The game uses it to pick the shot's light color
+   unsigned int GetColorIndex(std::size_t index) const;
+
+   //moves every shot units along its direction. Shots that end up maxDistance or more
+   //from the origin are removed, so indices aren't stable across calls
+   void Advance(float units, float maxDistance);
+
+   //casts every shot, a sphere of SHOT_RADIUS, along the segment it moved through in the last
+   //Advance, so that it can't pass through an asteroid between steps. A shot registers a hit
+   //on the first asteroid it touches and is removed. Returns the number of shots that hit
+   std::size_t ResolveHits(const AsteroidKinematics& kinematics, WorkerPool& workerPool);
+
+private:
+   std::vector<float> positionX;
+   std::vector<float> positionY;
+   std::vector<float> positionZ;
+
+   std::vector<float> previousPositionX;
+   std::vector<float> previousPositionY;
+   std::vector<float> previousPositionZ;
+
+   std::vector<float> directionX;
+   std::vector<float> directionY;
+   std::vector<float> directionZ;
+
+   std::vector<unsigned int> colorIndices;
+
+   //the asteroids binned into a uniform grid for ResolveHits. An asteroid is listed in
+   //every cell its bounding sphere (grown by SHOT_RADIUS) overlaps
+   float gridOrigin[3];
+   float cellSize;
+   std::size_t cellsPerAxis;
+   std::vector<std::size_t> cellStarts;
+   std::vector<std::size_t> cellAsteroids;
+
+   //per shot results of ResolveHits
+   std::vector<std::size_t> hitAsteroids;
+   std::vector<float> hitFractions;
+
+   void Remove(std::size_t index);
+
+   void BinAsteroids(const AsteroidKinematics& kinematics);
+   bool CellRange(const Locus::FVector3& min, const Locus::FVector3& max, std::size_t (&first)[3], std::size_t (&last)[3]) const;
+   void FindFirstHit(std::size_t index, const AsteroidKinematics& kinematics);
+};
+
+}
\ No newline at end of file
@@ -8,12 +8,7 @@
 *                                                                                                        *
 \********************************************************************************************************/
 
-#include "Shot.h"
-#include "Asteroid.h"
-#include "CollidableTypes.h"
-
-#include "Locus/Geometry/Quaternion.h"
-#include "Locus/Geometry/Vector3Geometry.h"
+#include "ShotDrawable.h"
 
 #include "Locus/Rendering/Mesh.h"
 #include "Locus/Rendering/DefaultGPUVertexData.h"
@@ -24,78 +19,17 @@
 namespace MPM
 {
 
-Shot::Shot(const Locus::FVector3& direction, const Locus::FVector3& position, Locus::Mesh* mesh)
-   : valid(true), position(position), collisionBox(position, 2 * SHOT_RADIUS, 2 * SHOT_RADIUS, 2 * SHOT_RADIUS), mesh(mesh)
-{
-   collidableType = CollidableType_Shot;
-
-   motionProerties.direction = direction;
-
-   const Locus::FVector3& zAxis = Locus::Vec3D::ZAxis();
-   Locus::Quaternion inverseRotation(Cross(direction, zAxis), AngleBetweenRadians(zAxis, direction));
-
-   collisionBox.SetRotationInverse( inverseRotation.ToTransformation() );
-}
-
-const Locus::FVector3& Shot::GetPosition() const
-{
-   return position;
-}
-
-bool Shot::IsValid() const
-{
-   return valid;
-}
-
-void Shot::MoveAlongDirection(float units)
-{
-   Locus::FVector3 oldPosition = position;
-
-   position += units * motionProerties.direction;
-
-   collisionBox.centroid = (position + oldPosition) / 2.0f ;
-   collisionBox.SetZLength( Norm(position - oldPosition) + 2 * SHOT_RADIUS );
-}
-
-void Shot::UpdateBroadCollisionExtent()
-{
-   Collidable::UpdateBroadCollisionExtent(position, collisionBox.DiagonalLength() / 2);
-}
-
-bool Shot::CollidesWith(Collidable& collidable) const
-{
-   return (collidable.GetCollidableType() == CollidableType_Asteroid);
-}
-
-void Shot::ResolveCollision(Collidable& collidable)
+ShotDrawable::ShotDrawable(const Locus::Color& color, Locus::Mesh* mesh)
+   : color(color), mesh(mesh)
 {
-   ResolveCollision( dynamic_cast<Asteroid&>(collidable) );
 }
 
-void Shot::ResolveCollision(Asteroid& asteroid)
+const Locus::Color& ShotDrawable::GetColor() const
 {
-   std::unordered_set<std::size_t> asteroidIntersectionSet;
-
-   asteroid.GetBoundingVolumeHierarchy().GetIntersection(asteroid, collisionBox, asteroidIntersectionSet);
-
-   if (asteroidIntersectionSet.size() > 0)
-   {
-      Locus::Transformation asteroidTransformation = asteroid.CurrentModelTransformation();
-
-      for (std::size_t triangleIndex : asteroidIntersectionSet)
-      {
-         if (collisionBox.Intersects(asteroid.GetFaceTriangle(triangleIndex, asteroidTransformation)))
-         {
-            asteroid.RegisterHit(position);
-            valid = false;
-
-            return;
-         }
-      }
-   }
+   return color;
 }
 
-void Shot::UpdateGPUVertexData()
+void ShotDrawable::UpdateGPUVertexData()
 {
    if ((defaultGPUVertexData != nullptr) && (mesh != nullptr))
    {
@@ -125,7 +59,7 @@ void Shot::UpdateGPUVertexData()
    }
 }
 
-void Shot::Draw(Locus::RenderingState& renderingState) const
+void ShotDrawable::Draw(Locus::RenderingState& renderingState) const
 {
    if ((gpuVertexData != nullptr) && (mesh != nullptr))
    {
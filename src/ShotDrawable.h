@@ -10,18 +10,9 @@
 
 #pragma once
 
-#include "Locus/Math/Vectors.h"
-
-#include "Locus/Geometry/Collidable.h"
-#include "Locus/Geometry/MotionProperties.h"
-#include "Locus/Geometry/OrientedBox.h"
-
 #include "Locus/Rendering/Color.h"
 #include "Locus/Rendering/DefaultSingleDrawable.h"
 
-//TODO: Remove magic numbers, either by putting in data files or use a scripting interface
-#define SHOT_RADIUS 0.5f
-
 namespace Locus
 {
 
@@ -32,37 +23,20 @@ class Mesh;
 namespace MPM
 {
 
-class Asteroid;
-
-class Shot : public Locus::Collidable, public Locus::DefaultSingleDrawable
+//The look of the shots fired with one light color. Shots themselves are only positions
+//in the simulation's ShotBuffer, so a single drawable is drawn at each of them
+class ShotDrawable : public Locus::DefaultSingleDrawable
 {
 public:
-   Shot(const Locus::FVector3& direction, const Locus::FVector3& position, Locus::Mesh* mesh);
-
-   const Locus::FVector3& GetPosition() const;
-
-   virtual void UpdateBroadCollisionExtent();
+   ShotDrawable(const Locus::Color& color, Locus::Mesh* mesh);
 
-   virtual bool CollidesWith(Collidable& collidable) const override;
-   virtual void ResolveCollision(Collidable& collidable) override;
-   void ResolveCollision(Asteroid& asteroid);
-
-   bool IsValid() const;
-
-   void MoveAlongDirection(float units);
+   const Locus::Color& GetColor() const;
 
    virtual void UpdateGPUVertexData() override;
    virtual void Draw(Locus::RenderingState& renderingState) const override;
 
-   //temp
-   Locus::Color color;
-
 private:
-   bool valid;
-   Locus::MotionProperties motionProerties;
-   Locus::FVector3 position;
-   Locus::OrientedBox collisionBox;
-
+   Locus::Color color;
    Locus::Mesh* mesh;
 };
 
@@ -0,0 +1,368 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "SimulationChecks.h"
+#include "Asteroid.h"
+#include "AsteroidKinematics.h"
+#include "CollidableTypes.h"
+#include "CollisionDispatch.h"
+#include "ConvexCollision.h"
+#include "ConvexHull.h"
+#include "ModelFrame.h"
+#include "NarrowphaseScratch.h"
+#include "Random.h"
+#include "WorkerPool.h"
+
+#include "Locus/Geometry/Geometry.h"
+#include "Locus/Geometry/Model.h"
+#include "Locus/Geometry/ModelUtility.h"
+#include "Locus/Geometry/Vector3Geometry.h"
+
+#include <algorithm>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+
+namespace MPM
+{
+
+//how far a measured contact depth may be from the expected one
+static const float Depth_Tolerance = 1e-3f;
+
+//the least dot product of a measured contact normal with the expected one
+static const float Min_Normal_Alignment = 0.999f;
+
+//how far an asteroid's position may be from where its reflected path puts it
+static const double Path_Tolerance = 2e-4;
+
+static const std::size_t Num_Path_Asteroids = 5000;
+static const float Path_Boundary = 130.0f;
+static const double Path_DT = 1.0 / 60.0;
+static const unsigned int Num_Path_Steps = 60 * 600;
+
+//every so many steps an asteroid is removed, a share of them is set on a new line on
+//the worker threads, and all of them are compared with their paths
+static const unsigned int Path_Removal_Interval = 100;
+static const unsigned int Path_Line_Change_Interval = 250;
+static const unsigned int Path_Comparison_Interval = 600;
+
+namespace
+{
+
+struct BoxContactCase
+{
+   const char* name;
+
+   //where the second box is put, and how it is turned, relative to the first
+   Locus::FVector3 offset;
+   Locus::FVector3 rotation;
+
+   bool collides;
+   float depth;
+   Locus::FVector3 normal;
+};
+
+//two cubes with sides of 2. The 45 degree turn about z puts an edge of the second one
+//a distance of sqrt(2) from its center
+bool CheckBoxContacts(std::ostream& out)
+{
+   const float edgeDistance = std::sqrt(2.0f);
+
+   const BoxContactCase cases[] =
+   {
+      {"separated boxes",         Locus::FVector3(3.0f, 0.0f, 0.0f),                    Locus::FVector3(), false, 0.0f, Locus::FVector3()},
+      {"face touching boxes",     Locus::FVector3(2.0f, 0.0f, 0.0f),                    Locus::FVector3(), false, 0.0f, Locus::FVector3()},
+      {"shifted face touching",   Locus::FVector3(2.0f, 0.5f, 0.3f),                    Locus::FVector3(), false, 0.0f, Locus::FVector3()},
+      {"corner touching boxes",   Locus::FVector3(2.0f, 2.0f, 2.0f),                    Locus::FVector3(), false, 0.0f, Locus::FVector3()},
+      {"edge touching boxes",     Locus::FVector3(1.0f + edgeDistance, 0.0f, 0.0f),     Locus::FVector3(0.0f, 0.0f, Locus::PI/4), false, 0.0f, Locus::FVector3()},
+      {"overlapping boxes",       Locus::FVector3(1.5f, 0.2f, 0.1f),                    Locus::FVector3(), true, 0.5f, Locus::FVector3(1.0f, 0.0f, 0.0f)},
+      {"overlapping boxes below", Locus::FVector3(0.0f, -1.9f, 0.0f),                   Locus::FVector3(), true, 0.1f, Locus::FVector3(0.0f, -1.0f, 0.0f)},
+      {"edge overlapping boxes",  Locus::FVector3(0.75f + edgeDistance, 0.0f, 0.0f),    Locus::FVector3(0.0f, 0.0f, Locus::PI/4), true, 0.25f, Locus::FVector3(1.0f, 0.0f, 0.0f)}
+   };
+
+   Locus::Model_t box = Locus::ModelUtility::MakeCube(2.0f);
+
+   ConvexHull hull(box);
+
+   ModelFrame firstFrame(box.CurrentModelTransformation());
+
+   NarrowphaseScratch& scratch = NarrowphaseScratch::ForThisThread();
+
+   bool passed = true;
+
+   for (const BoxContactCase& boxCase : cases)
+   {
+      Locus::Model_t placedBox = Locus::ModelUtility::MakeCube(2.0f);
+
+      if (SquaredNorm(boxCase.rotation) > 0.0f)
+      {
+         placedBox.Rotate(boxCase.rotation);
+      }
+
+      placedBox.Translate(boxCase.offset);
+
+      ConvexContact contact;
+
+      bool collides = GetConvexContact(hull, firstFrame, hull, ModelFrame(placedBox.CurrentModelTransformation()), scratch, contact);
+
+      bool casePassed = (collides == boxCase.collides);
+
+      if (casePassed && collides)
+      {
+         casePassed = (std::abs(contact.depth - boxCase.depth) <= Depth_Tolerance) && (Dot(contact.normal, boxCase.normal) >= Min_Normal_Alignment);
+      }
+
+      out << (casePassed ? "ok      " : "FAILED  ") << "GJK/EPA " << boxCase.name << ": ";
+
+      if (collides)
+      {
+         out << "depth " << contact.depth << ", normal (" << contact.normal.x << ", " << contact.normal.y << ", " << contact.normal.z << ")";
+      }
+      else
+      {
+         out << "no contact";
+      }
+
+      out << std::endl;
+
+      passed = passed && casePassed;
+   }
+
+   return passed;
+}
+
+//broadphases hand a pair over in either order, so a pair of collidable types has to
+//collide in both orders or in neither
+bool CheckDispatchSymmetry(std::ostream& out)
+{
+   bool passed = true;
+
+   for (int firstType = 0; firstType < Num_CollidableTypes; ++firstType)
+   {
+      for (int secondType = firstType + 1; secondType < Num_CollidableTypes; ++secondType)
+      {
+         if (CollisionDispatch::ShouldCollide(firstType, secondType) != CollisionDispatch::ShouldCollide(secondType, firstType))
+         {
+            out << "FAILED  collision dispatch: types " << firstType << " and " << secondType << " collide in one order only" << std::endl;
+
+            passed = false;
+         }
+      }
+   }
+
+   if (passed)
+   {
+      out << "ok      collision dispatch: every pair of types collides in both orders or in neither" << std::endl;
+   }
+
+   return passed;
+}
+
+//where a point moving at a constant speed along one axis is after time, if it bounces
+//between -boundary and boundary
+double ReflectedCoordinate(double start, double velocity, double time, double boundary)
+{
+   double unfolded = std::fmod(start + velocity * time + boundary, 4 * boundary);
+
+   if (unfolded < 0.0)
+   {
+      unfolded += 4 * boundary;
+   }
+
+   return (unfolded <= 2 * boundary) ? (unfolded - boundary) : (3 * boundary - unfolded);
+}
+
+//the line an asteroid was last set on, kept in double precision
+struct AsteroidPath
+{
+   double start[3];
+   double velocity[3];
+   double startTime;
+
+   double CoordinateAt(int axis, double time) const
+   {
+      return ReflectedCoordinate(start[axis], velocity[axis], time - startTime, Path_Boundary);
+   }
+
+   double ErrorAt(const Locus::FVector3& position, double time) const
+   {
+      return std::max(std::max(std::abs(position.x - CoordinateAt(0, time)), std::abs(position.y - CoordinateAt(1, time))),
+                      std::abs(position.z - CoordinateAt(2, time)));
+   }
+};
+
+//moves asteroids through AsteroidKinematics, with removals and line changes made from
+//worker threads as collision responses make them, and compares where it puts them with
+//their reflected paths worked out directly
+bool CheckKinematicsPaths(std::ostream& out)
+{
+   MPM::Random random(1, RandomStream_Default);
+
+   AsteroidKinematics kinematics;
+   kinematics.SetBoundary(Path_Boundary);
+   kinematics.Reserve(Num_Path_Asteroids);
+
+   std::vector<std::unique_ptr<Asteroid>> asteroids;
+   std::vector<AsteroidPath> paths(Num_Path_Asteroids);
+   std::unordered_map<const Asteroid*, std::size_t> pathIndices;
+
+   for (std::size_t asteroidIndex = 0; asteroidIndex < Num_Path_Asteroids; ++asteroidIndex)
+   {
+      std::unique_ptr<Asteroid> asteroid(new Asteroid());
+
+      Locus::FVector3 position(static_cast<float>(random.RandomDouble(-120.0, 120.0)),
+                               static_cast<float>(random.RandomDouble(-120.0, 120.0)),
+                               static_cast<float>(random.RandomDouble(-120.0, 120.0)));
+
+      asteroid->motionProperties.direction = Locus::FVector3(static_cast<float>(random.RandomDouble(-1.0, 1.0)),
+                                                             static_cast<float>(random.RandomDouble(-1.0, 1.0)),
+                                                             static_cast<float>(random.RandomDouble(-1.0, 1.0)));
+      Normalize(asteroid->motionProperties.direction);
+      asteroid->motionProperties.speed = static_cast<float>(random.RandomDouble(10.0, 20.0));
+      asteroid->motionProperties.rotation = Locus::FVector3(0.0f, 1.0f, 0.0f);
+      asteroid->motionProperties.angularSpeed = 1.0f;
+
+      asteroid->Translate(position);
+      asteroid->AttachKinematics(kinematics);
+
+      AsteroidPath& path = paths[asteroidIndex];
+
+      path.start[0] = position.x;
+      path.start[1] = position.y;
+      path.start[2] = position.z;
+
+      path.velocity[0] = asteroid->motionProperties.direction.x * asteroid->motionProperties.speed;
+      path.velocity[1] = asteroid->motionProperties.direction.y * asteroid->motionProperties.speed;
+      path.velocity[2] = asteroid->motionProperties.direction.z * asteroid->motionProperties.speed;
+
+      path.startTime = 0.0;
+
+      pathIndices[asteroid.get()] = asteroidIndex;
+      asteroids.push_back(std::move(asteroid));
+   }
+
+   WorkerPool workerPool(4);
+
+   double time = 0.0;
+   double maxError = 0.0;
+   std::size_t numRemovals = 0;
+
+   for (unsigned int step = 1; step <= Num_Path_Steps; ++step)
+   {
+      kinematics.Advance(Path_DT);
+      time += Path_DT;
+
+      if ((step % Path_Line_Change_Interval) == 0)
+      {
+         //each index belongs to a different asteroid, and so to a different path
+         workerPool.ParallelFor(kinematics.Size(), 256, [&](std::size_t begin, std::size_t end)
+         {
+            for (std::size_t index = begin; index < end; ++index)
+            {
+               if (((index + step) % 7) != 0)
+               {
+                  continue;
+               }
+
+               AsteroidPath& path = paths[pathIndices.at(kinematics.GetAsteroid(index))];
+
+               double position[3];
+
+               for (int axis = 0; axis < 3; ++axis)
+               {
+                  position[axis] = path.CoordinateAt(axis, time);
+               }
+
+               //turn the line about the diagonal, keeping its speed
+               Locus::MotionProperties motionProperties;
+
+               motionProperties.direction = Locus::FVector3(static_cast<float>(path.velocity[1]), static_cast<float>(path.velocity[2]), static_cast<float>(path.velocity[0]));
+               motionProperties.speed = Norm(motionProperties.direction);
+               motionProperties.direction /= motionProperties.speed;
+               motionProperties.rotation = Locus::FVector3(0.0f, 1.0f, 0.0f);
+               motionProperties.angularSpeed = 1.0f;
+
+               kinematics.SetMotionProperties(index, motionProperties);
+
+               //the path follows the velocity the kinematics was given, rounding and all
+               path.velocity[0] = motionProperties.direction.x * motionProperties.speed;
+               path.velocity[1] = motionProperties.direction.y * motionProperties.speed;
+               path.velocity[2] = motionProperties.direction.z * motionProperties.speed;
+
+               for (int axis = 0; axis < 3; ++axis)
+               {
+                  path.start[axis] = position[axis];
+               }
+
+               path.startTime = time;
+            }
+         });
+      }
+
+      if (((step % Path_Removal_Interval) == 0) && !asteroids.empty())
+      {
+         std::size_t removedIndex = static_cast<std::size_t>(random.RandomInt(0, static_cast<int>(asteroids.size()) - 1));
+
+         pathIndices.erase(asteroids[removedIndex].get());
+         asteroids[removedIndex]->DetachKinematics();
+
+         //so that every removal picks an asteroid still in the kinematics
+         asteroids[removedIndex] = std::move(asteroids.back());
+         asteroids.pop_back();
+
+         ++numRemovals;
+      }
+
+      if ((step % Path_Comparison_Interval) == 0)
+      {
+         //the interpolated position lies between the previous step and this one
+         const float alpha = 0.3f;
+         double interpolatedTime = time - (1.0 - alpha) * Path_DT;
+
+         for (std::size_t index = 0; index < kinematics.Size(); ++index)
+         {
+            const AsteroidPath& path = paths[pathIndices.at(kinematics.GetAsteroid(index))];
+
+            maxError = std::max(maxError, path.ErrorAt(kinematics.GetPosition(index), time));
+
+            if (path.startTime < interpolatedTime)
+            {
+               maxError = std::max(maxError, path.ErrorAt(kinematics.GetInterpolatedPosition(index, alpha), interpolatedTime));
+            }
+         }
+      }
+   }
+
+   bool passed = (maxError <= Path_Tolerance) && (kinematics.Size() == Num_Path_Asteroids - numRemovals);
+
+   out << (passed ? "ok      " : "FAILED  ") << "kinematics " << Num_Path_Asteroids << " reflected paths over " << (Num_Path_Steps * Path_DT)
+       << "s with " << numRemovals << " removals: max error " << maxError << ", " << kinematics.Size() << " left" << std::endl;
+
+   return passed;
+}
+
+}
+
+bool RunSimulationChecks(std::ostream& out)
+{
+   bool passed = true;
+
+   passed = CheckDispatchSymmetry(out) && passed;
+   passed = CheckBoxContacts(out) && passed;
+   passed = CheckKinematicsPaths(out) && passed;
+
+   return passed;
+}
+
+}
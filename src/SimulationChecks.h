@@ -0,0 +1,23 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include <iosfwd>
+
+namespace MPM
+{
+
+//Runs the simulation's collision and motion code on cases whose answers are known in
+//closed form and prints a line per check to out. Needs no resources or options.
+//Returns false if any check failed
+bool RunSimulationChecks(std::ostream& out);
+
+}
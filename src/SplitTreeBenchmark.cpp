@@ -0,0 +1,142 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "SplitTreeBenchmark.h"
+#include "Asteroid.h"
+#include "FractureLibrary.h"
+#include "ModelFrame.h"
+#include "TriangleTree.h"
+
+#include "Locus/Geometry/Transformation.h"
+
+#include <chrono>
+
+namespace MPM
+{
+
+//the lower face bound of each row; the last row has no upper bound
+static const std::size_t Row_Min_Faces[] = {0, 32, 64, 128};
+static const std::size_t Num_Rows = sizeof(Row_Min_Faces) / sizeof(Row_Min_Faces[0]);
+
+namespace
+{
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double ToMicroseconds(Clock::duration duration)
+{
+   return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+std::size_t RowIndex(std::size_t numFaces)
+{
+   std::size_t rowIndex = 0;
+
+   while ((rowIndex + 1 < Num_Rows) && (numFaces >= Row_Min_Faces[rowIndex + 1]))
+   {
+      ++rowIndex;
+   }
+
+   return rowIndex;
+}
+
+struct RowTotals
+{
+   RowTotals()
+      : numHalves(0), splitBuildTime(0), rebuildTime(0)
+   {
+   }
+
+   std::size_t numHalves;
+   Clock::duration splitBuildTime;
+   Clock::duration rebuildTime;
+};
+
+void TimeNode(const FractureNode& node, int numRepeats, std::vector<RowTotals>& totals)
+{
+   //the library's pieces are centered on their own centroids, so a half's model space is
+   //its parent's moved by the half's offset, and every cut passes through the parent's origin
+   TriangleTree parentTree(*node.asteroid, Asteroid::Bounding_Volume_Hierarchy_Depth);
+
+   ModelFrame parentFrame;
+
+   for (std::size_t childIndex = 0; childIndex < node.children.size(); ++childIndex)
+   {
+      const FractureNode* child = node.children[childIndex].get();
+
+      if (child == nullptr)
+      {
+         continue;
+      }
+
+      const Asteroid& half = *child->asteroid;
+
+      ModelFrame halfFrame(Locus::Transformation::Translation(child->offset));
+      ModelFrame parentToHalf = ModelFrame::Relative(parentFrame, halfFrame);
+
+      const Locus::FVector3& direction = FractureLibrary::Direction(childIndex / 2);
+      Locus::FVector3 cutNormal = ((childIndex % 2) == 0) ? direction : -direction;
+      float cutDistance = -Dot(cutNormal, child->offset);
+
+      RowTotals& rowTotals = totals[RowIndex(half.NumFaces())];
+
+      Clock::time_point start = Clock::now();
+
+      for (int repeat = 0; repeat < numRepeats; ++repeat)
+      {
+         TriangleTree splitTree(parentTree, parentToHalf, cutNormal, cutDistance, half, Asteroid::Bounding_Volume_Hierarchy_Depth);
+      }
+
+      Clock::time_point splitBuilt = Clock::now();
+
+      for (int repeat = 0; repeat < numRepeats; ++repeat)
+      {
+         TriangleTree tree(half, Asteroid::Bounding_Volume_Hierarchy_Depth);
+      }
+
+      rowTotals.splitBuildTime += splitBuilt - start;
+      rowTotals.rebuildTime += Clock::now() - splitBuilt;
+      ++rowTotals.numHalves;
+
+      TimeNode(*child, numRepeats, totals);
+   }
+}
+
+}
+
+std::vector<SplitTreeBenchmarkRow> RunSplitTreeBenchmark(const FractureLibrary& library, int numRepeats)
+{
+   std::vector<RowTotals> totals(Num_Rows);
+
+   for (std::size_t modelIndex = 0; modelIndex < library.NumModels(); ++modelIndex)
+   {
+      TimeNode(library.GetModel(modelIndex), numRepeats, totals);
+   }
+
+   std::vector<SplitTreeBenchmarkRow> rows(Num_Rows);
+
+   for (std::size_t rowIndex = 0; rowIndex < Num_Rows; ++rowIndex)
+   {
+      SplitTreeBenchmarkRow& row = rows[rowIndex];
+
+      row.minFaces = Row_Min_Faces[rowIndex];
+      row.maxFaces = (rowIndex + 1 < Num_Rows) ? Row_Min_Faces[rowIndex + 1] : 0;
+      row.numHalves = totals[rowIndex].numHalves;
+
+      double numBuilds = static_cast<double>(row.numHalves) * numRepeats;
+
+      row.splitBuildMicroseconds = (numBuilds > 0) ? ToMicroseconds(totals[rowIndex].splitBuildTime) / numBuilds : 0.0;
+      row.rebuildMicroseconds = (numBuilds > 0) ? ToMicroseconds(totals[rowIndex].rebuildTime) / numBuilds : 0.0;
+   }
+
+   return rows;
+}
+
+}
@@ -0,0 +1,40 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+class FractureLibrary;
+
+//the halves with at least minFaces and less than maxFaces faces (0 for no upper bound)
+struct SplitTreeBenchmarkRow
+{
+   std::size_t minFaces;
+   std::size_t maxFaces;
+
+   std::size_t numHalves;
+
+   //the average time to build the tree of one half from its parent's tree, and from scratch
+   double splitBuildMicroseconds;
+   double rebuildMicroseconds;
+};
+
+//Measures whether building the triangle tree of a fragment from its parent's tree (the
+//TriangleTree split constructor) pays off over building it from scratch, grouped by the
+//size of the fragment. Every cut in the library is rebuilt numRepeats times both ways
+std::vector<SplitTreeBenchmarkRow> RunSplitTreeBenchmark(const FractureLibrary& library, int numRepeats);
+
+}
@@ -0,0 +1,400 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "SweepAndPruneBroadphase.h"
+#include "CollisionBody.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+#include <cassert>
+
+namespace MPM
+{
+
+//a fat box is the body's bounding box grown on every side by this fraction of the body's radius...
+static const float Fat_Margin_Fraction = 0.25f;
+
+//...plus this much, so that small fast bodies (shots) aren't rebuilt every frame
+static const float Min_Fat_Margin = 1.0f;
+
+//overlapping pairs are handed out to the worker threads in chunks of this many
+static const std::size_t Pair_Chunk_Size = 256;
+
+SweepAndPruneBroadphase::SweepAndPruneBroadphase(WorkerPool& workerPool)
+   : PairBroadphase(workerPool), batching(false), endpointsNeedPurge(false), endpointsNeedSort(false), numReinsertions(0), numPendingReinsertions(0)
+{
+}
+
+void SweepAndPruneBroadphase::Add(CollisionBody* body)
+{
+   assert(body->GetBroadphaseIndex() == CollisionBody::No_Broadphase_Index);
+
+   std::uint32_t proxyIndex;
+
+   if (!freeProxyIndices.empty())
+   {
+      proxyIndex = freeProxyIndices.back();
+      freeProxyIndices.pop_back();
+   }
+   else
+   {
+      proxyIndex = static_cast<std::uint32_t>(proxies.size());
+      proxies.push_back(Proxy());
+   }
+
+   Proxy& proxy = proxies[proxyIndex];
+
+   proxy.body = body;
+   MakeFatBox(proxy);
+
+   body->SetBroadphaseIndex(proxyIndex);
+
+   //the new endpoints start out past every other endpoint, as if the body were
+   //far away, and are sorted into place (finding its overlaps) by UpdateCollisions
+   for (int axis = 0; axis < 3; ++axis)
+   {
+      Endpoint endpoint;
+      endpoint.proxyIndex = proxyIndex;
+
+      endpoint.isMin = true;
+      endpoints[axis].push_back(endpoint);
+
+      endpoint.isMin = false;
+      endpoints[axis].push_back(endpoint);
+   }
+
+   endpointsNeedSort = true;
+}
+
+void SweepAndPruneBroadphase::Remove(CollisionBody* body)
+{
+   std::uint32_t proxyIndex = static_cast<std::uint32_t>(body->GetBroadphaseIndex());
+
+   assert(proxyIndex < proxies.size());
+
+   RemoveOverlappingPairsOf(proxyIndex);
+
+   proxies[proxyIndex].body = nullptr;
+   removedProxyIndices.push_back(proxyIndex);
+
+   body->SetBroadphaseIndex(CollisionBody::No_Broadphase_Index);
+
+   endpointsNeedPurge = true;
+
+   if (!batching)
+   {
+      PurgeEndpoints();
+   }
+}
+
+void SweepAndPruneBroadphase::Update(CollisionBody* body)
+{
+   std::size_t proxyIndex = body->GetBroadphaseIndex();
+
+   assert(proxyIndex < proxies.size());
+
+   Proxy& proxy = proxies[proxyIndex];
+
+   if (FatBoxContains(proxy, *body))
+   {
+      return;
+   }
+
+   MakeFatBox(proxy);
+
+   ++numPendingReinsertions;
+
+   endpointsNeedSort = true;
+}
+
+void SweepAndPruneBroadphase::Clear()
+{
+   for (Proxy& proxy : proxies)
+   {
+      if (proxy.body != nullptr)
+      {
+         proxy.body->SetBroadphaseIndex(CollisionBody::No_Broadphase_Index);
+      }
+   }
+
+   proxies.clear();
+   freeProxyIndices.clear();
+   removedProxyIndices.clear();
+
+   for (int axis = 0; axis < 3; ++axis)
+   {
+      endpoints[axis].clear();
+   }
+
+   overlappingPairs.clear();
+   overlappingPairIndices.clear();
+
+   pairs.clear();
+
+   endpointsNeedPurge = false;
+   endpointsNeedSort = false;
+
+   numReinsertions = 0;
+   numPendingReinsertions = 0;
+}
+
+void SweepAndPruneBroadphase::StartAddRemoveBatch()
+{
+   batching = true;
+}
+
+void SweepAndPruneBroadphase::FinishAddRemoveBatch()
+{
+   batching = false;
+
+   if (endpointsNeedPurge)
+   {
+      PurgeEndpoints();
+   }
+}
+
+void SweepAndPruneBroadphase::UpdateCollisions()
+{
+   if (endpointsNeedPurge)
+   {
+      PurgeEndpoints();
+   }
+
+   if (endpointsNeedSort)
+   {
+      for (int axis = 0; axis < 3; ++axis)
+      {
+         SortEndpoints(axis);
+      }
+
+      endpointsNeedSort = false;
+   }
+
+   numReinsertions = numPendingReinsertions;
+   numPendingReinsertions = 0;
+
+   //the fat boxes only say which pairs to look at; the bodies' own extents decide
+   std::size_t numOverlappingPairs = overlappingPairs.size();
+   std::size_t numChunks = (numOverlappingPairs + Pair_Chunk_Size - 1) / Pair_Chunk_Size;
+
+   if (chunkPairs.size() < numChunks)
+   {
+      chunkPairs.resize(numChunks);
+   }
+
+   workerPool.ParallelFor(numOverlappingPairs, Pair_Chunk_Size, [&](std::size_t begin, std::size_t end)
+   {
+      std::vector<CollisionPair>& candidatePairs = chunkPairs[begin / Pair_Chunk_Size];
+
+      candidatePairs.clear();
+
+      for (std::size_t pairIndex = begin; pairIndex < end; ++pairIndex)
+      {
+         std::uint64_t pairKey = overlappingPairs[pairIndex];
+
+         CollisionBody* body1 = proxies[static_cast<std::uint32_t>(pairKey >> 32)].body;
+         CollisionBody* body2 = proxies[static_cast<std::uint32_t>(pairKey)].body;
+
+         if (IsCandidatePair(*body1, *body2))
+         {
+            candidatePairs.push_back( CollisionPair(body1, body2) );
+         }
+      }
+   });
+
+   pairs.clear();
+
+   for (std::size_t chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+   {
+      pairs.insert(pairs.end(), chunkPairs[chunkIndex].begin(), chunkPairs[chunkIndex].end());
+   }
+}
+
+std::size_t SweepAndPruneBroadphase::GetNumOverlappingPairs() const
+{
+   return overlappingPairs.size();
+}
+
+std::size_t SweepAndPruneBroadphase::GetNumReinsertions() const
+{
+   return numReinsertions;
+}
+
+float SweepAndPruneBroadphase::EndpointValue(const Endpoint& endpoint, int axis) const
+{
+   const Proxy& proxy = proxies[endpoint.proxyIndex];
+
+   return endpoint.isMin ? proxy.min[axis] : proxy.max[axis];
+}
+
+bool SweepAndPruneBroadphase::FatBoxesOverlap(std::uint32_t proxyIndex1, std::uint32_t proxyIndex2) const
+{
+   const Proxy& proxy1 = proxies[proxyIndex1];
+   const Proxy& proxy2 = proxies[proxyIndex2];
+
+   for (int axis = 0; axis < 3; ++axis)
+   {
+      if ((proxy1.max[axis] <= proxy2.min[axis]) || (proxy2.max[axis] <= proxy1.min[axis]))
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+void SweepAndPruneBroadphase::MakeFatBox(Proxy& proxy) const
+{
+   const Locus::FVector3& center = proxy.body->GetBroadCenter();
+   float radius = proxy.body->GetBroadRadius();
+
+   float extent = radius + Fat_Margin_Fraction * radius + Min_Fat_Margin;
+
+   proxy.min[0] = center.x - extent;
+   proxy.min[1] = center.y - extent;
+   proxy.min[2] = center.z - extent;
+
+   proxy.max[0] = center.x + extent;
+   proxy.max[1] = center.y + extent;
+   proxy.max[2] = center.z + extent;
+}
+
+bool SweepAndPruneBroadphase::FatBoxContains(const Proxy& proxy, const CollisionBody& body) const
+{
+   const Locus::FVector3& center = body.GetBroadCenter();
+   float radius = body.GetBroadRadius();
+
+   return (center.x - radius >= proxy.min[0]) && (center.x + radius <= proxy.max[0]) &&
+          (center.y - radius >= proxy.min[1]) && (center.y + radius <= proxy.max[1]) &&
+          (center.z - radius >= proxy.min[2]) && (center.z + radius <= proxy.max[2]);
+}
+
+std::uint64_t SweepAndPruneBroadphase::MakePairKey(std::uint32_t proxyIndex1, std::uint32_t proxyIndex2)
+{
+   if (proxyIndex1 > proxyIndex2)
+   {
+      std::swap(proxyIndex1, proxyIndex2);
+   }
+
+   return (static_cast<std::uint64_t>(proxyIndex1) << 32) | proxyIndex2;
+}
+
+void SweepAndPruneBroadphase::AddOverlappingPair(std::uint32_t proxyIndex1, std::uint32_t proxyIndex2)
+{
+   std::uint64_t pairKey = MakePairKey(proxyIndex1, proxyIndex2);
+
+   if (overlappingPairIndices.emplace(pairKey, overlappingPairs.size()).second)
+   {
+      overlappingPairs.push_back(pairKey);
+   }
+}
+
+void SweepAndPruneBroadphase::RemoveOverlappingPair(std::uint32_t proxyIndex1, std::uint32_t proxyIndex2)
+{
+   std::unordered_map<std::uint64_t, std::size_t>::iterator pairIter = overlappingPairIndices.find(MakePairKey(proxyIndex1, proxyIndex2));
+
+   if (pairIter == overlappingPairIndices.end())
+   {
+      return;
+   }
+
+   std::size_t pairIndex = pairIter->second;
+
+   overlappingPairIndices.erase(pairIter);
+
+   std::uint64_t lastPairKey = overlappingPairs.back();
+   overlappingPairs.pop_back();
+
+   if (pairIndex < overlappingPairs.size())
+   {
+      overlappingPairs[pairIndex] = lastPairKey;
+      overlappingPairIndices[lastPairKey] = pairIndex;
+   }
+}
+
+void SweepAndPruneBroadphase::RemoveOverlappingPairsOf(std::uint32_t proxyIndex)
+{
+   for (std::size_t pairIndex = overlappingPairs.size(); pairIndex > 0; --pairIndex)
+   {
+      std::uint64_t pairKey = overlappingPairs[pairIndex - 1];
+
+      std::uint32_t proxyIndex1 = static_cast<std::uint32_t>(pairKey >> 32);
+      std::uint32_t proxyIndex2 = static_cast<std::uint32_t>(pairKey);
+
+      if ((proxyIndex1 == proxyIndex) || (proxyIndex2 == proxyIndex))
+      {
+         RemoveOverlappingPair(proxyIndex1, proxyIndex2);
+      }
+   }
+}
+
+void SweepAndPruneBroadphase::PurgeEndpoints()
+{
+   for (int axis = 0; axis < 3; ++axis)
+   {
+      std::vector<Endpoint>& axisEndpoints = endpoints[axis];
+
+      axisEndpoints.erase(std::remove_if(axisEndpoints.begin(), axisEndpoints.end(), [this](const Endpoint& endpoint)
+      {
+         return (proxies[endpoint.proxyIndex].body == nullptr);
+      }), axisEndpoints.end());
+   }
+
+   freeProxyIndices.insert(freeProxyIndices.end(), removedProxyIndices.begin(), removedProxyIndices.end());
+   removedProxyIndices.clear();
+
+   endpointsNeedPurge = false;
+}
+
+void SweepAndPruneBroadphase::SortEndpoints(int axis)
+{
+   std::vector<Endpoint>& axisEndpoints = endpoints[axis];
+   std::size_t numEndpoints = axisEndpoints.size();
+
+   for (std::size_t endpointIndex = 1; endpointIndex < numEndpoints; ++endpointIndex)
+   {
+      Endpoint endpoint = axisEndpoints[endpointIndex];
+      float value = EndpointValue(endpoint, axis);
+
+      std::size_t insertIndex = endpointIndex;
+
+      while (insertIndex > 0)
+      {
+         const Endpoint& previousEndpoint = axisEndpoints[insertIndex - 1];
+
+         if (EndpointValue(previousEndpoint, axis) <= value)
+         {
+            break;
+         }
+
+         if (endpoint.isMin && !previousEndpoint.isMin)
+         {
+            //a box now starts before the other one ends, so they may have begun to overlap
+            if (FatBoxesOverlap(endpoint.proxyIndex, previousEndpoint.proxyIndex))
+            {
+               AddOverlappingPair(endpoint.proxyIndex, previousEndpoint.proxyIndex);
+            }
+         }
+         else if (!endpoint.isMin && previousEndpoint.isMin)
+         {
+            //a box now ends before the other one starts, so they no longer overlap
+            RemoveOverlappingPair(endpoint.proxyIndex, previousEndpoint.proxyIndex);
+         }
+
+         axisEndpoints[insertIndex] = previousEndpoint;
+         --insertIndex;
+      }
+
+      axisEndpoints[insertIndex] = endpoint;
+   }
+}
+
+}
\ No newline at end of file
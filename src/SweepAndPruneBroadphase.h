@@ -0,0 +1,100 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Broadphase.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MPM
+{
+
+//A sweep and prune broadphase that persists from frame to frame. Each body is kept as
+//a fat box, its bounding box grown by a margin, and only moves in the sorted endpoint
+//lists when its bounding box leaves the fat box. The lists stay nearly sorted from one
+//frame to the next, so they are kept sorted by insertion sort, and the overlapping pairs
+//are kept up to date from the endpoints that swap places. The cost of a frame follows
+//how much moved rather than how many bodies there are
+class SweepAndPruneBroadphase : public PairBroadphase
+{
+public:
+   SweepAndPruneBroadphase(WorkerPool& workerPool);
+
+   virtual void Add(CollisionBody* body) override;
+   virtual void Remove(CollisionBody* body) override;
+   virtual void Update(CollisionBody* body) override;
+   virtual void Clear() override;
+
+   virtual void StartAddRemoveBatch() override;
+   virtual void FinishAddRemoveBatch() override;
+
+   virtual void UpdateCollisions() override;
+
+   //the number of pairs whose fat boxes overlap
+   std::size_t GetNumOverlappingPairs() const;
+
+   //the number of bodies whose fat box had to be rebuilt for the last UpdateCollisions
+   std::size_t GetNumReinsertions() const;
+
+private:
+   struct Proxy
+   {
+      CollisionBody* body;
+      float min[3];
+      float max[3];
+   };
+
+   struct Endpoint
+   {
+      std::uint32_t proxyIndex;
+      bool isMin;
+   };
+
+   std::vector<Proxy> proxies;
+   std::vector<std::uint32_t> freeProxyIndices;
+
+   //removed proxies whose endpoints haven't been purged yet, so they can't be reused yet
+   std::vector<std::uint32_t> removedProxyIndices;
+
+   std::vector<Endpoint> endpoints[3];
+
+   //each overlapping pair is a key made of the two proxy indices, smaller one first
+   std::vector<std::uint64_t> overlappingPairs;
+   std::unordered_map<std::uint64_t, std::size_t> overlappingPairIndices;
+
+   std::vector<std::vector<CollisionPair>> chunkPairs;
+
+   bool batching;
+   bool endpointsNeedPurge;
+   bool endpointsNeedSort;
+
+   std::size_t numReinsertions;
+   std::size_t numPendingReinsertions;
+
+   float EndpointValue(const Endpoint& endpoint, int axis) const;
+   bool FatBoxesOverlap(std::uint32_t proxyIndex1, std::uint32_t proxyIndex2) const;
+   void MakeFatBox(Proxy& proxy) const;
+   bool FatBoxContains(const Proxy& proxy, const CollisionBody& body) const;
+
+   static std::uint64_t MakePairKey(std::uint32_t proxyIndex1, std::uint32_t proxyIndex2);
+   void AddOverlappingPair(std::uint32_t proxyIndex1, std::uint32_t proxyIndex2);
+   void RemoveOverlappingPair(std::uint32_t proxyIndex1, std::uint32_t proxyIndex2);
+   void RemoveOverlappingPairsOf(std::uint32_t proxyIndex);
+
+   void PurgeEndpoints();
+   void SortEndpoints(int axis);
+};
+
+}
\ No newline at end of file
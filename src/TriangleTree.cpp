@@ -0,0 +1,901 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "TriangleTree.h"
+#include "NarrowphaseScratch.h"
+
+#include "Locus/Geometry/Vector3Geometry.h"
+
+#include <algorithm>
+
+#include <cmath>
+
+namespace MPM
+{
+
+static const std::size_t Max_Triangles_Per_Leaf = 4;
+
+//how close to a cut, relative to the size of the model, a point has to be to count as on it
+static const float Relative_Cut_Tolerance = 1e-4f;
+
+//an axis built from two vectors this close to parallel is too short to project onto
+static const float Parallel_Tolerance = 1e-10f;
+
+static float Component(const Locus::FVector3& vector, int axis)
+{
+   return (axis == 0) ? vector.x : ((axis == 1) ? vector.y : vector.z);
+}
+
+static Locus::FVector3 Centroid(const Locus::Triangle3D_t& triangle)
+{
+   return (triangle[0] + triangle[1] + triangle[2]) / 3.0f;
+}
+
+//bounds the triangles' points with the sphere around their box
+static void BoundTriangles(std::vector<Locus::Triangle3D_t>::const_iterator begin, std::vector<Locus::Triangle3D_t>::const_iterator end,
+                           Locus::FVector3& minPoint, Locus::FVector3& maxPoint, Locus::FVector3& center, float& radius)
+{
+   minPoint = (*begin)[0];
+   maxPoint = minPoint;
+
+   for (std::vector<Locus::Triangle3D_t>::const_iterator triangle = begin; triangle != end; ++triangle)
+   {
+      for (std::size_t pointIndex = 0; pointIndex < Locus::Triangle3D_t::NumPointsOnATriangle; ++pointIndex)
+      {
+         const Locus::FVector3& point = (*triangle)[pointIndex];
+
+         minPoint = Locus::FVector3(std::min(minPoint.x, point.x), std::min(minPoint.y, point.y), std::min(minPoint.z, point.z));
+         maxPoint = Locus::FVector3(std::max(maxPoint.x, point.x), std::max(maxPoint.y, point.y), std::max(maxPoint.z, point.z));
+      }
+   }
+
+   center = (minPoint + maxPoint) / 2.0f;
+   radius = 0.0f;
+
+   for (std::vector<Locus::Triangle3D_t>::const_iterator triangle = begin; triangle != end; ++triangle)
+   {
+      for (std::size_t pointIndex = 0; pointIndex < Locus::Triangle3D_t::NumPointsOnATriangle; ++pointIndex)
+      {
+         radius = std::max(radius, DistanceBetween(center, (*triangle)[pointIndex]));
+      }
+   }
+}
+
+static void BoundTriangle(const Locus::Triangle3D_t& triangle, Locus::FVector3& minPoint, Locus::FVector3& maxPoint)
+{
+   minPoint = Locus::FVector3(std::min(std::min(triangle[0].x, triangle[1].x), triangle[2].x),
+                              std::min(std::min(triangle[0].y, triangle[1].y), triangle[2].y),
+                              std::min(std::min(triangle[0].z, triangle[1].z), triangle[2].z));
+
+   maxPoint = Locus::FVector3(std::max(std::max(triangle[0].x, triangle[1].x), triangle[2].x),
+                              std::max(std::max(triangle[0].y, triangle[1].y), triangle[2].y),
+                              std::max(std::max(triangle[0].z, triangle[1].z), triangle[2].z));
+}
+
+//true if the span of a, b and c overlaps the span from min to max
+static bool SpansOverlap(float a, float b, float c, float min, float max)
+{
+   return (std::min(std::min(a, b), c) <= max) & (std::max(std::max(a, b), c) >= min);
+}
+
+static int LongestAxis(const Locus::FVector3& extent)
+{
+   return (extent.x >= extent.y) ? ((extent.x >= extent.z) ? 0 : 2) : ((extent.y >= extent.z) ? 1 : 2);
+}
+
+static void ProjectOnto(const Locus::Triangle3D_t& triangle, const Locus::FVector3& axis, float& min, float& max)
+{
+   min = max = Dot(triangle[0], axis);
+
+   for (std::size_t pointIndex = 1; pointIndex < Locus::Triangle3D_t::NumPointsOnATriangle; ++pointIndex)
+   {
+      float projection = Dot(triangle[pointIndex], axis);
+
+      min = std::min(min, projection);
+      max = std::max(max, projection);
+   }
+}
+
+//true if the axis normal to v1 and v2 separates the triangles
+static bool Separates(const Locus::Triangle3D_t& triangle1, const Locus::Triangle3D_t& triangle2, const Locus::FVector3& v1, const Locus::FVector3& v2)
+{
+   Locus::FVector3 axis = Cross(v1, v2);
+
+   if (SquaredNorm(axis) <= Parallel_Tolerance * SquaredNorm(v1) * SquaredNorm(v2))
+   {
+      return false;
+   }
+
+   float min1, max1, min2, max2;
+
+   ProjectOnto(triangle1, axis, min1, max1);
+   ProjectOnto(triangle2, axis, min2, max2);
+
+   return (max1 < min2) || (max2 < min1);
+}
+
+//how far along the segment from start (0) to end (1) it enters the sphere
+static bool SegmentEntersSphere(const Locus::FVector3& start, const Locus::FVector3& segment, const Locus::FVector3& center, float radius, float& fraction)
+{
+   Locus::FVector3 centerToStart = start - center;
+
+   float c = SquaredNorm(centerToStart) - radius * radius;
+
+   if (c <= 0.0f)
+   {
+      fraction = 0.0f;
+      return true;
+   }
+
+   float a = SquaredNorm(segment);
+   float b = Dot(centerToStart, segment);
+
+   if ((b >= 0.0f) || (a == 0.0f))
+   {
+      return false;
+   }
+
+   float discriminant = b * b - a * c;
+
+   if (discriminant < 0.0f)
+   {
+      return false;
+   }
+
+   fraction = (-b - std::sqrt(discriminant)) / a;
+
+   return (fraction <= 1.0f);
+}
+
+//how far along the segment from start (0) to end (1) it crosses the triangle
+static bool SegmentCrossesTriangle(const Locus::FVector3& start, const Locus::FVector3& segment, const Locus::Triangle3D_t& triangle, float& fraction)
+{
+   Locus::FVector3 edge1 = triangle[1] - triangle[0];
+   Locus::FVector3 edge2 = triangle[2] - triangle[0];
+
+   Locus::FVector3 p = Cross(segment, edge2);
+
+   float determinant = Dot(edge1, p);
+
+   if (determinant == 0.0f)
+   {
+      return false;
+   }
+
+   float inverseDeterminant = 1.0f / determinant;
+
+   Locus::FVector3 fromFirstPoint = start - triangle[0];
+
+   float u = Dot(fromFirstPoint, p) * inverseDeterminant;
+
+   if ((u < 0.0f) || (u > 1.0f))
+   {
+      return false;
+   }
+
+   Locus::FVector3 q = Cross(fromFirstPoint, edge1);
+
+   float v = Dot(segment, q) * inverseDeterminant;
+
+   if ((v < 0.0f) || (u + v > 1.0f))
+   {
+      return false;
+   }
+
+   fraction = Dot(edge2, q) * inverseDeterminant;
+
+   return (fraction >= 0.0f) && (fraction <= 1.0f);
+}
+
+//how far along the segment from start (0) to end (1) it comes within radius of the side of
+//the edge from point1 to point2. Its ends are left to the spheres around the points
+static bool SegmentEntersCylinder(const Locus::FVector3& start, const Locus::FVector3& segment, const Locus::FVector3& point1, const Locus::FVector3& point2,
+                                  float radius, float& fraction)
+{
+   Locus::FVector3 axis = point2 - point1;
+
+   float axisSquaredLength = SquaredNorm(axis);
+
+   if (axisSquaredLength == 0.0f)
+   {
+      return false;
+   }
+
+   //the same as entering a sphere, with the start and the segment projected off of the axis
+
+   Locus::FVector3 fromPoint1 = start - point1;
+
+   Locus::FVector3 offAxis = fromPoint1 - (Dot(fromPoint1, axis) / axisSquaredLength) * axis;
+   Locus::FVector3 segmentOffAxis = segment - (Dot(segment, axis) / axisSquaredLength) * axis;
+
+   float c = SquaredNorm(offAxis) - radius * radius;
+
+   if (c <= 0.0f)
+   {
+      fraction = 0.0f;
+   }
+   else
+   {
+      float a = SquaredNorm(segmentOffAxis);
+      float b = Dot(offAxis, segmentOffAxis);
+
+      if ((b >= 0.0f) || (a == 0.0f))
+      {
+         return false;
+      }
+
+      float discriminant = b * b - a * c;
+
+      if (discriminant < 0.0f)
+      {
+         return false;
+      }
+
+      fraction = (-b - std::sqrt(discriminant)) / a;
+
+      if (fraction > 1.0f)
+      {
+         return false;
+      }
+   }
+
+   float alongAxis = Dot(fromPoint1 + fraction * segment, axis);
+
+   return (alongAxis >= 0.0f) && (alongAxis <= axisSquaredLength);
+}
+
+//how far along the segment from start (0) to end (1) it comes within radius of the triangle's
+//face. Near its edges the cylinders around them are reached first
+static bool SegmentEntersSlab(const Locus::FVector3& start, const Locus::FVector3& segment, const Locus::Triangle3D_t& triangle, float radius, float& fraction)
+{
+   Locus::FVector3 edges[3] = { triangle[1] - triangle[0], triangle[2] - triangle[1], triangle[0] - triangle[2] };
+
+   Locus::FVector3 normal = Cross(edges[0], edges[1]);
+
+   float normalLength = Norm(normal);
+
+   if (normalLength == 0.0f)
+   {
+      return false;
+   }
+
+   normal /= normalLength;
+
+   float startDistance = Dot(start - triangle[0], normal);
+   float segmentDistance = Dot(segment, normal);
+
+   if (std::abs(startDistance) <= radius)
+   {
+      fraction = 0.0f;
+   }
+   else if ((startDistance > 0.0f) && (segmentDistance < 0.0f))
+   {
+      fraction = (startDistance - radius) / -segmentDistance;
+   }
+   else if ((startDistance < 0.0f) && (segmentDistance > 0.0f))
+   {
+      fraction = (-radius - startDistance) / segmentDistance;
+   }
+   else
+   {
+      return false;
+   }
+
+   if (fraction > 1.0f)
+   {
+      return false;
+   }
+
+   //the point on the face nearest where the segment enters has to be inside the triangle
+   Locus::FVector3 point = start + fraction * segment;
+   point -= Dot(point - triangle[0], normal) * normal;
+
+   for (int edgeIndex = 0; edgeIndex < 3; ++edgeIndex)
+   {
+      if (Dot(Cross(edges[edgeIndex], point - triangle[edgeIndex]), normal) < 0.0f)
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+//how far along the segment from start (0) to end (1) a sphere of the radius moving along it
+//first touches the triangle. The points within radius of the triangle are the slab over its
+//face, the cylinders around its edges and the spheres around its points, so the sphere
+//touches the triangle where the segment first enters one of them
+static bool SegmentComesWithin(const Locus::FVector3& start, const Locus::FVector3& segment, const Locus::Triangle3D_t& triangle, float radius, float& fraction)
+{
+   if (radius <= 0.0f)
+   {
+      return SegmentCrossesTriangle(start, segment, triangle, fraction);
+   }
+
+   bool within = false;
+   fraction = 1.0f;
+
+   float partFraction;
+
+   if (SegmentEntersSlab(start, segment, triangle, radius, partFraction))
+   {
+      within = true;
+      fraction = partFraction;
+   }
+
+   for (std::size_t pointIndex = 0; pointIndex < Locus::Triangle3D_t::NumPointsOnATriangle; ++pointIndex)
+   {
+      const Locus::FVector3& point = triangle[pointIndex];
+      const Locus::FVector3& nextPoint = triangle[(pointIndex + 1) % Locus::Triangle3D_t::NumPointsOnATriangle];
+
+      if (SegmentEntersSphere(start, segment, point, radius, partFraction) && (partFraction <= fraction))
+      {
+         within = true;
+         fraction = partFraction;
+      }
+
+      if (SegmentEntersCylinder(start, segment, point, nextPoint, radius, partFraction) && (partFraction <= fraction))
+      {
+         within = true;
+         fraction = partFraction;
+      }
+   }
+
+   return within;
+}
+
+bool TrianglesIntersect(const Locus::Triangle3D_t& triangle1, const Locus::Triangle3D_t& triangle2)
+{
+   const Locus::FVector3 edges1[3] = { triangle1[1] - triangle1[0], triangle1[2] - triangle1[1], triangle1[0] - triangle1[2] };
+   const Locus::FVector3 edges2[3] = { triangle2[1] - triangle2[0], triangle2[2] - triangle2[1], triangle2[0] - triangle2[2] };
+
+   //face normals, then every pair of edges
+
+   if (Separates(triangle1, triangle2, edges1[0], edges1[1]) || Separates(triangle1, triangle2, edges2[0], edges2[1]))
+   {
+      return false;
+   }
+
+   for (int edgeIndex1 = 0; edgeIndex1 < 3; ++edgeIndex1)
+   {
+      for (int edgeIndex2 = 0; edgeIndex2 < 3; ++edgeIndex2)
+      {
+         if (Separates(triangle1, triangle2, edges1[edgeIndex1], edges2[edgeIndex2]))
+         {
+            return false;
+         }
+      }
+   }
+
+   //coplanar triangles can only be separated by an axis in their plane
+
+   Locus::FVector3 normal1 = Cross(edges1[0], edges1[1]);
+   Locus::FVector3 normal2 = Cross(edges2[0], edges2[1]);
+
+   if (SquaredNorm(Cross(normal1, normal2)) <= Parallel_Tolerance * SquaredNorm(normal1) * SquaredNorm(normal2))
+   {
+      for (int edgeIndex = 0; edgeIndex < 3; ++edgeIndex)
+      {
+         if (Separates(triangle1, triangle2, normal1, edges1[edgeIndex]) || Separates(triangle1, triangle2, normal1, edges2[edgeIndex]))
+         {
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+bool TriangleTree::Node::IsLeaf() const
+{
+   //the root is never anyone's child
+   return (firstChild == 0);
+}
+
+std::size_t TriangleTree::NumTriangles() const
+{
+   return pointsX[0].size();
+}
+
+Locus::Triangle3D_t TriangleTree::GetTriangle(std::size_t index) const
+{
+   return Locus::Triangle3D_t(Locus::FVector3(pointsX[0][index], pointsY[0][index], pointsZ[0][index]),
+                              Locus::FVector3(pointsX[1][index], pointsY[1][index], pointsZ[1][index]),
+                              Locus::FVector3(pointsX[2][index], pointsY[2][index], pointsZ[2][index]));
+}
+
+void TriangleTree::Build(std::vector<Locus::Triangle3D_t>& triangles, unsigned int maxDepth)
+{
+   nodes.clear();
+
+   if (triangles.size() > 0)
+   {
+      nodes.reserve(2 * triangles.size());
+      nodes.push_back(Node());
+
+      BuildNode(triangles, 0, 0, triangles.size(), maxDepth);
+   }
+
+   StoreTriangles(triangles);
+}
+
+void TriangleTree::StoreTriangles(const std::vector<Locus::Triangle3D_t>& triangles)
+{
+   for (std::size_t pointIndex = 0; pointIndex < Locus::Triangle3D_t::NumPointsOnATriangle; ++pointIndex)
+   {
+      pointsX[pointIndex].resize(triangles.size());
+      pointsY[pointIndex].resize(triangles.size());
+      pointsZ[pointIndex].resize(triangles.size());
+
+      for (std::size_t triangleIndex = 0; triangleIndex < triangles.size(); ++triangleIndex)
+      {
+         const Locus::FVector3& point = triangles[triangleIndex][pointIndex];
+
+         pointsX[pointIndex][triangleIndex] = point.x;
+         pointsY[pointIndex][triangleIndex] = point.y;
+         pointsZ[pointIndex][triangleIndex] = point.z;
+      }
+   }
+}
+
+void TriangleTree::FindBoxCandidates(std::uint32_t firstTriangle, std::uint32_t numTriangles, const Locus::FVector3& minPoint, const Locus::FVector3& maxPoint,
+                                     NarrowphaseScratch& scratch) const
+{
+   std::vector<std::uint32_t>& candidates = scratch.triangleCandidates;
+
+   scratch.Resize(candidates, numTriangles);
+
+   const float* x0 = pointsX[0].data() + firstTriangle;
+   const float* x1 = pointsX[1].data() + firstTriangle;
+   const float* x2 = pointsX[2].data() + firstTriangle;
+   const float* y0 = pointsY[0].data() + firstTriangle;
+   const float* y1 = pointsY[1].data() + firstTriangle;
+   const float* y2 = pointsY[2].data() + firstTriangle;
+   const float* z0 = pointsZ[0].data() + firstTriangle;
+   const float* z1 = pointsZ[1].data() + firstTriangle;
+   const float* z2 = pointsZ[2].data() + firstTriangle;
+
+   //every triangle is written, and the count only moves past the ones that overlap, so the
+   //loop doesn't branch
+   std::size_t numCandidates = 0;
+
+   for (std::uint32_t offset = 0; offset < numTriangles; ++offset)
+   {
+      bool overlaps = SpansOverlap(x0[offset], x1[offset], x2[offset], minPoint.x, maxPoint.x) &
+                      SpansOverlap(y0[offset], y1[offset], y2[offset], minPoint.y, maxPoint.y) &
+                      SpansOverlap(z0[offset], z1[offset], z2[offset], minPoint.z, maxPoint.z);
+
+      candidates[numCandidates] = firstTriangle + offset;
+      numCandidates += overlaps ? 1 : 0;
+   }
+
+   candidates.resize(numCandidates);
+}
+
+void TriangleTree::BuildNode(std::vector<Locus::Triangle3D_t>& triangles, std::size_t nodeIndex, std::size_t firstTriangle, std::size_t numTriangles, unsigned int depthLeft)
+{
+   std::vector<Locus::Triangle3D_t>::iterator begin = triangles.begin() + firstTriangle;
+   std::vector<Locus::Triangle3D_t>::iterator end = begin + numTriangles;
+
+   Locus::FVector3 minPoint, maxPoint, center;
+   float radius;
+
+   BoundTriangles(begin, end, minPoint, maxPoint, center, radius);
+
+   Node& node = nodes[nodeIndex];
+
+   node.center = center;
+   node.radius = radius;
+   node.firstChild = 0;
+   node.firstTriangle = static_cast<std::uint32_t>(firstTriangle);
+   node.numTriangles = static_cast<std::uint32_t>(numTriangles);
+
+   if ((numTriangles <= Max_Triangles_Per_Leaf) || (depthLeft == 0))
+   {
+      return;
+   }
+
+   //split at the median centroid along the longest side of the box
+
+   int axis = LongestAxis(maxPoint - minPoint);
+
+   std::size_t numLeftTriangles = numTriangles / 2;
+
+   std::nth_element(begin, begin + numLeftTriangles, end, [axis](const Locus::Triangle3D_t& triangle1, const Locus::Triangle3D_t& triangle2)
+   {
+      return Component(Centroid(triangle1), axis) < Component(Centroid(triangle2), axis);
+   });
+
+   std::size_t firstChild = nodes.size();
+
+   nodes[nodeIndex].firstChild = static_cast<std::uint32_t>(firstChild);
+
+   nodes.push_back(Node());
+   nodes.push_back(Node());
+
+   BuildNode(triangles, firstChild, firstTriangle, numLeftTriangles, depthLeft - 1);
+   BuildNode(triangles, firstChild + 1, firstTriangle + numLeftTriangles, numTriangles - numLeftTriangles, depthLeft - 1);
+}
+
+float TriangleTree::CutTolerance(const TriangleTree& parent, const ModelFrame& parentToHalf)
+{
+   return parent.nodes.empty() ? 0.0f : Relative_Cut_Tolerance * parent.nodes[0].radius * parentToHalf.GetLargestScale();
+}
+
+float TriangleTree::DistanceInFront(const Locus::Triangle3D_t& triangle, const Locus::FVector3& cutNormal, float cutDistance)
+{
+   float distance = Dot(cutNormal, triangle[0]);
+
+   for (std::size_t pointIndex = 1; pointIndex < Locus::Triangle3D_t::NumPointsOnATriangle; ++pointIndex)
+   {
+      distance = std::min(distance, Dot(cutNormal, triangle[pointIndex]));
+   }
+
+   return distance - cutDistance;
+}
+
+void TriangleTree::BuildFromSplit(const TriangleTree& parent, const ModelFrame& parentToHalf, const Locus::FVector3& cutNormal, float cutDistance,
+                                  float tolerance, std::vector<Locus::Triangle3D_t>& cutTriangles, unsigned int maxDepth)
+{
+   nodes.clear();
+
+   float scale = parentToHalf.GetLargestScale();
+
+   //walk down parent's tree, keeping the subtrees wholly in front of the cut, dropping the
+   //ones wholly behind it and picking the triangles in front out of the leaves it crosses
+
+   std::vector<SplitPiece> pieces;
+   std::vector<std::uint32_t> stack;
+
+   if (!parent.nodes.empty())
+   {
+      stack.push_back(0);
+   }
+
+   while (!stack.empty())
+   {
+      std::uint32_t parentNodeIndex = stack.back();
+      stack.pop_back();
+
+      const Node& parentNode = parent.nodes[parentNodeIndex];
+
+      SplitPiece piece;
+
+      piece.center = parentToHalf.ToWorld(parentNode.center);
+      piece.radius = parentNode.radius * scale;
+      piece.parentNode = parentNodeIndex;
+
+      float distance = Dot(cutNormal, piece.center) - cutDistance;
+
+      if (distance - piece.radius > tolerance)
+      {
+         pieces.push_back(piece);
+      }
+      else if (distance + piece.radius <= tolerance)
+      {
+         continue;
+      }
+      else if (parentNode.IsLeaf())
+      {
+         for (std::uint32_t index = parentNode.firstTriangle; index < parentNode.firstTriangle + parentNode.numTriangles; ++index)
+         {
+            Locus::Triangle3D_t parentTriangle = parent.GetTriangle(index);
+            Locus::Triangle3D_t triangle(parentToHalf.ToWorld(parentTriangle[0]), parentToHalf.ToWorld(parentTriangle[1]), parentToHalf.ToWorld(parentTriangle[2]));
+
+            if (DistanceInFront(triangle, cutNormal, cutDistance) > tolerance)
+            {
+               cutTriangles.push_back(triangle);
+            }
+         }
+      }
+      else
+      {
+         stack.push_back(parentNode.firstChild);
+         stack.push_back(parentNode.firstChild + 1);
+      }
+   }
+
+   if (!cutTriangles.empty())
+   {
+      SplitPiece piece;
+
+      Locus::FVector3 minPoint, maxPoint;
+      BoundTriangles(cutTriangles.begin(), cutTriangles.end(), minPoint, maxPoint, piece.center, piece.radius);
+
+      piece.parentNode = SplitPiece::Rebuilt_Node;
+
+      pieces.push_back(piece);
+   }
+
+   std::vector<Locus::Triangle3D_t> triangles;
+
+   if (!pieces.empty())
+   {
+      nodes.reserve(2 * (parent.NumTriangles() + cutTriangles.size()));
+      nodes.push_back(Node());
+
+      triangles.reserve(parent.NumTriangles() + cutTriangles.size());
+
+      BuildOverPieces(pieces, 0, pieces.size(), 0, parent, parentToHalf, cutTriangles, triangles, maxDepth);
+   }
+
+   StoreTriangles(triangles);
+}
+
+void TriangleTree::BuildOverPieces(std::vector<SplitPiece>& pieces, std::size_t firstPiece, std::size_t numPieces, std::size_t nodeIndex,
+                                   const TriangleTree& parent, const ModelFrame& parentToHalf, std::vector<Locus::Triangle3D_t>& cutTriangles,
+                                   std::vector<Locus::Triangle3D_t>& triangles, unsigned int maxDepth)
+{
+   std::vector<SplitPiece>::iterator begin = pieces.begin() + firstPiece;
+   std::vector<SplitPiece>::iterator end = begin + numPieces;
+
+   if (numPieces == 1)
+   {
+      if (begin->parentNode == SplitPiece::Rebuilt_Node)
+      {
+         std::size_t firstTriangle = triangles.size();
+
+         triangles.insert(triangles.end(), cutTriangles.begin(), cutTriangles.end());
+
+         BuildNode(triangles, nodeIndex, firstTriangle, cutTriangles.size(), maxDepth);
+      }
+      else
+      {
+         CopySubtree(parent, begin->parentNode, parentToHalf, parentToHalf.GetLargestScale(), nodeIndex, triangles);
+      }
+
+      return;
+   }
+
+   //the same median split as for triangles, on the centers of the pieces
+
+   Locus::FVector3 minPoint = begin->center;
+   Locus::FVector3 maxPoint = minPoint;
+
+   for (std::vector<SplitPiece>::iterator piece = begin; piece != end; ++piece)
+   {
+      minPoint = Locus::FVector3(std::min(minPoint.x, piece->center.x), std::min(minPoint.y, piece->center.y), std::min(minPoint.z, piece->center.z));
+      maxPoint = Locus::FVector3(std::max(maxPoint.x, piece->center.x), std::max(maxPoint.y, piece->center.y), std::max(maxPoint.z, piece->center.z));
+   }
+
+   Locus::FVector3 center = (minPoint + maxPoint) / 2.0f;
+   float radius = 0.0f;
+
+   for (std::vector<SplitPiece>::iterator piece = begin; piece != end; ++piece)
+   {
+      radius = std::max(radius, DistanceBetween(center, piece->center) + piece->radius);
+   }
+
+   int axis = LongestAxis(maxPoint - minPoint);
+
+   std::size_t numLeftPieces = numPieces / 2;
+
+   std::nth_element(begin, begin + numLeftPieces, end, [axis](const SplitPiece& piece1, const SplitPiece& piece2)
+   {
+      return Component(piece1.center, axis) < Component(piece2.center, axis);
+   });
+
+   std::size_t firstChild = nodes.size();
+   std::size_t firstTriangle = triangles.size();
+
+   nodes.push_back(Node());
+   nodes.push_back(Node());
+
+   BuildOverPieces(pieces, firstPiece, numLeftPieces, firstChild, parent, parentToHalf, cutTriangles, triangles, maxDepth);
+   BuildOverPieces(pieces, firstPiece + numLeftPieces, numPieces - numLeftPieces, firstChild + 1, parent, parentToHalf, cutTriangles, triangles, maxDepth);
+
+   Node& node = nodes[nodeIndex];
+
+   node.center = center;
+   node.radius = radius;
+   node.firstChild = static_cast<std::uint32_t>(firstChild);
+   node.firstTriangle = static_cast<std::uint32_t>(firstTriangle);
+   node.numTriangles = static_cast<std::uint32_t>(triangles.size() - firstTriangle);
+}
+
+void TriangleTree::CopySubtree(const TriangleTree& parent, std::size_t parentNode, const ModelFrame& parentToHalf, float scale,
+                               std::size_t nodeIndex, std::vector<Locus::Triangle3D_t>& triangles)
+{
+   const Node& source = parent.nodes[parentNode];
+
+   std::size_t firstChild = 0;
+   std::size_t firstTriangle = triangles.size();
+
+   if (source.IsLeaf())
+   {
+      for (std::uint32_t index = source.firstTriangle; index < source.firstTriangle + source.numTriangles; ++index)
+      {
+         Locus::Triangle3D_t parentTriangle = parent.GetTriangle(index);
+
+         triangles.push_back( Locus::Triangle3D_t(parentToHalf.ToWorld(parentTriangle[0]), parentToHalf.ToWorld(parentTriangle[1]), parentToHalf.ToWorld(parentTriangle[2])) );
+      }
+   }
+   else
+   {
+      firstChild = nodes.size();
+
+      nodes.push_back(Node());
+      nodes.push_back(Node());
+
+      CopySubtree(parent, source.firstChild, parentToHalf, scale, firstChild, triangles);
+      CopySubtree(parent, source.firstChild + 1, parentToHalf, scale, firstChild + 1, triangles);
+   }
+
+   Node& node = nodes[nodeIndex];
+
+   node.center = parentToHalf.ToWorld(source.center);
+   node.radius = source.radius * scale;
+   node.firstChild = static_cast<std::uint32_t>(firstChild);
+   node.firstTriangle = static_cast<std::uint32_t>(firstTriangle);
+   node.numTriangles = static_cast<std::uint32_t>(triangles.size() - firstTriangle);
+}
+
+bool TriangleTree::GetIntersection(const ModelFrame& thisFrame, const TriangleTree& other, const ModelFrame& otherFrame,
+                                   NarrowphaseScratch& scratch, Locus::Triangle3D_t& thisTriangle, Locus::Triangle3D_t& otherTriangle) const
+{
+   scratch.CountQuery();
+
+   if (nodes.empty() || other.nodes.empty())
+   {
+      return false;
+   }
+
+   //everything is tested in this tree's model space
+
+   ModelFrame otherToThis = ModelFrame::Relative(otherFrame, thisFrame);
+   float otherScale = otherToThis.GetLargestScale();
+
+   std::vector<NarrowphaseScratch::IndexPair>& stack = scratch.nodePairStack;
+
+   stack.clear();
+   scratch.Push(stack, NarrowphaseScratch::IndexPair(0, 0));
+
+   while (!stack.empty())
+   {
+      NarrowphaseScratch::IndexPair nodePair = stack.back();
+      stack.pop_back();
+
+      const Node& thisNode = nodes[nodePair.first];
+      const Node& otherNode = other.nodes[nodePair.second];
+
+      float otherRadius = otherNode.radius * otherScale;
+      float radiusSum = thisNode.radius + otherRadius;
+
+      if (SquaredNorm(thisNode.center - otherToThis.ToWorld(otherNode.center)) > radiusSum * radiusSum)
+      {
+         continue;
+      }
+
+      if (thisNode.IsLeaf() && otherNode.IsLeaf())
+      {
+         for (std::uint32_t otherIndex = otherNode.firstTriangle; otherIndex < otherNode.firstTriangle + otherNode.numTriangles; ++otherIndex)
+         {
+            Locus::Triangle3D_t otherModelTriangle = other.GetTriangle(otherIndex);
+
+            otherTriangle = Locus::Triangle3D_t(otherToThis.ToWorld(otherModelTriangle[0]), otherToThis.ToWorld(otherModelTriangle[1]), otherToThis.ToWorld(otherModelTriangle[2]));
+
+            Locus::FVector3 minPoint, maxPoint;
+            BoundTriangle(otherTriangle, minPoint, maxPoint);
+
+            FindBoxCandidates(thisNode.firstTriangle, thisNode.numTriangles, minPoint, maxPoint, scratch);
+
+            for (std::uint32_t thisIndex : scratch.triangleCandidates)
+            {
+               thisTriangle = GetTriangle(thisIndex);
+
+               if (TrianglesIntersect(thisTriangle, otherTriangle))
+               {
+                  thisTriangle = Locus::Triangle3D_t(thisFrame.ToWorld(thisTriangle[0]), thisFrame.ToWorld(thisTriangle[1]), thisFrame.ToWorld(thisTriangle[2]));
+                  otherTriangle = Locus::Triangle3D_t(thisFrame.ToWorld(otherTriangle[0]), thisFrame.ToWorld(otherTriangle[1]), thisFrame.ToWorld(otherTriangle[2]));
+
+                  return true;
+               }
+            }
+         }
+      }
+      else if (otherNode.IsLeaf() || (!thisNode.IsLeaf() && (thisNode.radius >= otherRadius)))
+      {
+         scratch.Push(stack, NarrowphaseScratch::IndexPair(thisNode.firstChild, nodePair.second));
+         scratch.Push(stack, NarrowphaseScratch::IndexPair(thisNode.firstChild + 1, nodePair.second));
+      }
+      else
+      {
+         scratch.Push(stack, NarrowphaseScratch::IndexPair(nodePair.first, otherNode.firstChild));
+         scratch.Push(stack, NarrowphaseScratch::IndexPair(nodePair.first, otherNode.firstChild + 1));
+      }
+   }
+
+   return false;
+}
+
+bool TriangleTree::GetFirstHit(const ModelFrame& frame, const Locus::FVector3& start, const Locus::FVector3& end, float radius,
+                               NarrowphaseScratch& scratch, std::size_t& hitTriangle, float& hitFraction) const
+{
+   scratch.CountQuery();
+
+   if (nodes.empty())
+   {
+      return false;
+   }
+
+   //cast the segment in model space, where the tree is. Fractions along it are the same in both spaces
+
+   Locus::FVector3 modelStart = frame.ToModel(start);
+   Locus::FVector3 segment = frame.VectorToModel(end - start);
+
+   float modelRadius = radius / frame.GetLargestScale();
+
+   //the box around the whole cast. Triangles outside of it can't be touched
+
+   Locus::FVector3 modelEnd = modelStart + segment;
+   Locus::FVector3 reach(modelRadius, modelRadius, modelRadius);
+
+   Locus::FVector3 minPoint = Locus::FVector3(std::min(modelStart.x, modelEnd.x), std::min(modelStart.y, modelEnd.y), std::min(modelStart.z, modelEnd.z)) - reach;
+   Locus::FVector3 maxPoint = Locus::FVector3(std::max(modelStart.x, modelEnd.x), std::max(modelStart.y, modelEnd.y), std::max(modelStart.z, modelEnd.z)) + reach;
+
+   bool hit = false;
+   hitFraction = 1.0f;
+
+   std::vector<std::uint32_t>& stack = scratch.nodeStack;
+
+   stack.clear();
+   scratch.Push<std::uint32_t>(stack, 0);
+
+   while (!stack.empty())
+   {
+      const Node& node = nodes[stack.back()];
+      stack.pop_back();
+
+      float entryFraction;
+
+      if (!SegmentEntersSphere(modelStart, segment, node.center, node.radius + modelRadius, entryFraction) || (entryFraction > hitFraction))
+      {
+         continue;
+      }
+
+      if (node.IsLeaf())
+      {
+         FindBoxCandidates(node.firstTriangle, node.numTriangles, minPoint, maxPoint, scratch);
+
+         for (std::uint32_t index : scratch.triangleCandidates)
+         {
+            float fraction;
+
+            if (SegmentComesWithin(modelStart, segment, GetTriangle(index), modelRadius, fraction) && (fraction <= hitFraction))
+            {
+               hit = true;
+               hitTriangle = index;
+               hitFraction = fraction;
+            }
+         }
+      }
+      else
+      {
+         //visit the child nearer the start first, so that hits in it prune the other
+         const Node& firstChild = nodes[node.firstChild];
+         const Node& secondChild = nodes[node.firstChild + 1];
+
+         if (Dot(firstChild.center - modelStart, segment) <= Dot(secondChild.center - modelStart, segment))
+         {
+            scratch.Push(stack, node.firstChild + 1);
+            scratch.Push(stack, node.firstChild);
+         }
+         else
+         {
+            scratch.Push(stack, node.firstChild);
+            scratch.Push(stack, node.firstChild + 1);
+         }
+      }
+   }
+
+   return hit;
+}
+
+}
\ No newline at end of file
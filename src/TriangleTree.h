@@ -0,0 +1,171 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include "Locus/Math/Vectors.h"
+
+#include "Locus/Geometry/Triangle.h"
+#include "Locus/Geometry/Transformation.h"
+
+#include "ModelFrame.h"
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MPM
+{
+
+class NarrowphaseScratch;
+
+//A sphere tree over the faces of a model, built once in model space and queried with the
+//model's current frame. Queries bring what they test into the tree's model space rather
+//than moving the tree's triangles out of it, and they write into a NarrowphaseScratch
+//instead of collecting face indices in sets of their own, so they don't allocate
+class TriangleTree
+{
+public:
+   template <class ModelType>
+   TriangleTree(const ModelType& model, unsigned int maxDepth)
+   {
+      std::size_t numFaces = model.NumFaces();
+
+      std::vector<Locus::Triangle3D_t> triangles;
+      triangles.reserve(numFaces);
+
+      for (std::size_t faceIndex = 0; faceIndex < numFaces; ++faceIndex)
+      {
+         triangles.push_back( model.GetFaceTriangle(faceIndex, Locus::Transformation::Identity()) );
+      }
+
+      Build(triangles, maxDepth);
+   }
+
+   //the tree of half, the part of a model in front of a cut, given parent, the tree of the
+   //whole model. Subtrees of parent wholly in front of the cut are kept as they are, so only
+   //the triangles near the cut are sorted again and the work follows the size of the cut.
+   //parentToHalf takes parent's model space to half's, where the cut is the plane of points
+   //p with Dot(cutNormal, p) == cutDistance and cutNormal is a unit vector
+   template <class ModelType>
+   TriangleTree(const TriangleTree& parent, const ModelFrame& parentToHalf, const Locus::FVector3& cutNormal, float cutDistance,
+                const ModelType& half, unsigned int maxDepth)
+   {
+      float tolerance = CutTolerance(parent, parentToHalf);
+
+      //the triangles the cut made or changed. Triangles of parent that reach this close to
+      //the cut are taken from here too, so the two sets overlap rather than leave a gap
+      std::vector<Locus::Triangle3D_t> cutTriangles;
+
+      std::size_t numFaces = half.NumFaces();
+
+      for (std::size_t faceIndex = 0; faceIndex < numFaces; ++faceIndex)
+      {
+         Locus::Triangle3D_t triangle = half.GetFaceTriangle(faceIndex, Locus::Transformation::Identity());
+
+         if (DistanceInFront(triangle, cutNormal, cutDistance) <= 2.0f * tolerance)
+         {
+            cutTriangles.push_back(triangle);
+         }
+      }
+
+      BuildFromSplit(parent, parentToHalf, cutNormal, cutDistance, tolerance, cutTriangles, maxDepth);
+   }
+
+   std::size_t NumTriangles() const;
+
+   //the triangle at index (as returned by the queries) in model space
+   Locus::Triangle3D_t GetTriangle(std::size_t index) const;
+
+   //finds a pair of intersecting triangles between this tree in thisFrame and other in
+   //otherFrame, and returns them in world space. other is brought into this tree's model
+   //space as it is traversed. The query stops at the first pair it finds, so when several
+   //pairs intersect which one is returned depends on the order of the trees' triangles.
+   //Uses scratch.nodePairStack and scratch.triangleCandidates
+   bool GetIntersection(const ModelFrame& thisFrame, const TriangleTree& other, const ModelFrame& otherFrame,
+                        NarrowphaseScratch& scratch, Locus::Triangle3D_t& thisTriangle, Locus::Triangle3D_t& otherTriangle) const;
+
+   //casts a sphere of the radius along the segment from start to end (in world space, a capsule
+   //in all) against the tree in frame, which has to scale evenly. Returns the index of the first
+   //triangle the sphere touches and how far along the segment, from 0 at start to 1 at end, it
+   //touches it. With a radius of 0 the segment is cast as a ray. Uses scratch.nodeStack and
+   //scratch.triangleCandidates
+   bool GetFirstHit(const ModelFrame& frame, const Locus::FVector3& start, const Locus::FVector3& end, float radius,
+                    NarrowphaseScratch& scratch, std::size_t& hitTriangle, float& hitFraction) const;
+
+private:
+   struct Node
+   {
+      Locus::FVector3 center;
+      float radius;
+
+      std::uint32_t firstChild;
+      std::uint32_t firstTriangle;
+      std::uint32_t numTriangles;
+
+      bool IsLeaf() const;
+   };
+
+   //a subtree of the tree being built from a split: either one of parent's nodes, kept
+   //whole, or (with Rebuilt_Node) the triangles near the cut
+   struct SplitPiece
+   {
+      static const std::uint32_t Rebuilt_Node = 0xFFFFFFFF;
+
+      Locus::FVector3 center;
+      float radius;
+
+      std::uint32_t parentNode;
+   };
+
+   void Build(std::vector<Locus::Triangle3D_t>& triangles, unsigned int maxDepth);
+   void BuildNode(std::vector<Locus::Triangle3D_t>& triangles, std::size_t nodeIndex, std::size_t firstTriangle, std::size_t numTriangles, unsigned int depthLeft);
+
+   void BuildFromSplit(const TriangleTree& parent, const ModelFrame& parentToHalf, const Locus::FVector3& cutNormal, float cutDistance,
+                       float tolerance, std::vector<Locus::Triangle3D_t>& cutTriangles, unsigned int maxDepth);
+
+   void BuildOverPieces(std::vector<SplitPiece>& pieces, std::size_t firstPiece, std::size_t numPieces, std::size_t nodeIndex,
+                        const TriangleTree& parent, const ModelFrame& parentToHalf, std::vector<Locus::Triangle3D_t>& cutTriangles,
+                        std::vector<Locus::Triangle3D_t>& triangles, unsigned int maxDepth);
+
+   void CopySubtree(const TriangleTree& parent, std::size_t parentNode, const ModelFrame& parentToHalf, float scale,
+                    std::size_t nodeIndex, std::vector<Locus::Triangle3D_t>& triangles);
+
+   void StoreTriangles(const std::vector<Locus::Triangle3D_t>& triangles);
+
+   //fills scratch.triangleCandidates with the indices of the numTriangles triangles from
+   //firstTriangle on whose bounding boxes overlap the box from minPoint to maxPoint, in
+   //order. It reads the coordinate arrays directly, a leaf at a time, so only the
+   //candidates are gathered into triangles for the exact tests
+   void FindBoxCandidates(std::uint32_t firstTriangle, std::uint32_t numTriangles, const Locus::FVector3& minPoint, const Locus::FVector3& maxPoint,
+                          NarrowphaseScratch& scratch) const;
+
+   //how close to a cut a point has to be to count as on it
+   static float CutTolerance(const TriangleTree& parent, const ModelFrame& parentToHalf);
+
+   //how far the triangle's point nearest the back of the cut is in front of it
+   static float DistanceInFront(const Locus::Triangle3D_t& triangle, const Locus::FVector3& cutNormal, float cutDistance);
+
+   //the triangles in model space, reordered so that every node's triangles are contiguous
+   //and stored coordinate by coordinate: point p of triangle t is
+   //(pointsX[p][t], pointsY[p][t], pointsZ[p][t])
+   std::vector<float> pointsX[Locus::Triangle3D_t::NumPointsOnATriangle];
+   std::vector<float> pointsY[Locus::Triangle3D_t::NumPointsOnATriangle];
+   std::vector<float> pointsZ[Locus::Triangle3D_t::NumPointsOnATriangle];
+
+   //the root is nodes[0]. The children of a node are next to each other
+   std::vector<Node> nodes;
+};
+
+//true if the two triangles share a point
+bool TrianglesIntersect(const Locus::Triangle3D_t& triangle1, const Locus::Triangle3D_t& triangle2);
+
+}
\ No newline at end of file
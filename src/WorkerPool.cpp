@@ -0,0 +1,209 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+namespace MPM
+{
+
+WorkerPool::WorkerPool(unsigned int numThreads)
+   : job(nullptr), jobCount(0), jobChunkSize(1), nextChunk(0), numBusyWorkers(0), generation(0), stopping(false), numRunningBackgroundTasks(0)
+{
+   if (numThreads == 0)
+   {
+      numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+   }
+
+   workers.reserve(numThreads - 1);
+
+   for (unsigned int workerIndex = 1; workerIndex < numThreads; ++workerIndex)
+   {
+      workers.emplace_back(&WorkerPool::WorkerLoop, this);
+   }
+}
+
+WorkerPool::~WorkerPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+
+   workAvailable.notify_all();
+
+   for (std::thread& worker : workers)
+   {
+      worker.join();
+   }
+}
+
+unsigned int WorkerPool::NumThreads() const
+{
+   return static_cast<unsigned int>(workers.size() + 1);
+}
+
+void WorkerPool::ParallelFor(std::size_t count, std::size_t chunkSize, const RangeFunction& function)
+{
+   if (chunkSize == 0)
+   {
+      chunkSize = 1;
+   }
+
+   if (workers.empty() || (count <= chunkSize))
+   {
+      for (std::size_t begin = 0; begin < count; begin += chunkSize)
+      {
+         function(begin, std::min(begin + chunkSize, count));
+      }
+
+      return;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      job = &function;
+      jobCount = count;
+      jobChunkSize = chunkSize;
+      nextChunk = 0;
+
+      //workers join as they come free; one busy with a background task may not join at all
+      ++generation;
+   }
+
+   workAvailable.notify_all();
+
+   RunChunks();
+
+   std::unique_lock<std::mutex> lock(mutex);
+   workFinished.wait(lock, [this]{ return (numBusyWorkers == 0); });
+
+   job = nullptr;
+}
+
+void WorkerPool::RunInBackground(const Task& task)
+{
+   if (workers.empty())
+   {
+      task();
+      return;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      backgroundTasks.push_back(task);
+   }
+
+   workAvailable.notify_one();
+}
+
+void WorkerPool::WaitForBackgroundTasks()
+{
+   std::unique_lock<std::mutex> lock(mutex);
+
+   while (!backgroundTasks.empty() || (numRunningBackgroundTasks > 0))
+   {
+      if (backgroundTasks.empty())
+      {
+         backgroundTasksFinished.wait(lock);
+      }
+      else
+      {
+         Task task = std::move(backgroundTasks.front());
+         backgroundTasks.pop_front();
+
+         ++numRunningBackgroundTasks;
+         lock.unlock();
+
+         task();
+
+         lock.lock();
+         --numRunningBackgroundTasks;
+      }
+   }
+}
+
+void WorkerPool::RunChunks()
+{
+   for (;;)
+   {
+      std::size_t begin = (nextChunk++) * jobChunkSize;
+
+      if (begin >= jobCount)
+      {
+         break;
+      }
+
+      (*job)(begin, std::min(begin + jobChunkSize, jobCount));
+   }
+}
+
+void WorkerPool::WorkerLoop()
+{
+   unsigned long long lastGeneration = 0;
+
+   for (;;)
+   {
+      Task task;
+
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         workAvailable.wait(lock, [&]{ return stopping || ((job != nullptr) && (generation != lastGeneration)) || !backgroundTasks.empty(); });
+
+         if (stopping)
+         {
+            return;
+         }
+
+         //loops come first, since the thread that started one is waiting on it
+         if ((job != nullptr) && (generation != lastGeneration))
+         {
+            lastGeneration = generation;
+            ++numBusyWorkers;
+         }
+         else
+         {
+            task = std::move(backgroundTasks.front());
+            backgroundTasks.pop_front();
+
+            ++numRunningBackgroundTasks;
+         }
+      }
+
+      if (task)
+      {
+         task();
+
+         std::lock_guard<std::mutex> lock(mutex);
+
+         if (--numRunningBackgroundTasks == 0)
+         {
+            backgroundTasksFinished.notify_all();
+         }
+
+         continue;
+      }
+
+      RunChunks();
+
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+
+         if (--numBusyWorkers == 0)
+         {
+            workFinished.notify_one();
+         }
+      }
+   }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+/********************************************************************************************************\
+*                                                                                                        *
+*   This file is part of Minor Planet Mayhem                                                             *
+*                                                                                                        *
+*   Copyright (c) 2014 Shachar Avni. All rights reserved.                                                *
+*                                                                                                        *
+*   Use of this file is governed by a BSD-style license. See the accompanying LICENSE.txt for details    *
+*                                                                                                        *
+\********************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+
+namespace MPM
+{
+
+//A fixed set of threads that split loops over independent elements between them.
+//The calling thread takes part in the work, so a pool of one thread runs
+//everything inline. Between loops the threads also run tasks queued to the
+//background, which a loop never waits on
+class WorkerPool
+{
+public:
+   typedef std::function<void(std::size_t begin, std::size_t end)> RangeFunction;
+   typedef std::function<void()> Task;
+
+   //numThreads counts the calling thread. 0 uses one thread per hardware thread
+   WorkerPool(unsigned int numThreads);
+   ~WorkerPool();
+
+   WorkerPool(const WorkerPool&) = delete;
+   WorkerPool& operator=(const WorkerPool&) = delete;
+
+   unsigned int NumThreads() const;
+
+   //calls function on the ranges [0, chunkSize), [chunkSize, 2 * chunkSize), ... covering
+   //[0, count) and returns once all of them are done. Ranges always begin at a multiple
+   //of chunkSize no matter how many threads there are, so the work done for an element
+   //only depends on the number of threads if function makes it so
+   void ParallelFor(std::size_t count, std::size_t chunkSize, const RangeFunction& function);
+
+   //queues task to run on whichever thread frees up first. A pool of one thread runs
+   //it right away. Tasks still queued when the pool is destroyed never run, so whoever
+   //queues them waits for them first
+   void RunInBackground(const Task& task);
+
+   //returns once every task queued so far has run, running queued ones on the calling
+   //thread rather than sitting idle
+   void WaitForBackgroundTasks();
+
+private:
+   std::vector<std::thread> workers;
+
+   std::mutex mutex;
+   std::condition_variable workAvailable;
+   std::condition_variable workFinished;
+
+   const RangeFunction* job;
+   std::size_t jobCount;
+   std::size_t jobChunkSize;
+   std::atomic<std::size_t> nextChunk;
+
+   std::size_t numBusyWorkers;
+   unsigned long long generation;
+   bool stopping;
+
+   std::deque<Task> backgroundTasks;
+   std::size_t numRunningBackgroundTasks;
+   std::condition_variable backgroundTasksFinished;
+
+   void WorkerLoop();
+   void RunChunks();
+};
+
+}
\ No newline at end of file